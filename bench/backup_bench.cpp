@@ -0,0 +1,122 @@
+// bench/backup_bench.cpp
+#include "bench_util.h"
+
+#include <duplivault/BackupOrchestrator.h>
+#include <duplivault/Chunker.h>
+#include <duplivault/Hasher.h>
+#include <duplivault/StorageRepository.h>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr size_t TREE_SIZE = 64 * 1024 * 1024;
+
+unsigned default_jobs() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Backs 'source' up into 'repo_dir', quietly.
+// @return The number of chunks the files were cut into.
+uint64_t backup(const std::filesystem::path& source, const std::filesystem::path& repo_dir, unsigned jobs) {
+    dv::StorageRepository repo(repo_dir);
+    repo.init();
+    const dv::Hasher hasher;
+    const dv::Chunker chunker(repo.chunking_engine());
+    dv::OrchestratorOptions options;
+    options.jobs = jobs;
+    options.verbosity = 0;
+    dv::BackupOrchestrator orchestrator(chunker, hasher, repo, options);
+    orchestrator.run_backup(source);
+    return orchestrator.metrics().get(dv::Counter::Chunks);
+}
+
+// Argument: jobs. A first backup of the whole tree into an empty repository.
+void BM_BackupTree(benchmark::State& state) {
+    const auto jobs = static_cast<unsigned>(state.range(0));
+    dv::bench::TempDir dir("backup");
+    dv::bench::make_tree(dir.path() / "source", TREE_SIZE);
+    uint64_t chunks = 0;
+    dv::bench::AllocationMeter allocated;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove_all(dir.path() / "repo");
+        state.ResumeTiming();
+        allocated.start();
+        chunks += backup(dir.path() / "source", dir.path() / "repo", jobs);
+        allocated.stop();
+    }
+    dv::bench::report(state, state.iterations() * TREE_SIZE, chunks, allocated);
+}
+
+// Argument: jobs. A backup after a few small edits to every tenth file, on
+// top of a backup of the unedited tree. The edited files are read again;
+// only the chunks around the edits are new.
+void BM_BackupAfterEdits(benchmark::State& state) {
+    const auto jobs = static_cast<unsigned>(state.range(0));
+    dv::bench::TempDir dir("edits");
+    const auto source = dir.path() / "source";
+    const auto files = dv::bench::make_tree(source, TREE_SIZE);
+    std::vector<std::vector<std::byte>> originals;
+    for (size_t f = 0; f < files.size(); f += 10) originals.push_back(dv::bench::read_file(files[f]));
+
+    uint64_t edited_bytes = 0;
+    uint64_t chunks = 0;
+    dv::bench::AllocationMeter allocated;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove_all(dir.path() / "repo");
+        for (size_t f = 0, i = 0; f < files.size(); f += 10, ++i) dv::bench::write_file(files[f], originals[i]);
+        backup(source, dir.path() / "repo", jobs);
+        for (size_t f = 0, i = 0; f < files.size(); f += 10, ++i) {
+            auto data = originals[i];
+            dv::bench::apply_edits(data, 4, static_cast<unsigned>(f));
+            dv::bench::write_file(files[f], data);
+            edited_bytes += data.size();
+        }
+        state.ResumeTiming();
+        allocated.start();
+        chunks += backup(source, dir.path() / "repo", jobs);
+        allocated.stop();
+    }
+    // Freshly written files are racy, so every file is read again: the
+    // throughput is over the whole tree.
+    dv::bench::report(state, state.iterations() * TREE_SIZE, chunks, allocated);
+    state.counters["edited_bytes"] =
+        benchmark::Counter(static_cast<double>(edited_bytes), benchmark::Counter::kAvgIterations, benchmark::Counter::kIs1024);
+}
+
+// Restores the whole tree from one backup into an empty directory.
+void BM_RestoreTree(benchmark::State& state) {
+    dv::bench::TempDir dir("restore");
+    dv::bench::make_tree(dir.path() / "source", TREE_SIZE);
+    backup(dir.path() / "source", dir.path() / "repo", default_jobs());
+
+    dv::StorageRepository repo(dir.path() / "repo");
+    const dv::Hasher hasher;
+    const dv::Chunker chunker(repo.chunking_engine());
+    dv::OrchestratorOptions options;
+    options.verbosity = 0;
+    dv::BackupOrchestrator orchestrator(chunker, hasher, repo, options);
+    const std::string snapshot = repo.list_snapshots().back().id;
+
+    dv::bench::AllocationMeter allocated;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove_all(dir.path() / "out");
+        state.ResumeTiming();
+        allocated.start();
+        orchestrator.run_restore_snapshot(snapshot, dir.path() / "out");
+        allocated.stop();
+    }
+    dv::bench::report(state, state.iterations() * TREE_SIZE, 0, allocated);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_BackupTree)->Apply([](benchmark::internal::Benchmark* b) {
+    b->Arg(1);
+    if (default_jobs() > 1) b->Arg(default_jobs());
+})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BackupAfterEdits)->Arg(default_jobs())->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_RestoreTree)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,143 @@
+// bench/bench_util.cpp
+#include "bench_util.h"
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace dv::bench {
+
+const char* to_string(Corpus corpus) {
+    switch (corpus) {
+    case Corpus::Random: return "random";
+    case Corpus::Zeros: return "zeros";
+    case Corpus::Text: return "text";
+    }
+    return "unknown";
+}
+
+std::vector<std::byte> make_corpus(Corpus corpus, size_t size, unsigned seed) {
+    std::vector<std::byte> data;
+    data.reserve(size);
+    std::mt19937_64 rng(seed);
+    switch (corpus) {
+    case Corpus::Random:
+        while (data.size() < size) {
+            const uint64_t word = rng();
+            for (int i = 0; i < 8 && data.size() < size; ++i) {
+                data.push_back(static_cast<std::byte>(word >> (8 * i)));
+            }
+        }
+        break;
+    case Corpus::Zeros:
+        data.resize(size);
+        break;
+    case Corpus::Text: {
+        static const char* const levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+        static const char* const words[] = {"request", "served",  "user",    "session", "cache",  "miss",
+                                            "hit",     "backend", "timeout", "retry",   "commit", "query",
+                                            "rows",    "latency", "token",   "upload",  "chunk",  "index"};
+        std::string line;
+        for (uint64_t n = 0; data.size() < size; ++n) {
+            line = "2026-10-16T12:" + std::to_string(n / 60 % 60) + ":" + std::to_string(n % 60) + " " +
+                   levels[rng() % 6] + " worker-" + std::to_string(rng() % 16) + ":";
+            for (int w = 0, count = 3 + static_cast<int>(rng() % 8); w < count; ++w) {
+                line += ' ';
+                line += words[rng() % (sizeof(words) / sizeof(words[0]))];
+            }
+            line += " id=" + std::to_string(rng() % 100000) + "\n";
+            for (char c : line) {
+                if (data.size() == size) break;
+                data.push_back(static_cast<std::byte>(c));
+            }
+        }
+        break;
+    }
+    }
+    return data;
+}
+
+void apply_edits(std::vector<std::byte>& data, size_t edits, unsigned seed) {
+    if (data.empty() || edits == 0) return;
+    std::mt19937 rng(seed);
+    const size_t stride = data.size() / edits;
+    for (size_t e = 0; e < edits; ++e) {
+        const size_t at = e * stride + rng() % std::max<size_t>(stride, 1);
+        for (size_t i = at; i < std::min(at + 16, data.size()); ++i) {
+            data[i] = static_cast<std::byte>(rng());
+        }
+    }
+}
+
+void write_file(const std::filesystem::path& path, const std::vector<std::byte>& data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!out) throw std::runtime_error("Cannot write " + path.string());
+}
+
+std::vector<std::byte> read_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const auto* begin = reinterpret_cast<const std::byte*>(bytes.data());
+    return std::vector<std::byte>(begin, begin + bytes.size());
+}
+
+std::vector<std::filesystem::path> make_tree(const std::filesystem::path& root, size_t total_bytes, unsigned seed) {
+    // A mix of sizes, from a few KB to a few MB, cycling through corpora.
+    static const size_t sizes[] = {4 * 1024, 60 * 1024, 300 * 1024, 1024 * 1024, 3 * 1024 * 1024};
+    static const Corpus corpora[] = {Corpus::Text, Corpus::Random, Corpus::Text, Corpus::Zeros};
+    std::vector<std::filesystem::path> files;
+    size_t written = 0;
+    for (unsigned n = 0; written < total_bytes; ++n) {
+        const auto dir = root / ("dir" + std::to_string(n % 8)) / ("sub" + std::to_string(n % 3));
+        std::filesystem::create_directories(dir);
+        const size_t size = std::min(sizes[n % 5], total_bytes - written);
+        const auto path = dir / ("file" + std::to_string(n) + ".dat");
+        write_file(path, make_corpus(corpora[n % 4], size, seed + n));
+        files.push_back(path);
+        written += size;
+    }
+    return files;
+}
+
+TempDir::TempDir(const char* name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    path_ = std::filesystem::temp_directory_path() / "DupliVaultBench" / (std::string(name) + "-" + std::to_string(stamp));
+    std::filesystem::create_directories(path_);
+}
+
+TempDir::~TempDir() {
+    std::error_code ignored;
+    std::filesystem::remove_all(path_, ignored);
+}
+
+namespace {
+
+void report_allocated(benchmark::State& state, uint64_t bytes, uint64_t chunks, const AllocationCount& allocated) {
+    const auto allocs = static_cast<double>(allocated.count);
+    if (bytes > 0) state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    if (chunks > 0) {
+        state.counters["chunks/s"] = benchmark::Counter(static_cast<double>(chunks), benchmark::Counter::kIsRate);
+        state.counters["allocs/chunk"] = allocs / static_cast<double>(chunks);
+    }
+    state.counters["allocs"] = benchmark::Counter(allocs, benchmark::Counter::kAvgIterations);
+    state.counters["alloc_bytes"] = benchmark::Counter(static_cast<double>(allocated.bytes),
+                                                       benchmark::Counter::kAvgIterations,
+                                                       benchmark::Counter::kIs1024);
+}
+
+} // anonymous namespace
+
+void report(benchmark::State& state, uint64_t bytes, uint64_t chunks, const AllocationCount& since) {
+    const AllocationCount now = allocations();
+    report_allocated(state, bytes, chunks, {now.count - since.count, now.bytes - since.bytes});
+}
+
+void report(benchmark::State& state, uint64_t bytes, uint64_t chunks, const AllocationMeter& meter) {
+    report_allocated(state, bytes, chunks, meter.total());
+}
+
+} // namespace dv::bench
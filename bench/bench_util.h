@@ -0,0 +1,96 @@
+// bench/bench_util.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace dv::bench {
+
+// Synthetic inputs, chosen to hit the engines' best and worst cases.
+enum class Corpus {
+    Random, // Incompressible, boundaries where the hash says.
+    Zeros,  // No boundaries but forced ones; maximally compressible.
+    Text,   // Log-like lines: typical boundaries, compresses well.
+};
+
+const char* to_string(Corpus corpus);
+
+std::vector<std::byte> make_corpus(Corpus corpus, size_t size, unsigned seed = 1);
+
+/**
+ * @brief Overwrites 'edits' short runs of bytes spread evenly over
+ *        'data', as a file that changed a little since its last backup.
+ */
+void apply_edits(std::vector<std::byte>& data, size_t edits, unsigned seed);
+
+/**
+ * @brief Fills 'root' with a tree of files of the three corpora, of
+ *        'total_bytes' in all, in a few levels of directories.
+ * @return The paths of the files written.
+ */
+std::vector<std::filesystem::path> make_tree(const std::filesystem::path& root, size_t total_bytes, unsigned seed = 1);
+
+void write_file(const std::filesystem::path& path, const std::vector<std::byte>& data);
+std::vector<std::byte> read_file(const std::filesystem::path& path);
+
+// A fresh directory under the system's temporary one, removed again with
+// everything in it when the object goes.
+class TempDir {
+public:
+    explicit TempDir(const char* name);
+    ~TempDir();
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Heap allocations made by the whole process since it started, counted by
+// the replaced global operator new (see alloc_counter.cpp).
+struct AllocationCount {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+};
+
+AllocationCount allocations();
+
+// Sums the allocations made between start() and stop() calls, for
+// benchmarks that pause timing for setup: only the timed region counts.
+class AllocationMeter {
+public:
+    void start() { started_ = allocations(); }
+    void stop() {
+        const AllocationCount now = allocations();
+        total_.count += now.count - started_.count;
+        total_.bytes += now.bytes - started_.bytes;
+    }
+    const AllocationCount& total() const { return total_; }
+
+private:
+    AllocationCount started_;
+    AllocationCount total_;
+};
+
+/**
+ * @brief Sets the throughput and allocation counters of a benchmark run
+ *        from totals over all of its iterations: "allocs" and
+ *        "alloc_bytes" per iteration, plus "bytes_per_second" when bytes
+ *        were counted and "chunks/s" and "allocs/chunk" when chunks were.
+ * @param since allocations() taken before the first iteration.
+ */
+void report(benchmark::State& state, uint64_t bytes, uint64_t chunks, const AllocationCount& since);
+
+/**
+ * @brief As above, with the allocations 'meter' counted instead of all of
+ *        those since a point in time.
+ */
+void report(benchmark::State& state, uint64_t bytes, uint64_t chunks, const AllocationMeter& meter);
+
+} // namespace dv::bench
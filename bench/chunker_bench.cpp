@@ -0,0 +1,89 @@
+// bench/chunker_bench.cpp
+#include "bench_util.h"
+
+#include <duplivault/Chunker.h>
+#include <duplivault/ThreadPool.h>
+#include <istream>
+#include <streambuf>
+#include <thread>
+
+namespace {
+
+using dv::bench::Corpus;
+
+constexpr size_t CORPUS_SIZE = 16 * 1024 * 1024;
+
+// An istream over memory the benchmark already holds, so that the stream
+// benchmark measures the chunker's copying rather than a stringstream's.
+class MemoryBuffer : public std::streambuf {
+public:
+    MemoryBuffer(const std::byte* data, size_t size) {
+        char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+        setg(begin, begin, begin + size);
+    }
+};
+
+const std::vector<std::byte>& corpus(Corpus which) {
+    static const std::vector<std::byte> corpora[] = {dv::bench::make_corpus(Corpus::Random, CORPUS_SIZE),
+                                                     dv::bench::make_corpus(Corpus::Zeros, CORPUS_SIZE),
+                                                     dv::bench::make_corpus(Corpus::Text, CORPUS_SIZE)};
+    return corpora[static_cast<size_t>(which)];
+}
+
+// Arguments: engine, corpus.
+void set_label(benchmark::State& state) {
+    state.SetLabel(std::string(dv::to_string(static_cast<dv::ChunkingEngine>(state.range(0)))) + "/" +
+                   dv::bench::to_string(static_cast<Corpus>(state.range(1))));
+}
+
+void BM_ChunkBuffer(benchmark::State& state) {
+    const dv::Chunker chunker(static_cast<dv::ChunkingEngine>(state.range(0)));
+    const auto& data = corpus(static_cast<Corpus>(state.range(1)));
+    uint64_t chunks = 0;
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        chunker.for_each_chunk(data.data(), data.size(), [&](dv::ByteSpan chunk) {
+            benchmark::DoNotOptimize(chunk.data);
+            ++chunks;
+        });
+    }
+    dv::bench::report(state, state.iterations() * data.size(), chunks, since);
+    set_label(state);
+}
+
+void BM_ChunkStream(benchmark::State& state) {
+    const dv::Chunker chunker(static_cast<dv::ChunkingEngine>(state.range(0)));
+    const auto& data = corpus(static_cast<Corpus>(state.range(1)));
+    uint64_t chunks = 0;
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        MemoryBuffer buffer(data.data(), data.size());
+        std::istream stream(&buffer);
+        chunker.chunk(stream, [&](dv::ByteSpan chunk) {
+            benchmark::DoNotOptimize(chunk.data);
+            ++chunks;
+        });
+    }
+    dv::bench::report(state, state.iterations() * data.size(), chunks, since);
+    set_label(state);
+}
+
+void BM_ChunkParallel(benchmark::State& state) {
+    const dv::Chunker chunker(static_cast<dv::ChunkingEngine>(state.range(0)));
+    const auto& data = corpus(static_cast<Corpus>(state.range(1)));
+    dv::ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    uint64_t chunks = 0;
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        chunker.chunk(data.data(), data.size(), pool,
+                      [&](const std::byte*, const std::vector<dv::ChunkBoundary>& batch) { chunks += batch.size(); });
+    }
+    dv::bench::report(state, state.iterations() * data.size(), chunks, since);
+    set_label(state);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_ChunkBuffer)->ArgsProduct({{0, 1}, {0, 1, 2}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChunkStream)->ArgsProduct({{0, 1}, {0, 1, 2}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChunkParallel)->ArgsProduct({{0, 1}, {0, 2}})->Unit(benchmark::kMillisecond)->UseRealTime();
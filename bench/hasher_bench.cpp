@@ -0,0 +1,136 @@
+// bench/hasher_bench.cpp
+#include "bench_util.h"
+
+#include <duplivault/Chunker.h>
+#include <duplivault/Compression.h>
+#include <duplivault/Hasher.h>
+#include <string_view>
+
+namespace {
+
+using dv::bench::Corpus;
+
+constexpr size_t CORPUS_SIZE = 8 * 1024 * 1024;
+
+// The corpus cut into average-sized chunks, as the hasher sees it.
+std::vector<dv::ByteSpan> average_chunks(const std::vector<std::byte>& data) {
+    std::vector<dv::ByteSpan> chunks;
+    for (size_t at = 0; at < data.size(); at += dv::Chunker::AVG_CHUNK_SIZE) {
+        chunks.emplace_back(data.data() + at, std::min(dv::Chunker::AVG_CHUNK_SIZE, data.size() - at));
+    }
+    return chunks;
+}
+
+const char* backend_name(dv::HashBackend backend) {
+    switch (backend) {
+    case dv::HashBackend::Auto: return "auto";
+    case dv::HashBackend::Scalar: return "scalar";
+    case dv::HashBackend::ShaNi: return "sha-ni";
+    case dv::HashBackend::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+// Argument: backend.
+void BM_HashChunks(benchmark::State& state) {
+    const auto backend = static_cast<dv::HashBackend>(state.range(0));
+    state.SetLabel(backend_name(backend));
+    if (!dv::Hasher::is_supported(backend)) {
+        state.SkipWithError("Not supported on this CPU");
+        return;
+    }
+    const dv::Hasher hasher(backend);
+    const auto data = dv::bench::make_corpus(Corpus::Random, CORPUS_SIZE);
+    const auto chunks = average_chunks(data);
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        for (const auto& chunk : chunks) {
+            benchmark::DoNotOptimize(hasher.compute(chunk.data, chunk.size));
+        }
+    }
+    dv::bench::report(state, state.iterations() * data.size(), state.iterations() * chunks.size(), since);
+}
+
+// Argument: backend. Groups of 64, as the backup's parallel path hashes.
+void BM_HashMany(benchmark::State& state) {
+    const auto backend = static_cast<dv::HashBackend>(state.range(0));
+    state.SetLabel(backend_name(backend));
+    if (!dv::Hasher::is_supported(backend)) {
+        state.SkipWithError("Not supported on this CPU");
+        return;
+    }
+    const dv::Hasher hasher(backend);
+    const auto data = dv::bench::make_corpus(Corpus::Random, CORPUS_SIZE);
+    const auto chunks = average_chunks(data);
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        for (size_t first = 0; first < chunks.size(); first += 64) {
+            const std::vector<dv::ByteSpan> group(chunks.begin() + first,
+                                                  chunks.begin() + std::min(first + 64, chunks.size()));
+            benchmark::DoNotOptimize(hasher.compute_many(group));
+        }
+    }
+    dv::bench::report(state, state.iterations() * data.size(), state.iterations() * chunks.size(), since);
+}
+
+// The one-shot helper that returns hex text.
+void BM_Sha256Hex(benchmark::State& state) {
+    const auto data = dv::bench::make_corpus(Corpus::Random, static_cast<size_t>(state.range(0)));
+    const std::string_view text(reinterpret_cast<const char*>(data.data()), data.size());
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sha256(text));
+    }
+    dv::bench::report(state, state.iterations() * data.size(), 0, since);
+}
+
+// Argument: corpus.
+void BM_Compress(benchmark::State& state) {
+    const auto which = static_cast<Corpus>(state.range(0));
+    state.SetLabel(dv::bench::to_string(which));
+    const auto data = dv::bench::make_corpus(which, CORPUS_SIZE);
+    const auto chunks = average_chunks(data);
+    dv::Chunk out;
+    uint64_t stored = 0;
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        for (const auto& chunk : chunks) {
+            stored += dv::compress_chunk(chunk, out) == dv::ChunkCodec::Lz ? out.size() : chunk.size;
+        }
+    }
+    dv::bench::report(state, state.iterations() * data.size(), state.iterations() * chunks.size(), since);
+    state.counters["ratio"] = static_cast<double>(state.iterations() * data.size()) / static_cast<double>(stored);
+}
+
+// Argument: corpus (one that compresses).
+void BM_Decompress(benchmark::State& state) {
+    const auto which = static_cast<Corpus>(state.range(0));
+    state.SetLabel(dv::bench::to_string(which));
+    const auto data = dv::bench::make_corpus(which, CORPUS_SIZE);
+    std::vector<dv::Chunk> stored;
+    for (const auto& chunk : average_chunks(data)) {
+        stored.emplace_back();
+        if (dv::compress_chunk(chunk, stored.back()) != dv::ChunkCodec::Lz) {
+            state.SkipWithError("Corpus does not compress");
+            return;
+        }
+    }
+    dv::Chunk out(dv::Chunker::AVG_CHUNK_SIZE);
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        for (const auto& chunk : stored) {
+            const size_t size = *dv::raw_size_of(dv::ChunkCodec::Lz, chunk);
+            benchmark::DoNotOptimize(dv::decompress_chunk(dv::ChunkCodec::Lz, chunk, out.data(), size));
+        }
+    }
+    dv::bench::report(state, state.iterations() * data.size(), state.iterations() * stored.size(), since);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_HashChunks)->DenseRange(1, 3)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_HashMany)->DenseRange(1, 3)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Sha256Hex)->Arg(64)->Arg(8 * 1024)->Arg(1024 * 1024);
+BENCHMARK(BM_Compress)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Decompress)->Arg(static_cast<int>(Corpus::Zeros))->Arg(static_cast<int>(Corpus::Text))
+    ->Unit(benchmark::kMillisecond);
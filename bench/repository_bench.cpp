@@ -0,0 +1,115 @@
+// bench/repository_bench.cpp
+#include "bench_util.h"
+
+#include <duplivault/Hasher.h>
+#include <duplivault/StorageRepository.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+
+namespace {
+
+using dv::bench::Corpus;
+
+constexpr size_t CHUNK_COUNT = 4096;
+
+struct Chunks {
+    std::vector<std::byte> data;
+    std::vector<dv::ByteSpan> spans;
+    std::vector<dv::Digest> hashes;
+};
+
+// CHUNK_COUNT distinct average-sized chunks of a corpus.
+Chunks make_chunks(Corpus corpus, unsigned seed) {
+    Chunks chunks;
+    chunks.data = dv::bench::make_corpus(corpus, CHUNK_COUNT * dv::Chunker::AVG_CHUNK_SIZE, seed);
+    const dv::Hasher hasher;
+    for (size_t i = 0; i < CHUNK_COUNT; ++i) {
+        std::byte* chunk = chunks.data.data() + i * dv::Chunker::AVG_CHUNK_SIZE;
+        std::memcpy(chunk, &i, sizeof(i)); // Distinct even for zeros.
+        chunks.spans.emplace_back(chunk, dv::Chunker::AVG_CHUNK_SIZE);
+        chunks.hashes.push_back(hasher.compute(chunk, dv::Chunker::AVG_CHUNK_SIZE));
+    }
+    return chunks;
+}
+
+// Argument: corpus. Each iteration fills a new repository.
+void BM_StoreChunk(benchmark::State& state) {
+    const auto which = static_cast<Corpus>(state.range(0));
+    state.SetLabel(dv::bench::to_string(which));
+    const Chunks chunks = make_chunks(which, 1);
+    dv::bench::TempDir dir("store");
+    uint64_t bytes = 0;
+    dv::bench::AllocationMeter allocated;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::filesystem::remove_all(dir.path() / "repo");
+        auto repo = std::make_unique<dv::StorageRepository>(dir.path() / "repo");
+        repo->init();
+        state.ResumeTiming();
+        allocated.start();
+        for (size_t i = 0; i < CHUNK_COUNT; ++i) {
+            repo->store_chunk(chunks.hashes[i], chunks.spans[i]);
+        }
+        repo->flush();
+        allocated.stop();
+        bytes += chunks.data.size();
+        state.PauseTiming();
+        repo.reset();
+        state.ResumeTiming();
+    }
+    dv::bench::report(state, bytes, state.iterations() * CHUNK_COUNT, allocated);
+}
+
+// Argument: corpus. Reads every chunk once, in random order.
+void BM_RetrieveChunk(benchmark::State& state) {
+    const auto which = static_cast<Corpus>(state.range(0));
+    state.SetLabel(dv::bench::to_string(which));
+    Chunks chunks = make_chunks(which, 2);
+    dv::bench::TempDir dir("retrieve");
+    dv::StorageRepository repo(dir.path() / "repo");
+    repo.init();
+    for (size_t i = 0; i < CHUNK_COUNT; ++i) {
+        repo.store_chunk(chunks.hashes[i], chunks.spans[i]);
+    }
+    repo.flush();
+    std::shuffle(chunks.hashes.begin(), chunks.hashes.end(), std::mt19937(3));
+
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        for (const auto& hash : chunks.hashes) {
+            benchmark::DoNotOptimize(repo.retrieve_chunk(hash));
+        }
+    }
+    dv::bench::report(state, state.iterations() * chunks.data.size(), state.iterations() * CHUNK_COUNT, since);
+}
+
+// Argument: 1 to look up stored chunks, 0 for new ones.
+void BM_ChunkExists(benchmark::State& state) {
+    const bool stored = state.range(0) != 0;
+    state.SetLabel(stored ? "hit" : "miss");
+    const Chunks chunks = make_chunks(Corpus::Random, 4);
+    const Chunks others = make_chunks(Corpus::Random, 5);
+    dv::bench::TempDir dir("exists");
+    dv::StorageRepository repo(dir.path() / "repo");
+    repo.init();
+    for (size_t i = 0; i < CHUNK_COUNT; ++i) {
+        repo.store_chunk(chunks.hashes[i], chunks.spans[i]);
+    }
+    const auto& probes = stored ? chunks.hashes : others.hashes;
+
+    const auto since = dv::bench::allocations();
+    for (auto _ : state) {
+        for (const auto& hash : probes) {
+            benchmark::DoNotOptimize(repo.chunk_exists(hash));
+        }
+    }
+    dv::bench::report(state, 0, state.iterations() * CHUNK_COUNT, since);
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_StoreChunk)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RetrieveChunk)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ChunkExists)->Arg(1)->Arg(0)->Unit(benchmark::kMicrosecond);
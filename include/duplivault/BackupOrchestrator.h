@@ -1,8 +1,14 @@
 // include/duplivault/BackupOrchestrator.h
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <optional>
+#include <string>
+#include <vector>
+
+#include "Metrics.h"
 
 // Forward declare the classes we depend on to avoid including their full headers.
 // This is a good practice that can speed up compilation times.
@@ -10,10 +16,55 @@ namespace dv {
     class Chunker;
     class Hasher;
     class StorageRepository;
+    struct Manifest;
+    struct RestoreItem;
 }
 
 namespace dv {
 
+// Tuning knobs for a BackupOrchestrator.
+struct OrchestratorOptions {
+    // Number of worker threads that read, chunk and hash files in parallel.
+    // Directory walking and repository writes each use one more thread.
+    unsigned jobs = 1;
+
+    // Files at least this large are split across all jobs: their chunk
+    // boundaries are scanned and their chunks hashed in parallel. Only
+    // applies when jobs > 1.
+    std::uintmax_t split_file_size = 64 * 1024 * 1024;
+
+    // Treat a changed file that kept its inode and did not shrink as
+    // appended to: its earlier chunks are taken from the previous manifest
+    // and chunking resumes at the last boundary that cannot have moved, so
+    // only the new tail is read and hashed. The chunk before that boundary,
+    // the first chunk and a few sampled in between are re-read and checked;
+    // if any differs, the whole file is chunked again. Other in-place edits
+    // go unnoticed, so enable this only for files that are strictly
+    // appended to (logs, journals), never for files rewritten in place
+    // such as databases.
+    bool append_aware = false;
+
+    // Read regular files through read-only memory mappings, so they are
+    // chunked and hashed in place rather than copied into a buffer. Off by
+    // default: a mapped file that another process truncates mid-backup
+    // kills the process with SIGBUS, so enable this only for sources that
+    // are not written to while being backed up.
+    bool map_files = false;
+
+    // Compress new chunks (see compress_chunk()) on the worker threads
+    // before they are stored. Chunks that do not shrink are stored raw
+    // either way.
+    bool compress = true;
+
+    // Memory for chunks that a restore needs more than once (see
+    // ChunkCache). 0 disables the cache.
+    std::size_t restore_cache_bytes = 256 * 1024 * 1024;
+
+    // Progress on stdout: 0 prints nothing, 1 a line per file, 2 also a
+    // line per chunk. Errors go to stderr regardless.
+    unsigned verbosity = 1;
+};
+
 class BackupOrchestrator {
 public:
     /**
@@ -21,23 +72,66 @@ public:
      * @param chunker The chunker to use for splitting files.
      * @param hasher The hasher to use for fingerprinting chunks.
      * @param repo The repository where data will be stored.
+     * @param options Parallelism and other tuning knobs.
      */
-    BackupOrchestrator(const Chunker& chunker, const Hasher& hasher, StorageRepository& repo);
+    BackupOrchestrator(const Chunker& chunker, const Hasher& hasher, StorageRepository& repo,
+                       OrchestratorOptions options = {});
 
     /**
      * @brief Runs the backup process for a given source path.
-     * @param source_path The file or directory to back up.
+     *
+     * The work is a pipeline of bounded queues: one thread walks the tree,
+     * 'jobs' workers read, chunk and hash files, and one writer stores new
+     * chunks and metadata. A file's metadata is written only after all of
+     * its chunks. Once every file is stored, the backup is recorded as a
+     * snapshot, in which only the trees of directories with a new, changed
+     * or removed entry under them are built again. A changed file that cannot be read is reported on stderr
+     * and counted as Counter::FilesFailed; the snapshot keeps the version
+     * stored before, if there is one.
+     * @param source_path The directory to back up.
+     * @return The id of the new snapshot.
      */
-    void run_backup(const std::filesystem::path& source_path);
+    std::string run_backup(const std::filesystem::path& source_path);
 
+    /**
+     * @brief Restores the latest backed-up version of every file (or of
+     *        one file) into 'destination_dir', by file name.
+     *
+     * Both restores go through a RestoreEngine: chunks are read in the
+     * order they are stored and written to all files in parallel.
+     */
     void run_restore(const std::filesystem::path& destination_dir, 
                                      const std::optional<std::filesystem::path>& original_path_opt);
 
+    /**
+     * @brief Restores the files of one snapshot into 'destination_dir',
+     *        keeping their paths relative to the backed-up directory.
+     * @param snapshot_id The snapshot's id, or a unique prefix of it.
+     * @param original_path_opt If set, restore only this file.
+     * @throws std::runtime_error if there is no such snapshot.
+     */
+    void run_restore_snapshot(const std::string& snapshot_id, const std::filesystem::path& destination_dir,
+                              const std::optional<std::filesystem::path>& original_path_opt = std::nullopt);
+
+    /**
+     * @brief Counters and stage timings of every backup and restore this
+     *        orchestrator has run.
+     */
+    const Metrics& metrics() const { return metrics_; }
+
 private:
+    /**
+     * @brief Runs a RestoreEngine over 'items' with this orchestrator's
+     *        cache size, and reports how the cache did.
+     */
+    void restore_items(const std::vector<RestoreItem>& items);
+
     // References to the components we will use. We don't own them.
     const Chunker& chunker_;
     const Hasher& hasher_;
     StorageRepository& repo_;
+    OrchestratorOptions options_;
+    Metrics metrics_;
 };
 
 } // namespace dv
\ No newline at end of file
@@ -0,0 +1,78 @@
+// include/duplivault/BloomFilter.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "Digest.h"
+
+namespace dv {
+
+/**
+ * @brief A blocked Bloom filter over chunk digests.
+ *
+ * Each key sets KEY_BITS bits inside a single 512-bit block (one cache
+ * line), so a lookup costs one memory access however large the filter is.
+ * With BITS_PER_KEY bits per key the false-positive rate stays below 1%
+ * up to the filter's capacity. There are never false negatives: if
+ * may_contain() returns false, the digest was never inserted.
+ *
+ * Digests are uniformly random already, so the block and bit positions
+ * are taken straight from their bytes.
+ *
+ * File format: "DVBLM001" | byte-order mark u32 | reserved u32 |
+ * block count u64 | key count u64, then the blocks in host byte order.
+ */
+class BloomFilter {
+public:
+    static constexpr size_t BLOCK_BITS = 512;
+    static constexpr size_t KEY_BITS = 8;
+    static constexpr size_t BITS_PER_KEY = 12;
+
+    /**
+     * @brief Creates an empty filter sized for 'capacity' keys.
+     */
+    explicit BloomFilter(size_t capacity = 0);
+
+    void insert(const Digest& hash);
+
+    /**
+     * @brief False means definitely absent; true means probably present.
+     */
+    bool may_contain(const Digest& hash) const;
+
+    /**
+     * @brief Number of keys inserted.
+     */
+    size_t size() const { return keys_; }
+
+    /**
+     * @brief Keys the filter can hold at its target false-positive rate.
+     */
+    size_t capacity() const { return blocks_.size() * BLOCK_BITS / BITS_PER_KEY; }
+
+    /**
+     * @brief Replaces the filter with the one stored at 'path'.
+     * @return False (leaving the filter unchanged) if there is no usable
+     *         filter there.
+     */
+    bool load(const std::filesystem::path& path);
+
+    /**
+     * @brief Writes the filter to 'path' via a temporary file and rename.
+     * @throws std::runtime_error if it cannot be written.
+     */
+    void save(const std::filesystem::path& path) const;
+
+private:
+    struct alignas(64) Block {
+        uint64_t words[BLOCK_BITS / 64];
+    };
+
+    std::vector<Block> blocks_;
+    size_t keys_ = 0;
+};
+
+} // namespace dv
@@ -0,0 +1,85 @@
+// include/duplivault/BoundedQueue.h
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace dv {
+
+/**
+ * @brief A blocking multi-producer/multi-consumer FIFO with a fixed capacity.
+ *
+ * This connects the stages of the backup pipeline. The capacity provides
+ * back-pressure: a fast stage blocks in push() instead of buffering an
+ * unbounded amount of work in memory. Items are kept in a ring of slots
+ * allocated up front, so passing them through never allocates.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity_(capacity == 0 ? 1 : capacity), slots_(capacity_) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Adds an item, waiting while the queue is full.
+     * @return False if the queue was closed (the item is dropped).
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || count_ < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        slots_[(head_ + count_) % capacity_].emplace(std::move(item));
+        count_++;
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item, waiting while the queue is empty.
+     * @return std::nullopt once the queue is closed and drained.
+     */
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || count_ > 0; });
+        if (count_ == 0) {
+            return std::nullopt;
+        }
+        std::optional<T>& slot = slots_[head_];
+        T item = std::move(*slot);
+        slot.reset();
+        head_ = (head_ + 1) % capacity_;
+        count_--;
+        not_full_.notify_one();
+        return item;
+    }
+
+    /**
+     * @brief Signals that no more items will be pushed. Consumers drain
+     *        what is left and then see std::nullopt; producers stop.
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    std::vector<std::optional<T>> slots_;
+    size_t head_ = 0;  // Slot of the oldest item.
+    size_t count_ = 0; // Items in the ring, from head_ on (wrapping).
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+} // namespace dv
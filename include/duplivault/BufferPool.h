@@ -0,0 +1,62 @@
+// include/duplivault/BufferPool.h
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "Chunker.h"
+
+namespace dv {
+
+/**
+ * @brief Recycles chunk-sized byte buffers between the threads of a
+ *        pipeline, so that a steady stream of chunks does not cost a heap
+ *        allocation each.
+ *
+ * Buffers are plain Chunks that were reserved to a fixed capacity up
+ * front: filling one with up to that many bytes (assign(), or
+ * compress_chunk() for a chunk whose compress_bound() fits) never
+ * reallocates. Whoever is done with a buffer hands it back with
+ * release(); up to 'max_free' are kept for reuse and the rest are freed,
+ * so a burst does not pin its peak memory for good.
+ */
+class BufferPool {
+public:
+    /**
+     * @param buffer_capacity The capacity of every buffer handed out.
+     * @param max_free Most released buffers kept for reuse.
+     */
+    BufferPool(size_t buffer_capacity, size_t max_free);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief An empty buffer with at least buffer_capacity() reserved,
+     *        recycled if one is free.
+     */
+    Chunk acquire();
+
+    /**
+     * @brief Takes a buffer back for reuse. Buffers that are too small,
+     *        or that grew far past the capacity, are freed instead, as are
+     *        any beyond max_free.
+     */
+    void release(Chunk&& buffer);
+
+    size_t buffer_capacity() const { return buffer_capacity_; }
+
+    /**
+     * @brief Number of buffers waiting to be reused.
+     */
+    size_t free_count() const;
+
+private:
+    const size_t buffer_capacity_;
+    const size_t max_free_;
+    mutable std::mutex mutex_;
+    std::vector<Chunk> free_; // Reserved to max_free_, so releasing never allocates.
+};
+
+} // namespace dv
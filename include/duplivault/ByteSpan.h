@@ -0,0 +1,20 @@
+// include/duplivault/ByteSpan.h
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace dv {
+
+// A non-owning view of a run of bytes (C++17 has no std::span).
+// The memory it points to must outlive the view.
+struct ByteSpan {
+    const std::byte* data = nullptr;
+    size_t size = 0;
+
+    ByteSpan() = default;
+    ByteSpan(const std::byte* d, size_t n) : data(d), size(n) {}
+    ByteSpan(const std::vector<std::byte>& v) : data(v.data()), size(v.size()) {}
+};
+
+} // namespace dv
@@ -0,0 +1,106 @@
+// include/duplivault/Catalog.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Digest.h"
+#include "FileScan.h"
+
+namespace dv {
+
+// One backed-up file: its canonical path, its stat when it was backed up,
+// and the digest of its manifest blob in the packs.
+struct CatalogEntry {
+    std::string path;
+    FileStat stat;
+    Digest manifest;
+    // The stat was racy when recorded (see RACY_WINDOW_NS), so it cannot
+    // show that the file is unchanged.
+    bool racy = false;
+
+    /**
+     * @brief True if a file with stat 'current' can be skipped.
+     */
+    bool unchanged(const FileStat& current) const { return !racy && stat == current; }
+};
+
+/**
+ * @brief The sorted map from source path to the file's latest backup.
+ *
+ * It replaces one metadata file per source path: the whole catalog is
+ * loaded with a single read, an unchanged-file check is a binary search
+ * in memory, and listing every file is one pass in path order.
+ *
+ * File format (host byte order, recorded by a byte-order mark):
+ *   "DVCAT001" | byte-order mark u32 | record size u32 | count u64 |
+ *   string bytes u64
+ *   count * 88-byte records, sorted by path:
+ *     path offset u64 | path length u32 | flags u32 (1 = racy) |
+ *     mod_time_ns i64 | change_time_ns i64 | size u64 | inode u64 |
+ *     device u64 | manifest digest [32]
+ *   the paths, concatenated
+ *
+ * A directory's record has its path with a trailing '/', its file count
+ * as size, and its snapshot tree as manifest digest.
+ *
+ * Records are fixed-size and refer to their path by offset, so lookups
+ * run directly on the file image without decoding it (the file could as
+ * well be mapped). Inserts are kept aside and merged in by save(), which
+ * writes the new catalog beside the old one and renames it over it.
+ */
+class Catalog {
+public:
+    /**
+     * @brief Replaces the contents with the catalog stored at 'path'.
+     * @return False (leaving the catalog empty) if there is no usable
+     *         catalog there.
+     */
+    bool load(const std::filesystem::path& path);
+
+    /**
+     * @brief Merges pending inserts and writes the catalog to 'path'.
+     * @throws std::runtime_error if it cannot be written.
+     */
+    void save(const std::filesystem::path& path);
+
+    std::optional<CatalogEntry> find(std::string_view path) const;
+
+    /**
+     * @brief Adds an entry, replacing any with the same path.
+     */
+    void insert(CatalogEntry entry);
+
+    /**
+     * @brief Calls fn for every entry, in path order.
+     */
+    void for_each(const std::function<void(const CatalogEntry&)>& fn) const;
+
+    size_t size() const { return count_ + added_; }
+
+    /**
+     * @brief True if there are inserts that save() has not written yet.
+     */
+    bool dirty() const { return !pending_.empty(); }
+
+private:
+    size_t lower_bound(std::string_view path) const;
+    std::string_view path_at(size_t i) const;
+    CatalogEntry entry_at(size_t i) const;
+
+    std::vector<std::byte> image_; // The loaded file.
+    size_t count_ = 0;             // Records in image_.
+    size_t strings_at_ = 0;        // Offset of the paths in image_.
+
+    std::map<std::string, CatalogEntry, std::less<>> pending_;
+    size_t added_ = 0; // Pending entries whose path is not in image_.
+};
+
+} // namespace dv
@@ -0,0 +1,86 @@
+// include/duplivault/ChunkCache.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "ByteSpan.h"
+#include "Chunker.h"
+#include "Digest.h"
+
+namespace dv {
+
+// How a ChunkCache was used since it was created.
+struct ChunkCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t bytes = 0; // Currently held.
+};
+
+/**
+ * @brief A size-bounded LRU cache of chunk data keyed by digest, shared
+ *        by threads.
+ *
+ * The digest space is split into SHARDS independent shards (by the
+ * digest's first byte), each with its own lock, LRU list and an equal
+ * share of the byte budget, so concurrent lookups rarely contend. Chunks
+ * are handed out as shared pointers: one that is evicted while a reader
+ * still uses it stays valid until the reader lets go.
+ */
+class ChunkCache {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    /**
+     * @param capacity_bytes Most chunk bytes held at once. A chunk larger
+     *        than a shard's share is never cached.
+     */
+    explicit ChunkCache(size_t capacity_bytes);
+
+    ChunkCache(const ChunkCache&) = delete;
+    ChunkCache& operator=(const ChunkCache&) = delete;
+
+    /**
+     * @brief Returns the chunk and marks it most recently used, or null
+     *        if it is not cached.
+     */
+    std::shared_ptr<const Chunk> get(const Digest& hash);
+
+    /**
+     * @brief Caches a copy of 'data', evicting the least recently used
+     *        chunks of its shard to make room.
+     */
+    void put(const Digest& hash, ByteSpan data);
+
+    size_t capacity() const { return shard_capacity_ * SHARDS; }
+
+    ChunkCacheStats stats() const;
+
+private:
+    struct Entry {
+        Digest hash;
+        std::shared_ptr<const Chunk> data;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> lru; // Most recently used first.
+        std::unordered_map<Digest, std::list<Entry>::iterator> entries;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    Shard& shard_for(const Digest& hash) { return shards_[hash.bytes[0] % SHARDS]; }
+
+    size_t shard_capacity_;
+    std::array<Shard, SHARDS> shards_;
+};
+
+} // namespace dv
@@ -0,0 +1,126 @@
+// include/duplivault/ChunkIndex.h
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "Digest.h"
+
+namespace dv {
+
+// Where a chunk's bytes live inside the pack files.
+struct PackLocation {
+    uint32_t pack_id = 0;
+    uint64_t offset = 0;  // Of the chunk data, past its record header.
+    uint32_t length = 0;  // Stored length of the data.
+    uint32_t flags = 0;   // Low byte: the data's ChunkCodec. Others reserved (0).
+};
+
+/**
+ * @brief The repository-wide map from chunk digest to pack location.
+ *
+ * An open-addressed hash table with linear probing, held in memory so a
+ * dedup check is a few cache-line reads. SHA-256 digests are already
+ * uniformly distributed, so their first 8 bytes are the hash.
+ *
+ * It is persisted in two files:
+ * - chunk-index.tbl: a header followed by the table's slots exactly as
+ *   they are laid out in memory, so loading is a single read (or a
+ *   mapping) with no rehashing.
+ * - chunk-index.log: slots inserted since the table was written, in
+ *   insertion order. save() appends to it; once it grows past a quarter of
+ *   the table, save() rewrites the table and empties the log.
+ *
+ * Slots are stored in the host's byte order. The table's header records
+ * it, and a table from a host with the other order is not loaded.
+ *
+ * The index also tracks a watermark: the end of the furthest pack record
+ * it has seen. Pack data before the watermark is known to be indexed.
+ */
+class ChunkIndex {
+public:
+    // The furthest point in the packs that the index covers.
+    struct Watermark {
+        uint32_t pack_id = 0;
+        uint64_t end = 0;
+    };
+
+    ChunkIndex();
+
+    /**
+     * @brief Replaces the contents with the table and log in 'dir'.
+     * @return False if there is no usable table there. The index is then
+     *         empty and should be rebuilt from the packs.
+     */
+    bool load(const std::filesystem::path& dir);
+
+    /**
+     * @brief Writes entries inserted since the last save to disk, creating
+     *        'dir' if needed.
+     * @throws std::runtime_error if the files cannot be written.
+     */
+    void save(const std::filesystem::path& dir);
+
+    /**
+     * @brief Looks up a digest.
+     */
+    std::optional<PackLocation> find(const Digest& hash) const;
+
+    /**
+     * @brief Adds a digest, and moves the watermark past its record.
+     * @return False (changing nothing else) if it is already present.
+     */
+    bool insert(const Digest& hash, const PackLocation& location);
+
+    /**
+     * @brief Moves the watermark past a pack record without indexing it,
+     *        e.g. for a duplicate copy of a chunk.
+     */
+    void cover(uint32_t pack_id, uint64_t end);
+
+    Watermark watermark() const { return watermark_; }
+
+    /**
+     * @brief Calls fn(digest, location) for every entry, in table order.
+     */
+    void for_each(const std::function<void(const Digest&, const PackLocation&)>& fn) const;
+
+    size_t size() const { return count_; }
+
+    /**
+     * @brief Empties the index (in memory only).
+     */
+    void clear();
+
+private:
+    // One table entry; the on-disk format of both files. pack_id 0 marks
+    // an empty slot (pack numbering starts at 1).
+    struct Slot {
+        std::array<uint8_t, Digest::SIZE> digest;
+        uint64_t offset;
+        uint32_t pack_id;
+        uint32_t length;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Slot) == 56, "Slot is an on-disk format");
+
+    size_t probe(const Digest& hash) const;
+    void place(const Slot& slot);
+    void grow();
+
+    std::vector<Slot> slots_;
+    size_t count_ = 0;
+    Watermark watermark_;
+
+    std::vector<Slot> pending_;  // Inserted since the last save().
+    size_t log_entries_ = 0;     // Slots in the on-disk log.
+    bool table_stale_ = true;    // The on-disk table needs rewriting.
+};
+
+} // namespace dv
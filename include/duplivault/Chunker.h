@@ -3,13 +3,58 @@
 
 #include <vector>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <istream>
+#include <optional>
+#include <string_view>
+
+#include "ByteSpan.h"
 
 namespace dv {
 
+class ThreadPool;
+
 // For clarity, we define that a "Chunk" is simply a vector of bytes.
 using Chunk = std::vector<std::byte>;
 
+// The rolling-hash algorithm used to find chunk boundaries. The numeric
+// values are persisted in repositories and must never change.
+enum class ChunkingEngine : uint8_t {
+    Buzhash = 0, // 64-byte windowed Buzhash with a single 13-bit pattern.
+    FastCdc = 1, // Gear hash with normalized chunking (FastCDC).
+};
+
+// How the boundary search is executed. Every backend finds exactly the
+// same cut points; they differ only in speed.
+enum class ScanBackend {
+    Auto,   // Whichever backend measures fastest on this CPU.
+    Scalar, // One byte at a time.
+    Avx2,   // Hashes 8 (Buzhash) or 4 (FastCDC) positions per step.
+};
+
+// "buzhash" / "fastcdc", as used on the command line and in repo config.
+const char* to_string(ChunkingEngine engine);
+std::optional<ChunkingEngine> parse_chunking_engine(std::string_view name);
+
+// Where one chunk lies inside a larger buffer.
+struct ChunkBoundary {
+    size_t offset = 0;
+    size_t length = 0;
+
+    bool operator==(const ChunkBoundary& other) const {
+        return offset == other.offset && length == other.length;
+    }
+};
+
+// Receives each chunk as a view into the chunker's (or caller's) buffer.
+// The view is only valid for the duration of the call.
+using ChunkCallback = std::function<void(ByteSpan chunk)>;
+
+// Receives a run of consecutive chunks at once. Offsets are relative to
+// 'base', which is only valid for the duration of the call.
+using ChunkBatchCallback = std::function<void(const std::byte* base, const std::vector<ChunkBoundary>& chunks)>;
+
 class Chunker {
 public:
     // These constants control how the chunking algorithm behaves.
@@ -17,6 +62,15 @@ public:
     static constexpr size_t MIN_CHUNK_SIZE = 2 * 1024;   // 2 KB
     static constexpr size_t AVG_CHUNK_SIZE = 8 * 1024;   // 8 KB
     static constexpr size_t MAX_CHUNK_SIZE = 32 * 1024;  // 32 KB
+
+    // How much the streaming chunker reads from its input at a time.
+    // Memory use is bounded by this, regardless of the input's size.
+    static constexpr size_t STREAM_BUFFER_SIZE = 1024 * 1024; // 1 MB
+
+    // The parallel chunker reads this much at a time and hands each
+    // thread one segment of it to scan.
+    static constexpr size_t PARALLEL_WINDOW_SIZE = 32 * 1024 * 1024; // 32 MB
+    static constexpr size_t PARALLEL_SEGMENT_SIZE = 1024 * 1024;     // 1 MB
     
     // This is the "magic pattern" we look for in our data's hash to decide
     // where to end a chunk.
@@ -25,12 +79,114 @@ public:
     // checking if the lowest 13 bits of a hash are all zero.
     static constexpr uint32_t CHUNK_PATTERN = (1 << 13) - 1;
 
+    // FastCDC's normalized chunking uses a harder pattern (15 bits) before
+    // AVG_CHUNK_SIZE and an easier one (11 bits) after it. This pulls chunk
+    // sizes towards the average from both sides. The bits are spread over the
+    // high half of the 64-bit gear hash, which mixes the most input bytes.
+    static constexpr uint64_t FASTCDC_MASK_S = 0x0000d9f003530000ULL;
+    static constexpr uint64_t FASTCDC_MASK_L = 0x0000d90003530000ULL;
+
+    /**
+     * @brief Constructs a chunker.
+     * @param engine The boundary-finding algorithm. A repository must
+     *        always be fed by the same engine, or identical data will
+     *        chunk differently and stop deduplicating.
+     * @param scan How to run the search. Auto resolves at construction.
+     * @throws std::invalid_argument if this CPU does not support 'scan'.
+     */
+    explicit Chunker(ChunkingEngine engine = ChunkingEngine::Buzhash, ScanBackend scan = ScanBackend::Auto);
+
+    ChunkingEngine engine() const { return engine_; }
+
+    /**
+     * @brief The scan backend actually in use (never Auto).
+     */
+    ScanBackend scan_backend() const { return scan_backend_; }
+
+    /**
+     * @brief Checks whether this CPU can run a scan backend.
+     */
+    static bool is_supported(ScanBackend scan);
+
+    /**
+     * @brief Finds the end of the chunk that starts at 'data'.
+     * @param data Pointer to the first byte of the chunk.
+     * @param size Number of bytes available from 'data'.
+     * @param at_eof True if no bytes follow the available ones.
+     * @return The chunk's length, or 0 if more input is needed to decide
+     *         (only possible when 'at_eof' is false).
+     */
+    size_t next_boundary(const std::byte* data, size_t size, bool at_eof) const;
+
+    /**
+     * @brief Splits a caller-owned buffer (e.g. a whole file in memory or
+     *        a mapping) into chunks without copying any data.
+     * @return The (offset, length) of every chunk, in order.
+     */
+    std::vector<ChunkBoundary> find_boundaries(const std::byte* data, size_t size) const;
+
+    /**
+     * @brief Like find_boundaries(), but scans segments of the buffer on
+     *        several threads. The result is identical to the sequential
+     *        version.
+     *
+     * Whether a position ends a chunk depends only on the 64 bytes before
+     * it and on its distance from the chunk start. Each thread therefore
+     * records every position whose hash matches in its own segment (with
+     * a 63-byte overlap at the seams), and a fast sequential pass then
+     * applies the size limits to pick the real cut points.
+     */
+    std::vector<ChunkBoundary> find_boundaries(const std::byte* data, size_t size, ThreadPool& pool) const;
+
+    /**
+     * @brief Like find_boundaries(), but hands each chunk to a callback.
+     */
+    void for_each_chunk(const std::byte* data, size_t size, const ChunkCallback& on_chunk) const;
+
+    /**
+     * @brief Splits a data stream into chunks in constant memory.
+     * @param stream The input stream to read data from.
+     * @param on_chunk Called once per chunk, in order.
+     */
+    void chunk(std::istream& stream, const ChunkCallback& on_chunk) const;
+
+    /**
+     * @brief The same, reading through a caller-owned buffer (resized to
+     *        STREAM_BUFFER_SIZE), so that a thread chunking many files can
+     *        reuse one buffer for all of them.
+     */
+    void chunk(std::istream& stream, const ChunkCallback& on_chunk, std::vector<std::byte>& buffer) const;
+
     /**
      * @brief Splits a data stream into content-defined chunks.
      * @param stream The input stream to read data from.
      * @return A vector of Chunk objects.
      */
     std::vector<Chunk> chunk(std::istream& stream) const;
+
+    /**
+     * @brief Splits a data stream into chunks, scanning each
+     *        PARALLEL_WINDOW_SIZE window of it on several threads.
+     *        Produces the same chunks as the sequential overloads.
+     * @param stream The input stream to read data from.
+     * @param pool Threads to scan with, alongside the calling thread.
+     * @param on_batch Called once per window with its chunks, in order.
+     */
+    void chunk(std::istream& stream, ThreadPool& pool, const ChunkBatchCallback& on_batch) const;
+
+    /**
+     * @brief Like the stream overload, but over a caller-owned buffer
+     *        (e.g. a mapped file), which is scanned in place one
+     *        PARALLEL_WINDOW_SIZE window at a time. 'base' in each batch
+     *        points into 'data'.
+     */
+    void chunk(const std::byte* data, size_t size, ThreadPool& pool, const ChunkBatchCallback& on_batch) const;
+
+private:
+    ChunkingEngine engine_;
+    ScanBackend scan_backend_;
+    // The kernel for this engine and backend; see src/ChunkerKernels.h.
+    size_t (*scan_)(const std::byte* data, size_t limit);
 };
 
-} // namespace dv
\ No newline at end of file
+} // namespace dv
@@ -0,0 +1,73 @@
+// include/duplivault/Compression.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "ByteSpan.h"
+#include "Chunker.h"
+
+namespace dv {
+
+// How a chunk's bytes are stored. The numeric values are persisted in the
+// low byte of pack record flags and must never change.
+enum class ChunkCodec : uint8_t {
+    Raw = 0, // As is.
+    Lz = 1,  // A u32 raw length, then an LZ77 byte stream (see Compression.cpp).
+};
+
+// The bits of PackLocation::flags that hold the codec.
+constexpr uint32_t CODEC_FLAGS_MASK = 0xff;
+
+inline ChunkCodec codec_from_flags(uint32_t flags) { return static_cast<ChunkCodec>(flags & CODEC_FLAGS_MASK); }
+inline uint32_t flags_for_codec(ChunkCodec codec) { return static_cast<uint32_t>(codec); }
+
+// "raw" / "lz".
+const char* to_string(ChunkCodec codec);
+std::optional<ChunkCodec> parse_chunk_codec(std::string_view name);
+
+/**
+ * @brief The most bytes compress_chunk() may write for 'raw_size' bytes
+ *        of input. An output buffer reserved to this is never regrown.
+ */
+constexpr size_t compress_bound(size_t raw_size) { return raw_size + raw_size / 255 + 16; }
+
+/**
+ * @brief Compresses a chunk for storage, if that is worth it.
+ *
+ * Incompressible input is given up on early: the match search takes
+ * longer strides the longer it goes without a match, and if none is
+ * found in the first INCOMPRESSIBLE_PROBE_SIZE bytes, or the output
+ * grows past what storing the chunk raw would cost, compression stops.
+ *
+ * @param out Receives the compressed bytes when Lz is returned. Its
+ *        capacity is reused, so a recycled buffer costs no allocation.
+ * @return Lz, or Raw if the chunk should be stored as is ('out' is then
+ *         unspecified).
+ */
+ChunkCodec compress_chunk(ByteSpan raw, Chunk& out);
+
+/**
+ * @brief Decodes stored bytes into exactly 'raw_size' bytes at 'out'.
+ * @return False if they are corrupt or do not decode to 'raw_size' bytes.
+ */
+bool decompress_chunk(ChunkCodec codec, ByteSpan stored, std::byte* out, size_t raw_size);
+
+/**
+ * @brief Decodes stored bytes whose raw size is not known up front.
+ * @throws std::runtime_error if the codec is unknown or they are corrupt.
+ */
+Chunk decompress_chunk(ChunkCodec codec, ByteSpan stored);
+
+/**
+ * @brief The raw size of stored bytes, read from their header.
+ * @return Nothing if the header is missing or the codec is unknown.
+ */
+std::optional<size_t> raw_size_of(ChunkCodec codec, ByteSpan stored);
+
+// Compression is abandoned if no match turns up this far into a chunk.
+constexpr size_t INCOMPRESSIBLE_PROBE_SIZE = 4 * 1024;
+
+} // namespace dv
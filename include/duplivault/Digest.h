@@ -0,0 +1,61 @@
+// include/duplivault/Digest.h
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace dv {
+
+/**
+ * @brief A raw 32-byte SHA-256 digest.
+ *
+ * This is how chunks are identified everywhere inside the program. It is a
+ * fixed-size value with no heap allocation, so it is cheap to copy, compare
+ * and use as a map key. Hex text is produced only at the boundaries that
+ * need it (file names, JSON manifests, log output).
+ */
+struct Digest {
+    static constexpr size_t SIZE = 32;
+
+    std::array<uint8_t, SIZE> bytes{};
+
+    /**
+     * @brief Formats the digest as 64 lowercase hex characters.
+     */
+    std::string to_hex() const;
+
+    /**
+     * @brief Parses 64 hex characters (either case).
+     * @throws std::invalid_argument if 'hex' is not a valid digest.
+     */
+    static Digest from_hex(std::string_view hex);
+
+    bool operator==(const Digest& other) const { return bytes == other.bytes; }
+    bool operator!=(const Digest& other) const { return bytes != other.bytes; }
+    bool operator<(const Digest& other) const { return bytes < other.bytes; }
+};
+
+// Streams the hex form directly, without building a temporary string.
+std::ostream& operator<<(std::ostream& os, const Digest& digest);
+
+} // namespace dv
+
+namespace std {
+
+// SHA-256 output is already uniformly distributed, so the first machine
+// word of the digest is a perfectly good hash.
+template <>
+struct hash<dv::Digest> {
+    size_t operator()(const dv::Digest& digest) const noexcept {
+        size_t h;
+        std::memcpy(&h, digest.bytes.data(), sizeof(h));
+        return h;
+    }
+};
+
+} // namespace std
@@ -0,0 +1,105 @@
+// include/duplivault/FileScan.h
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+namespace dv {
+
+/**
+ * @brief What a backup remembers about a source file to tell whether it
+ *        changed.
+ *
+ * Times are nanoseconds since the Unix epoch where stat() is available,
+ * and file_time_type ticks elsewhere. Fields the platform does not have
+ * are 0.
+ */
+struct FileStat {
+    int64_t mod_time_ns = 0;
+    int64_t change_time_ns = 0; // ctime: also moves on chmod, rename, etc.
+    uint64_t size = 0;
+    uint64_t inode = 0;
+    uint64_t device = 0;
+
+    bool operator==(const FileStat& other) const {
+        return mod_time_ns == other.mod_time_ns && change_time_ns == other.change_time_ns && size == other.size &&
+               inode == other.inode && device == other.device;
+    }
+    bool operator!=(const FileStat& other) const { return !(*this == other); }
+};
+
+// A file whose timestamps are this close to the moment it was looked at
+// is "racy": it could change again without its timestamps changing (on
+// filesystems with coarse timestamps, up to 2 s), so an unchanged stat
+// does not prove unchanged contents.
+constexpr int64_t RACY_WINDOW_NS = 2'000'000'000;
+
+struct ScannedFile {
+    std::filesystem::path path;
+    std::string relative_path; // From the scan root, '/'-separated.
+    FileStat stat;
+    bool racy = false;
+};
+
+// A directory whose entries have all been reported.
+struct ScannedDirectory {
+    std::filesystem::path path;
+    std::string relative_path; // From the scan root, '/'-separated; "" for the root.
+    FileStat stat;             // Its mtime and ctime move when entries are added or removed.
+    bool racy = false;
+};
+
+/**
+ * @brief Walks 'root' recursively and calls fn for every regular file,
+ *        with its stat, until fn returns false.
+ *
+ * On POSIX systems each directory is read once and each entry costs a
+ * single fstatat() relative to the open directory, so there are no
+ * path lookups. Symlinks to files are followed; symlinks to directories
+ * are not. Elsewhere it falls back to std::filesystem.
+ *
+ * Paths are built by appending entry names to 'root'; pass a canonical
+ * root to get the form canonical_file_path() gives.
+ * @throws std::runtime_error if a directory cannot be read.
+ */
+void scan_files(const std::filesystem::path& root, const std::function<bool(ScannedFile&&)>& fn);
+
+/**
+ * @brief As above, and also calls on_directory for every directory once
+ *        all of its entries (and those of its subdirectories) have been
+ *        reported, so the root comes last.
+ *
+ * A directory is stat'ed before it is read, so entries added while it is
+ * being read leave it with a newer stat than reported. Where the scan
+ * falls back to std::filesystem, on_directory is never called.
+ */
+void scan_files(const std::filesystem::path& root, const std::function<bool(ScannedFile&&)>& fn,
+                const std::function<bool(ScannedDirectory&&)>& on_directory);
+
+#ifndef _WIN32
+enum class EntryKind { Skip, File, Directory };
+
+/**
+ * @brief Decides how scan_files() treats the entry 'name' of the directory
+ *        open as 'dir_fd', filling 'stat' for a file.
+ *
+ * 'd_type' is readdir()'s type for the entry; DT_UNKNOWN, which some
+ * filesystems always report, costs an extra fstatat() for symlinks so
+ * that they are treated the same as anywhere else.
+ */
+EntryKind classify_entry(int dir_fd, const char* name, unsigned char d_type, FileStat& stat);
+#endif
+
+/**
+ * @brief Makes 'path' absolute and resolves symlinks in its directory, but
+ *        not in its last component.
+ *
+ * This is the form scan_files() reports files in under a canonical root:
+ * a symlink to a file keeps its own name, so it is cataloged and looked
+ * up as the link, not as its target.
+ */
+std::filesystem::path canonical_file_path(const std::filesystem::path& path);
+
+} // namespace dv
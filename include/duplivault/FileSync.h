@@ -0,0 +1,41 @@
+// include/duplivault/FileSync.h
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <ostream>
+
+namespace dv {
+
+// Durable writes for the repository's files. Rename alone makes a
+// replacement atomic, but not durable: after a power loss the new name
+// can point at data that never reached the disk. Syncing the data before
+// the rename, and the directory after it, closes that gap. Each sync is
+// a disk flush, so callers batch them (see PackStore::flush()).
+//
+// On platforms without fsync() the syncs do nothing.
+
+/**
+ * @brief Forces a file's data to stable storage.
+ * @throws std::runtime_error if it cannot be opened or synced.
+ */
+void sync_file(const std::filesystem::path& path);
+
+/**
+ * @brief Forces a directory's entries to stable storage, so that files
+ *        created in or renamed into it survive a crash.
+ * @throws std::runtime_error if it cannot be opened or synced.
+ */
+void sync_directory(const std::filesystem::path& dir);
+
+/**
+ * @brief Replaces 'path' with what 'write' produces: it is written to
+ *        'path'.tmp, synced, renamed over 'path', and the directory is
+ *        synced. A crash at any point leaves the old file or the new one.
+ * @param what Names the file in errors, e.g. "catalog".
+ * @throws std::runtime_error if writing or syncing fails.
+ */
+void write_file_atomically(const std::filesystem::path& path, const char* what,
+                           const std::function<void(std::ostream&)>& write);
+
+} // namespace dv
@@ -4,17 +4,111 @@
 #include <vector>
 #include <cstddef> // Required for std::byte
 
+#include <duplivault/ByteSpan.h>
+#include <duplivault/Digest.h>
+#include "sha256.h" // For Sha256Context
+
 // We'll place all our project's code inside the 'dv' namespace
 namespace dv {
 
+// Which SHA-256 implementation a Hasher runs on.
+enum class HashBackend {
+    Auto,   // The fastest backend this CPU supports.
+    Scalar, // The portable FIPS 180-4 loop.
+    ShaNi,  // x86 SHA extensions.
+    Avx2,   // AVX2 multi-buffer: 8 chunks at once in compute_many().
+};
+
 class Hasher {
 public:
+    /**
+     * @brief An incremental hashing session.
+     *
+     * Data can be fed in any number of pieces (e.g. while a chunk is still
+     * being scanned) and is hashed straight from the caller's buffer. A
+     * Stream holds no heap memory, so creating one per chunk is free.
+     */
+    class Stream {
+    public:
+        /**
+         * @param compress The block function to use; null picks the fastest.
+         */
+        explicit Stream(Sha256CompressFn compress = nullptr);
+
+        /**
+         * @brief Feeds more bytes into the hash.
+         * @param data Pointer to the bytes to hash.
+         * @param size Number of bytes to hash.
+         */
+        void update(const std::byte* data, size_t size);
+
+        /**
+         * @brief Finishes the hash. The stream must not be updated afterwards.
+         * @return The SHA-256 digest.
+         */
+        Digest finish();
+
+    private:
+        Sha256Context ctx_;
+    };
+
+    /**
+     * @brief Constructs a hasher on the given backend.
+     * @param backend The implementation to use. Auto resolves at construction.
+     * @throws std::invalid_argument if this CPU does not support the backend.
+     */
+    explicit Hasher(HashBackend backend = HashBackend::Auto);
+
+    /**
+     * @brief The backend actually in use (never Auto).
+     */
+    HashBackend backend() const { return backend_; }
+
+    /**
+     * @brief Checks whether this CPU can run a backend.
+     */
+    static bool is_supported(HashBackend backend);
+
+    /**
+     * @brief Starts a new incremental hashing session.
+     */
+    Stream begin() const;
+
     /**
      * @brief Computes the SHA-256 hash of a block of binary data.
      * @param data A vector of bytes representing the data to be hashed.
-     * @return A string containing the hex-encoded SHA-256 hash.
+     * @return The SHA-256 digest.
+     */
+    Digest compute(const std::vector<std::byte>& data) const;
+
+    /**
+     * @brief Computes the SHA-256 hash of a caller-owned byte range.
+     * @param data Pointer to the first byte.
+     * @param size Number of bytes to hash.
+     * @return The SHA-256 digest.
      */
-    std::string compute(const std::vector<std::byte>& data) const;
+    Digest compute(const std::byte* data, size_t size) const;
+
+    /**
+     * @brief Hashes many independent inputs, in parallel lanes where the
+     *        backend allows it (Avx2 hashes 8 at a time).
+     * @param inputs The byte ranges to hash.
+     * @return One digest per input, in the same order.
+     */
+    std::vector<Digest> compute_many(const std::vector<ByteSpan>& inputs) const;
+
+    /**
+     * @brief The same, into caller-owned storage, so hashing a group of
+     *        chunks allocates nothing.
+     * @param inputs 'count' byte ranges to hash.
+     * @param out Receives 'count' digests, in the same order.
+     */
+    void compute_many(const ByteSpan* inputs, size_t count, Digest* out) const;
+
+private:
+    HashBackend backend_;
+    // Block function for single-stream hashing on this backend.
+    Sha256CompressFn compress_;
 };
 
-} // namespace dv
\ No newline at end of file
+} // namespace dv
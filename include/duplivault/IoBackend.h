@@ -0,0 +1,120 @@
+// include/duplivault/IoBackend.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#include <mutex>
+#endif
+
+namespace dv {
+
+/**
+ * @brief A file read or written at explicit offsets, so that several
+ *        requests can use it at once without a shared file position.
+ */
+class IoFile {
+public:
+    IoFile() = default;
+    ~IoFile() { close(); }
+
+    IoFile(const IoFile&) = delete;
+    IoFile& operator=(const IoFile&) = delete;
+
+    bool open_for_reading(const std::filesystem::path& path);
+
+    /**
+     * @brief Creates (or truncates) the file and gives it its final size,
+     *        so writes can land anywhere in it.
+     */
+    bool create(const std::filesystem::path& path, uint64_t size);
+
+    /**
+     * @brief Reads exactly 'size' bytes; false on an error or end of file.
+     */
+    bool read_at(std::byte* data, size_t size, uint64_t offset);
+    bool write_at(const std::byte* data, size_t size, uint64_t offset);
+
+    bool close();
+
+#ifndef _WIN32
+    int native_handle() const { return fd_; }
+#endif
+
+private:
+#ifndef _WIN32
+    int fd_ = -1;
+#else
+    std::fstream stream_;
+    std::mutex mutex_;
+#endif
+};
+
+// One read or write for an IoBackend.
+struct IoRequest {
+    enum class Op : uint8_t { Read, Write };
+
+    Op op = Op::Read;
+    IoFile* file = nullptr;
+    uint64_t offset = 0;
+    std::byte* data = nullptr; // Read into, or written from (left unchanged).
+    size_t length = 0;
+    bool ok = false; // Set once the request has completed.
+};
+
+/**
+ * @brief Runs batches of reads and writes with as many of them in flight
+ *        at once as the implementation allows.
+ *
+ * A batch lets the storage device see a deep queue of independent
+ * requests, where a loop of blocking calls would keep just one
+ * outstanding.
+ */
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Runs every request in 'requests' (in any order) and returns
+     *        once all have completed, each with its 'ok' set. A request
+     *        is retried until it has transferred all of its bytes.
+     */
+    virtual void run(std::vector<IoRequest>& requests) = 0;
+};
+
+enum class IoBackendKind {
+    Auto,    // io_uring where the kernel allows it, threads otherwise.
+    Threads, // Blocking pread()/pwrite() calls from a pool of threads.
+    IoUring, // Linux io_uring, driven by raw system calls.
+};
+
+// "auto" / "threads" / "io_uring", as used on the command line.
+const char* to_string(IoBackendKind kind);
+std::optional<IoBackendKind> parse_io_backend_kind(std::string_view name);
+
+/**
+ * @brief True if this build and the running kernel support io_uring.
+ */
+bool io_uring_available();
+
+constexpr unsigned DEFAULT_IO_THREADS = 8;
+
+/**
+ * @brief Creates a backend.
+ * @param threads Threads for the Threads backend (and so the number of
+ *        requests it keeps in flight).
+ * @throws std::invalid_argument if IoUring is requested but unavailable.
+ */
+std::unique_ptr<IoBackend> make_io_backend(IoBackendKind kind = IoBackendKind::Auto,
+                                           unsigned threads = DEFAULT_IO_THREADS);
+
+} // namespace dv
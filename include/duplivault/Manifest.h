@@ -0,0 +1,120 @@
+// include/duplivault/Manifest.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ByteSpan.h"
+#include "Digest.h"
+#include "json.hpp"
+
+namespace dv {
+
+/**
+ * @brief Everything needed to restore one file: where it came from, when
+ *        it was last modified, and its chunks in order.
+ *
+ * Stored in a compact binary form (see ManifestView for the layout). JSON
+ * is still available through to_json()/from_json() for export and
+ * debugging, and from_json() reads the JSON metadata files written by
+ * earlier versions.
+ */
+struct Manifest {
+    std::string original_path;
+    int64_t mod_time_ns = 0;
+    std::vector<Digest> chunk_hashes;
+    // One per chunk, or empty if unknown (manifests converted from the
+    // old JSON format did not record lengths).
+    std::vector<uint32_t> chunk_lengths;
+
+    /**
+     * @brief Where each chunk starts in the file, followed by the file's
+     *        size: one more entry than there are chunks. Empty if the
+     *        lengths are unknown.
+     *
+     * Offsets are the running sum of the lengths, so they are not stored.
+     */
+    std::vector<uint64_t> chunk_offsets() const;
+
+    /**
+     * @brief Encodes the manifest in the binary format.
+     */
+    std::vector<std::byte> serialize() const;
+
+    /**
+     * @brief {"original_path", "mod_time_ns", "chunk_hashes": [hex...],
+     *        "chunk_lengths": [...]}; lengths are omitted if unknown.
+     */
+    nlohmann::json to_json() const;
+
+    /**
+     * @brief Reads the JSON form, including the older metadata files that
+     *        have no "chunk_lengths".
+     * @throws std::invalid_argument if a hash is not valid hex, or the
+     *         lengths do not match the hashes.
+     */
+    static Manifest from_json(const nlohmann::json& json);
+};
+
+/**
+ * @brief Reads a binary manifest in place, without copying or allocating.
+ *
+ * Layout (integers little-endian, "varint" is unsigned LEB128):
+ *   "DVMF" | version u8 | flags u8 | reserved u16
+ *   path length varint | path bytes
+ *   mod_time_ns i64
+ *   chunk count varint
+ *   chunk count * 32-byte digests
+ *   chunk count * varint lengths          (if flags & HAS_LENGTHS)
+ *
+ * The digests are fixed-size and contiguous, so any one of them can be
+ * read directly. The lengths come last because they vary in size.
+ */
+class ManifestView {
+public:
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t HAS_LENGTHS = 0x01;
+
+    /**
+     * @brief Validates and indexes a serialized manifest. 'bytes' must
+     *        outlive the view.
+     * @throws std::runtime_error if 'bytes' is not a valid manifest of a
+     *         version this build understands.
+     */
+    explicit ManifestView(ByteSpan bytes);
+
+    /**
+     * @brief True if 'bytes' starts like a binary manifest (as opposed to
+     *        an old JSON metadata file).
+     */
+    static bool is_manifest(ByteSpan bytes);
+
+    std::string_view original_path() const { return original_path_; }
+    int64_t mod_time_ns() const { return mod_time_ns_; }
+    size_t chunk_count() const { return chunk_count_; }
+    Digest chunk_hash(size_t i) const;
+    bool has_lengths() const { return lengths_ != nullptr; }
+
+    /**
+     * @brief Decodes the chunk lengths (empty if the manifest has none).
+     */
+    std::vector<uint32_t> chunk_lengths() const;
+
+    /**
+     * @brief Copies the manifest out into an owning Manifest.
+     */
+    Manifest to_manifest() const;
+
+private:
+    std::string_view original_path_;
+    int64_t mod_time_ns_ = 0;
+    size_t chunk_count_ = 0;
+    const std::byte* digests_ = nullptr;
+    const std::byte* lengths_ = nullptr;
+    const std::byte* end_ = nullptr;
+};
+
+} // namespace dv
@@ -0,0 +1,47 @@
+// include/duplivault/MappedFile.h
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace dv {
+
+/**
+ * @brief A regular file mapped read-only into memory, so it can be
+ *        chunked and hashed in place instead of being copied into a
+ *        buffer first.
+ *
+ * The mapping is advised for sequential access, so the kernel reads
+ * ahead aggressively and drops pages behind the reader early.
+ *
+ * If the file is truncated by another process while it is mapped,
+ * touching the lost pages raises SIGBUS; sources that may shrink during
+ * a backup should be read as streams instead.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the whole of 'path'.
+     * @return False if it cannot be mapped: it cannot be opened, is not a
+     *         regular file (pipes, devices), or the platform has no
+     *         mapping support. Read it as a stream then.
+     */
+    bool map(const std::filesystem::path& path);
+
+    void unmap();
+
+    const std::byte* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace dv
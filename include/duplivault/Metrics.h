@@ -0,0 +1,181 @@
+// include/duplivault/Metrics.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "json.hpp"
+
+namespace dv {
+
+/**
+ * @brief A distribution of values in power-of-two buckets.
+ *
+ * Recording is a handful of relaxed atomic adds, so one histogram can be
+ * shared by every thread of a pipeline and sit on per-chunk paths.
+ * Quantiles are only as precise as the buckets: each is reported as the
+ * upper bound of the bucket it falls in.
+ */
+class Histogram {
+public:
+    // Bucket 0 holds 0; bucket b > 0 holds [2^(b-1), 2^b).
+    static constexpr size_t BUCKETS = 65;
+
+    void record(uint64_t value) { record(value, 1); }
+
+    /**
+     * @brief Records 'value' 'times' times, e.g. a batch's time spread
+     *        evenly over the items in it.
+     */
+    void record(uint64_t value, uint64_t times);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief An upper bound for the q-quantile (q in [0, 1]); 0 if empty.
+     */
+    uint64_t quantile(double q) const;
+
+    /**
+     * @brief {"count", "sum", "mean", "p50", "p90", "p99", "max", "buckets"},
+     *        where "buckets" lists the non-empty buckets as {"le": upper
+     *        bound, "count"}.
+     */
+    nlohmann::json to_json() const;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Timed steps of a backup or restore. Each sample is one operation on one
+// chunk, file or batch, as noted.
+enum class Stage : size_t {
+    Chunk,       // Finding one chunk's end (including reading its bytes).
+    Hash,        // Hashing one chunk.
+    Lookup,      // One chunk_exists() check.
+    Compress,    // Compressing one new chunk.
+    Write,       // Storing one new chunk.
+    Metadata,    // Storing one file's manifest.
+    RestoreRead, // One batch of restore reads (with the previous window's writes).
+    Decompress,  // Decoding one compressed chunk for a restore.
+    Count
+};
+
+enum class Counter : size_t {
+    FilesScanned,     // Regular files the walk found.
+    FilesUnchanged,   // Of those, skipped by the change check.
+    FilesBackedUp,    // Manifests stored.
+    FilesFailed,      // Changed files that could not be read; kept at their previous version.
+    BytesIn,          // Bytes read from changed files and chunked.
+    Chunks,           // Chunks those bytes were cut into.
+    NewChunks,        // Chunks not stored before.
+    NewBytes,         // Their raw size.
+    StoredBytes,      // Their size in the packs, after compression.
+    TreesStored,      // Snapshot trees encoded, for directories with a changed entry.
+    FilesRestored,
+    BytesRestored,    // Written to restored files.
+    RestoreBytesRead, // Read from the repository for a restore.
+    CacheHits,        // Of the restore's chunk cache.
+    CacheMisses,
+    Count
+};
+
+// Names used in reports, e.g. "restore_read", "new_bytes".
+const char* to_string(Stage stage);
+const char* to_string(Counter counter);
+
+/**
+ * @brief Counters and latency histograms for the stages of a run, shared
+ *        by all of its threads.
+ */
+class Metrics {
+public:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void add(Counter counter, uint64_t n = 1) {
+        counters_[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t get(Counter counter) const {
+        return counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    }
+
+    // Durations in nanoseconds.
+    Histogram& stage(Stage stage) { return stages_[static_cast<size_t>(stage)]; }
+    const Histogram& stage(Stage stage) const { return stages_[static_cast<size_t>(stage)]; }
+
+    // Sizes of the chunks cut from changed files, in bytes.
+    Histogram& chunk_sizes() { return chunk_sizes_; }
+    const Histogram& chunk_sizes() const { return chunk_sizes_; }
+
+    /**
+     * @brief The whole report: {"counters", "dedup_ratio",
+     *        "compression_ratio", "stages_ns", "chunk_size_bytes"}. Stages
+     *        and ratios that saw no data are left out.
+     */
+    nlohmann::json to_json() const;
+
+    /**
+     * @brief The same report as a few lines of text.
+     */
+    void print(std::ostream& out) const;
+
+private:
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::Count)> counters_{};
+    std::array<Histogram, static_cast<size_t>(Stage::Count)> stages_;
+    Histogram chunk_sizes_;
+};
+
+/**
+ * @brief Records the time from its construction (or restart()) to its
+ *        destruction (or stop()) under a stage. Does nothing without a
+ *        Metrics.
+ */
+class StageTimer {
+public:
+    StageTimer(Metrics* metrics, Stage stage) : histogram_(metrics ? &metrics->stage(stage) : nullptr) { restart(); }
+    ~StageTimer() { stop(); }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    /**
+     * @brief Records the time so far, spread evenly over 'items' samples,
+     *        unless the timer is stopped already.
+     */
+    void stop(uint64_t items = 1) {
+        if (!running_) return;
+        running_ = false;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - start_).count();
+        if (items > 0) histogram_->record(static_cast<uint64_t>(elapsed) / items, items);
+    }
+
+    /**
+     * @brief Stops without recording anything.
+     */
+    void cancel() { running_ = false; }
+
+    void restart() {
+        if (!histogram_) return;
+        running_ = true;
+        start_ = std::chrono::steady_clock::now();
+    }
+
+private:
+    Histogram* histogram_;
+    bool running_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace dv
@@ -0,0 +1,144 @@
+// include/duplivault/PackStore.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ByteSpan.h"
+#include "ChunkIndex.h"
+#include "Chunker.h"
+#include "Digest.h"
+
+namespace dv {
+
+/**
+ * @brief Append-only storage for many chunks in a few large files.
+ *
+ * Chunks are appended as records to packs/pack-NNNNNN.pack until the file
+ * reaches a target size, then a new pack is started. When a pack is
+ * flushed, its records are listed in a sorted pack-NNNNNN.idx next to it.
+ *
+ * Lookups go to a ChunkIndex covering every pack, persisted in the packs
+ * directory. Opening the store loads that index and then only reads packs
+ * (through their .idx, or by scanning records where the .idx does not
+ * reach, e.g. after a crash) past the index's watermark. If the index is
+ * missing, damaged, or ahead of the pack data, it is rebuilt from the
+ * packs.
+ *
+ * Pack data is synced to disk before any index that points into it is
+ * written (see flush()), so the indexes survive a power loss only along
+ * with the records they list. Records past a pack's .idx were never
+ * synced: after a power loss they may hold garbage rather than be cut
+ * short, so they can be checked as they are scanned (see RecordCheck).
+ *
+ * Pack file:  "DVPACK01", then records of
+ *             digest[32] | length u32 | flags u32 | data[length]
+ * Index file: "DVIDX001" | covered u64 | count u64, then 'count' entries of
+ *             digest[32] | offset u64 | length u32 | flags u32
+ * All integers are little-endian. The low byte of a record's flags is
+ * the ChunkCodec its data is stored with (see Compression.h); PackStore
+ * itself never looks inside the data.
+ *
+ * Not thread-safe; StorageRepository serializes access.
+ */
+class PackStore {
+public:
+    static constexpr uint64_t DEFAULT_TARGET_PACK_SIZE = 64 * 1024 * 1024; // 64 MB
+
+    /**
+     * @brief Whether a record found by scanning past the indexes is
+     *        intact, given its digest, stored data and flags.
+     */
+    using RecordCheck = std::function<bool(const Digest& hash, ByteSpan data, uint32_t flags)>;
+
+    /**
+     * @brief Opens the packs in 'packs_dir' (which need not exist yet) and
+     *        loads the location of every chunk in them.
+     * @param target_pack_size A pack is closed once it grows past this.
+     * @param check_recovered If set, records not covered by any index are
+     *        read and checked, and the first that fails ends its pack like
+     *        a torn record would. Otherwise only their lengths are checked.
+     * @throws std::runtime_error if a pack or index file is malformed.
+     */
+    explicit PackStore(std::filesystem::path packs_dir, uint64_t target_pack_size = DEFAULT_TARGET_PACK_SIZE,
+                       RecordCheck check_recovered = nullptr);
+
+    /**
+     * @brief Closes the active pack, writing its index.
+     */
+    ~PackStore();
+
+    PackStore(const PackStore&) = delete;
+    PackStore& operator=(const PackStore&) = delete;
+
+    /**
+     * @brief Looks up where a chunk is stored.
+     */
+    std::optional<PackLocation> find(const Digest& hash) const;
+
+    /**
+     * @brief Appends a chunk to the active pack. The caller is expected to
+     *        have checked that it is not stored already.
+     */
+    void append(const Digest& hash, ByteSpan data, uint32_t flags = 0);
+
+    /**
+     * @brief Reads a chunk's stored bytes, still encoded.
+     * @throws std::runtime_error if the pack cannot be read.
+     */
+    Chunk read(const PackLocation& location);
+
+    /**
+     * @brief Returns the path of the pack holding 'location', after making
+     *        sure its bytes can be read through another file handle (the
+     *        active pack's write buffer is flushed if needed).
+     */
+    std::filesystem::path prepare_read(const PackLocation& location);
+
+    /**
+     * @brief Writes buffered data of the active pack, its .idx and the
+     *        chunk index to disk, in that order, syncing each before the
+     *        next is written.
+     */
+    void flush();
+
+    /**
+     * @brief Number of chunks stored in packs.
+     */
+    size_t size() const { return index_.size(); }
+
+    /**
+     * @brief The index of every chunk in the packs.
+     */
+    const ChunkIndex& index() const { return index_; }
+
+    static std::filesystem::path pack_path(const std::filesystem::path& packs_dir, uint32_t pack_id);
+    static std::filesystem::path index_path(const std::filesystem::path& packs_dir, uint32_t pack_id);
+
+private:
+    void load_pack(uint32_t pack_id, uint64_t indexed_end, bool reopen_for_append);
+    void open_new_pack();
+    void write_active_index();
+
+    std::filesystem::path packs_dir_;
+    uint64_t target_pack_size_;
+    RecordCheck check_recovered_;
+
+    ChunkIndex index_;
+
+    // The pack currently being appended to (none while active_id_ is 0).
+    uint32_t active_id_ = 0;
+    uint32_t last_id_ = 0;
+    std::ofstream active_;
+    uint64_t active_size_ = 0;
+    std::vector<std::pair<Digest, PackLocation>> active_entries_;
+    bool active_index_dirty_ = false;
+};
+
+} // namespace dv
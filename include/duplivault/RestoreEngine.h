@@ -0,0 +1,85 @@
+// include/duplivault/RestoreEngine.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+#include "Manifest.h"
+
+namespace dv {
+
+class ChunkCache;
+class Metrics;
+class StorageRepository;
+
+// One file to restore: its manifest and where to write it.
+struct RestoreItem {
+    Manifest manifest;
+    std::filesystem::path destination;
+};
+
+/**
+ * @brief Restores many files at once, reading the repository in storage
+ *        order rather than file by file.
+ *
+ * Files are handled in batches of up to MAX_OPEN_FILES. For a batch, the
+ * location of every chunk is resolved up front and each distinct chunk is
+ * read once, however many files (or places in one file) use it. Reads are
+ * sorted by pack and offset, and neighbouring ones are merged into spans
+ * of up to READ_SPAN_SIZE, so each pack is read front to back in large
+ * requests. All I/O goes through the repository's IoBackend in batches:
+ * the spans are read a window (up to READ_WINDOW_SIZE) at a time, and
+ * every chunk of a window is written straight to its offset in each
+ * destination file with positional writes, in the same batch as the
+ * reads of the next window. Many requests are in flight at once, and
+ * files fill in parallel and in any order. Compressed chunks are decoded
+ * between their read and their writes; the cache holds them decoded.
+ *
+ * With a ChunkCache, chunks that later batches need again are kept in it
+ * when read, and every chunk is looked up there before it is read, so a
+ * chunk repeated across the whole restore (say, a zeroed block in many
+ * disk images) comes from disk once while it stays cached. Chunks no
+ * later batch uses are not cached at all.
+ *
+ * A file with a chunk that cannot be found or read is removed again and
+ * reported; the other files are unaffected.
+ */
+class RestoreEngine {
+public:
+    static constexpr size_t MAX_OPEN_FILES = 256;
+    static constexpr size_t READ_SPAN_SIZE = 4 * 1024 * 1024; // 4 MB
+    // Neighbouring reads closer than this are merged, reading the gap
+    // (e.g. pack record headers) rather than issuing another request.
+    static constexpr size_t MAX_READ_GAP = 64 * 1024;
+    static constexpr size_t READ_WINDOW_SIZE = 32 * 1024 * 1024; // 32 MB
+    static constexpr size_t MAX_WINDOW_SPANS = 64;
+
+    /**
+     * @param cache Used if set; must outlive the engine.
+     * @param metrics Receives read and decode timings and restore
+     *        counters if set; must outlive the engine.
+     */
+    explicit RestoreEngine(StorageRepository& repo, ChunkCache* cache = nullptr, Metrics* metrics = nullptr);
+
+    /**
+     * @brief Writes every item's file. An item whose destination is also
+     *        that of a later item is skipped.
+     * @return The number of files restored.
+     */
+    size_t restore(const std::vector<RestoreItem>& items);
+
+private:
+    // 'batches_left' counts, per chunk, the batches from this one on that
+    // use it (only kept with a cache).
+    size_t restore_batch(const std::vector<const RestoreItem*>& batch,
+                         std::unordered_map<Digest, uint32_t>& batches_left);
+
+    StorageRepository& repo_;
+    ChunkCache* cache_;
+    Metrics* metrics_;
+};
+
+} // namespace dv
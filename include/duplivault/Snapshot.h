@@ -0,0 +1,122 @@
+// include/duplivault/Snapshot.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ByteSpan.h"
+#include "Digest.h"
+
+namespace dv {
+
+enum class TreeEntryType : uint8_t {
+    File = 0,      // 'ref' is the file's manifest.
+    Directory = 1, // 'ref' is another tree.
+};
+
+struct TreeEntry {
+    std::string name;
+    TreeEntryType type = TreeEntryType::File;
+    Digest ref;
+};
+
+/**
+ * @brief One directory of a snapshot: its entries, sorted by name.
+ *
+ * Trees are content-addressed blobs in the packs, like manifests, so a
+ * directory whose contents did not change between two snapshots encodes
+ * to the same bytes and is stored once. A snapshot therefore adds only the
+ * manifests of changed files and the trees on their paths to the root.
+ *
+ * Layout: "DVTR" | version u8 | reserved u8[3] | entry count varint, then
+ * per entry: type u8 | name length varint | name | 32-byte ref.
+ */
+struct Tree {
+    static constexpr uint8_t VERSION = 1;
+
+    std::vector<TreeEntry> entries;
+
+    std::vector<std::byte> serialize() const;
+
+    /**
+     * @throws std::runtime_error if 'bytes' is not a valid tree.
+     */
+    static Tree parse(ByteSpan bytes);
+};
+
+/**
+ * @brief An immutable record of one backup: when it ran, what it backed up
+ *        and the root of its tree.
+ *
+ * Stored as snapshots/<id>, where the id is the hex SHA-256 of the
+ * serialized snapshot.
+ *
+ * Layout: "DVSN" | version u8 | reserved u8[3] | time_ns i64 | root [32] |
+ * file count varint | source path length varint | source path.
+ */
+struct Snapshot {
+    static constexpr uint8_t VERSION = 1;
+
+    std::string id;          // Not serialized; set when stored or loaded.
+    int64_t time_ns = 0;     // system_clock time the backup finished.
+    std::string source_path; // Canonical path of the backed-up directory.
+    Digest root;
+    uint64_t file_count = 0;
+
+    std::vector<std::byte> serialize() const;
+
+    /**
+     * @throws std::runtime_error if 'bytes' is not a valid snapshot.
+     */
+    static Snapshot parse(ByteSpan bytes);
+};
+
+/**
+ * @brief Builds the trees for a set of files and returns the root's ref.
+ * @param files (relative path with '/' separators, manifest ref) pairs,
+ *        in any order.
+ * @param store_tree Stores a tree and returns its ref. Called children
+ *        first, once per directory.
+ */
+Digest build_trees(const std::vector<std::pair<std::string, Digest>>& files,
+                   const std::function<Digest(const Tree&)>& store_tree);
+
+// A directory whose tree is already stored, taken over as it is.
+struct Subtree {
+    std::string path; // Relative, with '/' separators.
+    Digest ref;
+    uint64_t files = 0; // Files in it and below.
+};
+
+/**
+ * @brief As above, but with whole directories taken over from 'subtrees'
+ *        rather than built, so only the directories on the way from the
+ *        root to a file in 'files' are encoded.
+ * @param store_tree Stores the tree of the directory at 'path' ("" for
+ *        the root), which holds 'files' files in all, and returns its ref.
+ *        Called children first, once per directory not in 'subtrees'.
+ */
+Digest build_trees(const std::vector<std::pair<std::string, Digest>>& files, const std::vector<Subtree>& subtrees,
+                   const std::function<Digest(const std::string& path, const Tree&, uint64_t files)>& store_tree);
+
+/**
+ * @brief Calls fn(relative path, manifest ref) for every file under
+ *        'root', in path order.
+ */
+void walk_trees(const Digest& root, const std::function<Tree(const Digest&)>& load_tree,
+                const std::function<void(const std::string&, const Digest&)>& fn);
+
+/**
+ * @brief Looks up one file by its relative path, loading only the trees
+ *        on the way to it.
+ * @return Its manifest ref, or std::nullopt if there is no such file.
+ */
+std::optional<Digest> find_in_trees(const Digest& root, const std::string& relative_path,
+                                    const std::function<Tree(const Digest&)>& load_tree);
+
+} // namespace dv
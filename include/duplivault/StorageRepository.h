@@ -7,9 +7,22 @@
 #include <cstddef> // For std::byte
 #include <stdexcept>
 #include <optional> // <-- Added for std::optional
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
 
 // Keep this include for the 'Chunk' type definition
 #include "Chunker.h"
+#include "Digest.h"
+#include "BloomFilter.h"
+#include "BufferPool.h"
+#include "Catalog.h"
+#include "Compression.h"
+#include "IoBackend.h"
+#include "Manifest.h"
+#include "Snapshot.h"
 
 // JSON support (nlohmann/json)
 #include "json.hpp"
@@ -17,54 +30,288 @@ using json = nlohmann::json;
 
 namespace dv {
 
+class PackStore;
+
+// How chunk_exists() lookups were answered since the repository was opened.
+struct FilterStats {
+    uint64_t definitely_new = 0;  // Rejected by the filter alone.
+    uint64_t confirmed = 0;       // Passed the filter and found in the index.
+    uint64_t false_positives = 0; // Passed the filter, but not stored.
+};
+
+// A directory's tree as of the last backup that went through it.
+struct DirectoryRecord {
+    FileStat stat;      // Its size is not kept; the catalog holds "files" there.
+    Digest tree;        // Zero if no file is under the directory.
+    uint64_t files = 0; // Files in it and below.
+    bool racy = false;
+
+    // True if the directory's own entries are as they were; its files and
+    // subdirectories are checked on their own.
+    bool unchanged(const FileStat& current) const {
+        return !racy && stat.mod_time_ns == current.mod_time_ns && stat.change_time_ns == current.change_time_ns &&
+               stat.inode == current.inode && stat.device == current.device;
+    }
+};
+
+// Where a chunk's stored bytes are: a range of a pack, or a whole loose
+// object file.
+struct ChunkSource {
+    std::filesystem::path file;
+    uint64_t offset = 0;
+    uint32_t length = 0; // Stored length, which is the raw length only for Raw.
+    ChunkCodec codec = ChunkCodec::Raw;
+};
+
+/**
+ * @brief The on-disk repository: chunks, per-file metadata and config.
+ *
+ * Each backed-up file has a manifest (see Manifest), stored in the packs
+ * like a chunk and found through the catalog (catalog.bin, see Catalog),
+ * which maps the file's canonical path (see canonical_file_path()) to its
+ * stat and manifest digest.
+ * Repositories written before the catalog existed kept one metadata file
+ * per path under metadata/; those are still read, and each is dropped
+ * once its file has been backed up again.
+ *
+ * Every backup also records an immutable snapshot under snapshots/ (see
+ * Snapshot), whose trees point at the manifests as they were then, so
+ * older versions of a file stay restorable.
+ *
+ * Chunks are appended to pack files under packs/ (see PackStore).
+ * Repositories written before packs existed keep each chunk as its own
+ * file under objects/xx/; those "loose" objects are still read, and
+ * migrate_loose_objects() moves them into packs.
+ *
+ * Opening a repository loads the chunk index (and lists any loose
+ * objects), so chunk_exists() never touches the filesystem. A Bloom
+ * filter over every stored digest, kept in chunk-filter.bin, answers most
+ * lookups for new chunks before the index is probed. It is rebuilt from
+ * the index when it is missing, out of date, or full.
+ *
+ * The chunk functions may be called from several threads at once.
+ * Lookups share a lock; only stores take it exclusively.
+ */
 class StorageRepository {
 public:
     /**
      * @brief Constructs a repository manager for a given path.
      * @param repo_path The root path of the DupliVault repository.
+     * @param target_pack_size A new pack file is started once the current
+     *        one grows past this many bytes.
+     */
+    explicit StorageRepository(std::filesystem::path repo_path,
+                               uint64_t target_pack_size = 64 * 1024 * 1024);
+
+    /**
+     * @brief Flushes any buffered pack data, indexes and the filter.
      */
-    explicit StorageRepository(std::filesystem::path repo_path);
+    ~StorageRepository();
+
+    StorageRepository(const StorageRepository&) = delete;
+    StorageRepository& operator=(const StorageRepository&) = delete;
 
     /**
      * @brief Initializes the repository by creating the necessary directory structure.
+     * @param engine The chunking engine all backups into this repository use.
+     *        It is recorded in the repository's config file.
+     * @throws std::runtime_error if the repository already exists with a
+     *         different engine.
      */
-    void init();
+    void init(ChunkingEngine engine = ChunkingEngine::Buzhash);
+
+    /**
+     * @brief Reads the chunking engine recorded at init time. Repositories
+     *        created before engines were selectable have no config and
+     *        are Buzhash.
+     */
+    ChunkingEngine chunking_engine() const;
 
     /**
      * @brief Checks if a chunk with the given hash already exists in storage.
-     * @param hash The hex-encoded SHA-256 hash of the chunk.
+     * @param hash The SHA-256 digest of the chunk.
      * @return True if the chunk exists, false otherwise.
      */
-    bool chunk_exists(const std::string& hash) const;
+    bool chunk_exists(const Digest& hash) const;
+
+    /**
+     * @brief Stores a chunk's data in the repository, compressed if that
+     *        pays off (see compress_chunk()).
+     * @param hash The SHA-256 digest of the chunk.
+     * @param chunk_data The binary data of the chunk to store (a Chunk or
+     *        a view into a larger buffer).
+     */
+    void store_chunk(const Digest& hash, ByteSpan chunk_data);
 
     /**
-     * @brief Stores a chunk's data in the repository.
-     * @param hash The hex-encoded SHA-256 hash of the chunk.
-     * @param chunk_data The binary data of the chunk to store.
+     * @brief Stores a chunk that the caller has already encoded, so that
+     *        compression can run on the caller's threads rather than under
+     *        the repository's lock.
+     * @param stored The chunk's bytes as encoded with 'codec'.
      */
-    void store_chunk(const std::string& hash, const Chunk& chunk_data);
+    void store_chunk(const Digest& hash, ByteSpan stored, ChunkCodec codec);
 
     /**
-     * @brief Retrieves a chunk's data from the repository.
-     * @param hash The hex-encoded SHA-256 hash of the chunk to retrieve.
+     * @brief Retrieves a chunk's data from the repository, decompressed.
+     * @param hash The SHA-256 digest of the chunk to retrieve.
      * @return A Chunk containing the binary data.
-     * @throws std::runtime_error if the chunk does not exist.
+     * @throws std::runtime_error if the chunk does not exist or is corrupt.
+     */
+    Chunk retrieve_chunk(const Digest& hash) const;
+
+    /**
+     * @brief Finds where a chunk's bytes are stored, so that a caller
+     *        reading many chunks can order and batch the reads itself. It
+     *        is then up to the caller to decode them.
+     * @return The location, or nothing if the chunk is not stored.
+     */
+    std::optional<ChunkSource> locate_chunk(const Digest& hash) const;
+
+    /**
+     * @brief Number of chunks stored, in packs and as loose objects.
+     */
+    size_t chunk_count() const;
+
+    /**
+     * @brief Writes buffered chunk data, the indexes, the filter and the
+     *        catalog to disk.
+     */
+    void flush();
+
+    /**
+     * @brief Rebuilds the chunk filter from the index, sized for twice the
+     *        current number of chunks.
+     */
+    void rebuild_filter();
+
+    /**
+     * @brief Counts of how chunk_exists() calls were answered.
      */
-    Chunk retrieve_chunk(const std::string& hash) const;
+    FilterStats filter_stats() const;
 
-    // --- Per-file metadata API (matches .cpp) ---
+    /**
+     * @brief The backend for batched chunk reads and file writes, e.g. by
+     *        a restore. Defaults to make_io_backend(IoBackendKind::Auto),
+     *        created on first use, so backups never set one up.
+     */
+    IoBackend& io() const;
+    void set_io_backend(std::unique_ptr<IoBackend> io);
 
     /**
-     * @brief Stores metadata for a specific file in the repository.
+     * @brief Moves every loose object under objects/ into packs and deletes
+     *        the loose files. Objects whose content does not match their
+     *        name are reported and left in place.
+     * @return The number of objects migrated.
+     */
+    size_t migrate_loose_objects();
+
+    // --- Per-file manifest API ---
+
+    /**
+     * @brief Looks a file up in the catalog, in memory. Files known only
+     *        from old per-path metadata files are not found.
+     * @param canonical_path The file's canonical path (the path is not
+     *        resolved here, so the lookup costs no system calls).
+     */
+    std::optional<CatalogEntry> find_file(const std::filesystem::path& canonical_path) const;
+
+    /**
+     * @brief Stores a file's manifest and points its catalog entry at it.
+     *        The catalog reaches disk on flush().
+     * @param canonical_path The file's canonical path.
+     * @param stat The file's stat, for the next backup's change check.
+     * @param racy Whether 'stat' was racy (see RACY_WINDOW_NS), so the
+     *        next backup must not trust it.
+     * @return The manifest's digest, for the snapshot's tree.
+     */
+    Digest store_manifest(const std::filesystem::path& canonical_path, const Manifest& manifest, const FileStat& stat,
+                          bool racy = false);
+
+    /**
+     * @brief Retrieves the manifest for a file, from the catalog or else
+     *        from an old per-path metadata file (binary or JSON).
+     * @return The manifest, or std::nullopt if the file was never backed up.
+     * @throws std::runtime_error if the stored manifest is corrupt.
+     */
+    std::optional<Manifest> retrieve_manifest(const std::filesystem::path& original_path);
+
+    /**
+     * @brief Reads every manifest in the repository: the catalog's in path
+     *        order, then any old per-path ones. Unreadable ones are
+     *        reported on stderr and skipped.
+     */
+    std::vector<Manifest> list_all_manifests();
+
+    /**
+     * @brief Reads a manifest blob from the packs into an owning Manifest,
+     *        as restores and dumps need. Callers that need only part of it
+     *        can wrap the blob from retrieve_chunk() in a ManifestView.
+     * @throws std::runtime_error if it is missing or corrupt.
+     */
+    Manifest load_manifest(const Digest& ref) const;
+
+    // --- Snapshot API ---
+
+    /**
+     * @brief Looks a directory up in the catalog, in memory, like find_file().
+     */
+    std::optional<DirectoryRecord> find_directory(const std::filesystem::path& canonical_path) const;
+
+    /**
+     * @brief Records the tree a backup built for a directory, so the next
+     *        backup can take it over if nothing under it changed. The
+     *        record of the directory's parent is invalidated if the tree
+     *        is new to it, as is a file's parent's by store_manifest(),
+     *        for backups of an ancestor that did not see the change.
+     */
+    void store_directory(const std::filesystem::path& canonical_path, const DirectoryRecord& record);
+
+    /**
+     * @brief Stores a tree blob, unless an identical one is already stored.
+     * @return The tree's digest.
+     */
+    Digest store_tree(const Tree& tree);
+
+    /**
+     * @throws std::runtime_error if the tree is missing or corrupt.
+     */
+    Tree load_tree(const Digest& ref) const;
+
+    /**
+     * @brief Flushes the repository, then records a snapshot whose trees
+     *        and manifests are stored already.
+     * @return The snapshot's id.
+     */
+    std::string store_snapshot(Snapshot snapshot);
+
+    /**
+     * @brief Every snapshot in the repository, oldest first. Unreadable
+     *        ones are reported on stderr and skipped.
+     */
+    std::vector<Snapshot> list_snapshots() const;
+
+    /**
+     * @brief Finds a snapshot by its id or a unique prefix of it.
+     * @throws std::runtime_error if none, or more than one, matches.
+     */
+    Snapshot find_snapshot(const std::string& id_prefix) const;
+
+    // --- JSON export of the manifests, for debugging and tools ---
+
+    /**
+     * @brief Stores metadata given in the JSON form of a Manifest. The
+     *        catalog records only its modification time.
      * @param original_path The original file path.
-     * @param metadata A JSON object containing metadata.
+     * @param metadata A JSON object as produced by Manifest::to_json().
+     * @throws std::invalid_argument if it is not a valid manifest.
      */
     void store_metadata(const std::filesystem::path& original_path, const json& metadata);
 
     /**
      * @brief Retrieves metadata for a specific file from the repository.
      * @param original_path The original file path.
-     * @return An optional JSON object with the metadata, or std::nullopt if not found.
+     * @return The manifest as JSON (see Manifest::to_json()), or
+     *         std::nullopt if not found.
      */
     std::optional<json> retrieve_metadata(const std::filesystem::path& original_path);
 
@@ -73,19 +320,64 @@ public:
 private:
     /**
      * @brief Helper function to determine the full path for a given chunk hash.
-     * @param hash The hex-encoded SHA-256 hash.
+     *        This is where a digest is turned into hex text.
+     * @param hash The SHA-256 digest.
      * @return The complete filesystem path for the chunk file.
      */
-    std::filesystem::path path_for_chunk(const std::string& hash) const;
+    std::filesystem::path path_for_chunk(const Digest& hash) const;
+
+    /**
+     * @brief Reads and writes packs; guarded by chunks_mutex_.
+     */
+    PackStore& packs() const { return *packs_; }
+
+    /**
+     * @brief Refills filter_ from packs_ and loose_objects_. Requires an
+     *        exclusive lock on chunks_mutex_.
+     */
+    void rebuild_filter_locked();
 
     /**
      * @brief Gets the full path for a metadata file for a given original file path.
      * @param original_path The original file path.
      * @return The complete filesystem path for the metadata file.
      */
-    std::filesystem::path path_for_metadata(const std::filesystem::path& original_path);
+    std::filesystem::path path_for_metadata(const std::filesystem::path& original_path) const;
+
+    /**
+     * @brief Stores a manifest or tree in the packs, content-addressed
+     *        like a chunk, unless it is there already.
+     */
+    Digest store_blob(ByteSpan bytes);
 
     std::filesystem::path root_path_;
+
+    // Guards packs_ and loose_objects_.
+    mutable std::shared_mutex chunks_mutex_;
+    std::unique_ptr<PackStore> packs_;
+    // Digests of the chunks stored as loose files under objects/.
+    std::unordered_set<Digest> loose_objects_;
+    BloomFilter filter_;
+    bool filter_dirty_ = false;
+
+    // Guards catalog_. Never held together with chunks_mutex_.
+    mutable std::shared_mutex catalog_mutex_;
+    Catalog catalog_;
+    // Whether metadata/ held per-path files when the repository was opened.
+    bool has_legacy_metadata_ = false;
+    // Files in metadata/ to delete once the catalog is saved.
+    std::vector<std::filesystem::path> superseded_metadata_;
+
+    // Guards io_, which io() creates lazily.
+    mutable std::mutex io_mutex_;
+    mutable std::unique_ptr<IoBackend> io_;
+
+    // Output buffers for store_chunk() to compress into.
+    BufferPool compress_buffers_{compress_bound(Chunker::MAX_CHUNK_SIZE), 16};
+
+    mutable std::atomic<uint64_t> definitely_new_{0};
+    mutable std::atomic<uint64_t> confirmed_{0};
+    mutable std::atomic<uint64_t> false_positives_{0};
 };
 
 } // namespace dv
\ No newline at end of file
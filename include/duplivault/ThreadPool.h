@@ -0,0 +1,66 @@
+// include/duplivault/ThreadPool.h
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dv {
+
+/**
+ * @brief A fixed set of worker threads for data-parallel loops.
+ *
+ * Used to spread the work on a single large file (boundary scanning and
+ * chunk hashing) over several cores.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts the workers.
+     * @param threads Number of worker threads. 0 starts none, and every
+     *        loop then runs on the calling thread.
+     */
+    explicit ThreadPool(unsigned threads);
+
+    /**
+     * @brief Waits for queued work to finish and stops the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Number of worker threads.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief Calls fn(i) for every i in [0, count), spread over the
+     *        workers and the calling thread, and returns when all calls
+     *        have finished.
+     *
+     * The calling thread always takes part, so this is safe to call from
+     * inside a pool task or while every worker is busy: it never waits for
+     * a worker to become free.
+     * @throws Rethrows the first exception thrown by 'fn'. Remaining
+     *         indices are skipped once a call has thrown.
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void enqueue(std::function<void()> task);
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable has_work_;
+};
+
+} // namespace dv
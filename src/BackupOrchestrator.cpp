@@ -1,141 +1,661 @@
 // src/BackupOrchestrator.cpp
 #include <duplivault/BackupOrchestrator.h>
+#include <duplivault/BufferPool.h>
 #include <duplivault/Chunker.h>
+#include <duplivault/Compression.h>
 #include <duplivault/Hasher.h>
+#include <duplivault/FileScan.h>
+#include <duplivault/MappedFile.h>
+#include <duplivault/Metrics.h>
+#include <duplivault/ChunkCache.h>
+#include <duplivault/RestoreEngine.h>
 #include <duplivault/StorageRepository.h>
+#include <duplivault/BoundedQueue.h>
+#include <duplivault/ThreadPool.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <optional>
-#include "json.hpp"
+#include <thread>
+#include <unordered_map>
+#include <variant>
 #include <chrono>
 
 namespace dv {
 
-BackupOrchestrator::BackupOrchestrator(const Chunker& chunker, const Hasher& hasher, StorageRepository& repo)
-    : chunker_(chunker), hasher_(hasher), repo_(repo) {}
+namespace {
 
-void BackupOrchestrator::run_backup(const std::filesystem::path& source_path) {
-    for (const auto& dir_entry : std::filesystem::recursive_directory_iterator(source_path)) {
-        if (!dir_entry.is_regular_file()) {
-            continue;
+// Serializes console output from the pipeline threads.
+std::mutex console_mutex;
+
+// A changed or new file the walker found, on its way to a worker.
+struct FileTask {
+    ScannedFile file;
+    std::optional<CatalogEntry> previous; // Its last backup, if any.
+};
+
+// The directory holding an entry, relative to the source like the entry.
+std::string parent_of(const std::string& relative_path) {
+    const size_t slash = relative_path.rfind('/');
+    return slash == std::string::npos ? std::string() : relative_path.substr(0, slash);
+}
+
+// Work for the storage writer. Items for one file arrive in order: its new
+// chunks first, then its metadata. An unchanged file sends only its
+// catalog entry's manifest, for the snapshot. A directory with nothing
+// changed under it sends its previous tree instead of its entries; one
+// with a change sends itself, after its entries, to have its tree
+// recorded once the trees are built.
+struct NewChunk {
+    Digest hash;
+    Chunk data; // Encoded with 'codec' by the worker, in a pooled buffer.
+    ChunkCodec codec = ChunkCodec::Raw;
+    size_t raw_size = 0;
+};
+struct FileMetadata {
+    ScannedFile file;
+    Manifest manifest;
+};
+struct UnchangedFile {
+    std::string relative_path;
+    Digest manifest;
+};
+using StoreTask = std::variant<NewChunk, FileMetadata, UnchangedFile, Subtree, ScannedDirectory>;
+
+// How many items each queue may hold before its producers wait.
+constexpr size_t FILE_QUEUE_CAPACITY = 1024;
+constexpr size_t STORE_QUEUE_CAPACITY = 256; // At most 8 MB of chunk data.
+
+// Chunks of a large file are hashed in groups of this many per task, so
+// the AVX2 backend can fill its 8 lanes.
+constexpr size_t HASH_GROUP_SIZE = 64;
+
+// Groups are hashed and compressed this many per thread at a time, and
+// handed to the writer before the next round starts, so the new chunks
+// in flight stay bounded however many a window holds.
+constexpr size_t HASH_GROUPS_PER_THREAD = 2;
+
+} // anonymous namespace
+
+BackupOrchestrator::BackupOrchestrator(const Chunker& chunker, const Hasher& hasher, StorageRepository& repo,
+                                       OrchestratorOptions options)
+    : chunker_(chunker), hasher_(hasher), repo_(repo), options_(options) {}
+
+std::string BackupOrchestrator::run_backup(const std::filesystem::path& source_path) {
+    // Mixing engines in one repository would silently break deduplication.
+    if (repo_.chunking_engine() != chunker_.engine()) {
+        throw std::runtime_error(std::string("Repository expects the '") + to_string(repo_.chunking_engine()) +
+                                 "' chunking engine, but the chunker uses '" + to_string(chunker_.engine()) + "'.");
+    }
+
+    BoundedQueue<FileTask> file_queue(FILE_QUEUE_CAPACITY);
+    BoundedQueue<StoreTask> store_queue(STORE_QUEUE_CAPACITY);
+
+    // The first exception from any stage stops the whole pipeline and is
+    // rethrown to the caller once every thread has finished.
+    std::mutex error_mutex;
+    std::exception_ptr first_error;
+    std::atomic<bool> stopped{false};
+    auto fail = [&](std::exception_ptr error) {
+        stopped = true;
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!first_error) first_error = error;
+        }
+        file_queue.close();
+        store_queue.close();
+    };
+
+    // --- Stage 1: walk the source tree and find what changed ---
+    // The scan stats each entry once, relative to its open directory, and
+    // the paths it builds under the canonical root are canonical too, so
+    // the catalog lookup needs no further system calls. Unchanged files go
+    // straight to the writer for the snapshot; only the rest reach workers.
+    // A directory's unchanged entries wait in 'pending' until the scan has
+    // reported all of it: if none of its files, subdirectories or own
+    // entries (its mtime) changed, its previous tree stands in for them.
+    struct PendingDirectory {
+        bool changed = false;
+        std::vector<StoreTask> entries; // UnchangedFile and Subtree items.
+    };
+    std::unordered_map<std::string, PendingDirectory> pending;
+    const auto source_root = std::filesystem::weakly_canonical(source_path);
+    std::thread walker([&]() {
+        try {
+            auto on_file = [&](ScannedFile&& file) {
+                metrics_.add(Counter::FilesScanned);
+                auto& parent = pending[parent_of(file.relative_path)];
+                auto existing = repo_.find_file(file.path);
+                if (existing && existing->unchanged(file.stat)) {
+                    metrics_.add(Counter::FilesUnchanged);
+                    if (options_.verbosity >= 1) {
+                        std::lock_guard<std::mutex> lock(console_mutex);
+                        std::cout << "Skipping unchanged file: " << file.path.string() << '\n';
+                    }
+                    parent.entries.push_back(UnchangedFile{std::move(file.relative_path), existing->manifest});
+                    return !stopped;
+                }
+                parent.changed = true;
+                // False once the pipeline is stopped.
+                return file_queue.push(FileTask{std::move(file), std::move(existing)});
+            };
+            auto on_directory = [&](ScannedDirectory&& directory) {
+                auto node = pending.extract(directory.relative_path);
+                PendingDirectory self = node.empty() ? PendingDirectory{} : std::move(node.mapped());
+                const bool is_root = directory.relative_path.empty();
+                const auto previous = repo_.find_directory(directory.path);
+                if (!self.changed && previous && previous->unchanged(directory.stat)) {
+                    Subtree tree{std::move(directory.relative_path), previous->tree, previous->files};
+                    if (is_root) {
+                        return store_queue.push(std::move(tree));
+                    }
+                    // A directory without files has no tree.
+                    if (tree.files > 0) {
+                        pending[parent_of(tree.path)].entries.push_back(std::move(tree));
+                    }
+                    return !stopped;
+                }
+                if (!is_root) {
+                    pending[parent_of(directory.relative_path)].changed = true;
+                }
+                for (auto& entry : self.entries) {
+                    if (!store_queue.push(std::move(entry))) return false;
+                }
+                return store_queue.push(std::move(directory));
+            };
+            scan_files(source_root, on_file, on_directory);
+            // Left over only where the scan does not report directories.
+            for (auto& [path, directory] : pending) {
+                for (auto& entry : directory.entries) {
+                    if (!store_queue.push(std::move(entry))) break;
+                }
+            }
+        } catch (...) {
+            fail(std::current_exception());
         }
+        file_queue.close();
+    });
 
-        const auto& file_path = dir_entry.path();
-        auto current_mod_time = std::filesystem::last_write_time(file_path);
-
-        // --- EFFICIENCY CHECK ---
-        auto existing_metadata_opt = repo_.retrieve_metadata(file_path);
-        if (existing_metadata_opt.has_value()) {
-            auto metadata = existing_metadata_opt.value();
-            auto stored_mod_time_ns = metadata.value("mod_time_ns", 0);
-            
-            // Explicitly create the duration and then the time_point to avoid IntelliSense issues
-            auto duration_since_epoch = std::filesystem::file_time_type::duration(stored_mod_time_ns);
-            auto stored_mod_time = std::filesystem::file_time_type(duration_since_epoch);
-            
-            if (stored_mod_time == current_mod_time) {
-                std::cout << "Skipping unchanged file: " << file_path.string() << std::endl;
+    // --- Stage 2: read, chunk and hash files ---
+    // Shared by workers that hit a large file. The calling worker always
+    // takes part, so 'jobs' threads in total work on a lone large file.
+    const unsigned jobs = std::max(1u, options_.jobs);
+    ThreadPool pool(jobs - 1);
+
+    // New chunks travel to the writer in recycled buffers, which it hands
+    // back once they are stored. Enough are kept to cover a full store
+    // queue plus a round of groups per thread, so once the pipeline has
+    // warmed up a new chunk costs no allocation.
+    BufferPool chunk_buffers(compress_bound(Chunker::MAX_CHUNK_SIZE),
+                             STORE_QUEUE_CAPACITY + size_t(jobs) * HASH_GROUPS_PER_THREAD * HASH_GROUP_SIZE);
+
+    // The number of leading chunks of 'previous' that an appended-to file
+    // still has, leaving 'stream' positioned after them; 0 to chunk the
+    // whole file. A boundary depends only on the chunk's start and the
+    // bytes up to the cut, so every cut before the old last chunk (which
+    // ended at end of file, not at a boundary) stays where it was. The
+    // chunk ending at the resume point is re-read to check the seam, and
+    // the first chunk and a few evenly spaced ones in between to catch
+    // files that were rewritten rather than appended to.
+    // 'offsets' are those of previous's chunks plus its end (empty if it
+    // has no lengths); 'hash_range' hashes a range of the file's current
+    // contents, or fails if the file no longer covers it.
+    using RangeHasher = std::function<std::optional<Digest>(uint64_t offset, size_t length)>;
+    auto reusable_chunks = [&](const FileTask& task, const ManifestView& previous, const std::vector<uint64_t>& offsets,
+                               const RangeHasher& hash_range) -> size_t {
+        constexpr size_t SAMPLES = 4;
+        const size_t count = previous.chunk_count();
+        if (count < 2 || offsets.size() != count + 1 || offsets.back() != task.previous->stat.size) {
+            return 0;
+        }
+        const size_t seam = count - 2;
+        size_t checked = count;
+        for (size_t sample = 0; sample <= SAMPLES; ++sample) {
+            const size_t i = seam * sample / SAMPLES;
+            if (i == checked) {
                 continue;
             }
+            checked = i;
+            if (hash_range(offsets[i], offsets[i + 1] - offsets[i]) != previous.chunk_hash(i)) {
+                return 0;
+            }
         }
-        
-        std::cout << "Processing file: " << file_path.string() << std::endl;
-        std::ifstream file_stream(file_path, std::ios::binary);
-        if (!file_stream) {
-            std::cerr << "Error: Could not open file " << file_path << std::endl;
-            continue;
+        return count - 1;
+    };
+
+    // 'stream_buffer' is the calling worker's, reused for every file it
+    // reads as a stream.
+    auto process_file = [&](FileTask& task, std::vector<std::byte>& stream_buffer) {
+        const auto& file_path = task.file.path;
+        const auto& stat = task.file.stat;
+
+        if (options_.verbosity >= 1) {
+            std::lock_guard<std::mutex> lock(console_mutex);
+            std::cout << "Processing file: " << file_path.string() << '\n';
+        }
+        // With map_files on, a regular file is mapped and chunked in place;
+        // anything else (everything, by default) is read through a stream into the
+        // chunker's fixed-size buffer. Either way chunks arrive as views,
+        // and only new chunks are copied, to hand them to the writer.
+        MappedFile mapped;
+        std::ifstream file_stream;
+        const bool is_mapped = options_.map_files && mapped.map(file_path);
+        if (!is_mapped) {
+            file_stream.open(file_path, std::ios::binary);
+            if (!file_stream) {
+                metrics_.add(Counter::FilesFailed);
+                {
+                    std::lock_guard<std::mutex> lock(console_mutex);
+                    std::cerr << "Error: Could not open file " << file_path << std::endl;
+                }
+                // The snapshot keeps the version the last backup stored, if
+                // any, rather than losing the file.
+                if (task.previous) {
+                    store_queue.push(UnchangedFile{std::move(task.file.relative_path), task.previous->manifest});
+                }
+                return;
+            }
+        }
+
+        Manifest manifest;
+        manifest.original_path = file_path.string();
+        manifest.mod_time_ns = stat.mod_time_ns;
+        manifest.chunk_hashes.reserve(stat.size / Chunker::AVG_CHUNK_SIZE + 1);
+        manifest.chunk_lengths.reserve(stat.size / Chunker::AVG_CHUNK_SIZE + 1);
+
+        uint64_t resume_at = 0;
+        const auto& previous = task.previous;
+        if (options_.append_aware && previous && previous->stat.inode == stat.inode &&
+            previous->stat.device == stat.device && previous->stat.size <= stat.size) {
+            // Read through a view: only the reused prefix is copied out,
+            // and nothing is when the file turns out to have been rewritten.
+            const Chunk previous_bytes = repo_.retrieve_chunk(previous->manifest);
+            const ManifestView previous_manifest(previous_bytes);
+            std::vector<uint64_t> offsets;
+            if (previous_manifest.has_lengths()) {
+                offsets.reserve(previous_manifest.chunk_count() + 1);
+                offsets.push_back(0);
+                for (uint32_t length : previous_manifest.chunk_lengths()) {
+                    offsets.push_back(offsets.back() + length);
+                }
+            }
+            auto hash_range = [&](uint64_t offset, size_t length) -> std::optional<Digest> {
+                if (is_mapped) {
+                    if (offset + length > mapped.size()) return std::nullopt;
+                    return hasher_.compute(mapped.data() + offset, length);
+                }
+                Chunk bytes(length);
+                file_stream.seekg(static_cast<std::streamoff>(offset));
+                if (!file_stream.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(length))) {
+                    return std::nullopt;
+                }
+                return hasher_.compute(bytes.data(), bytes.size());
+            };
+            if (const size_t reused = reusable_chunks(task, previous_manifest, offsets, hash_range)) {
+                for (size_t i = 0; i < reused; ++i) {
+                    manifest.chunk_hashes.push_back(previous_manifest.chunk_hash(i));
+                    manifest.chunk_lengths.push_back(static_cast<uint32_t>(offsets[i + 1] - offsets[i]));
+                }
+                resume_at = offsets[reused];
+                if (options_.verbosity >= 1) {
+                    std::lock_guard<std::mutex> lock(console_mutex);
+                    std::cout << "  Reusing " << reused << " unchanged chunks (" << resume_at << " bytes)\n";
+                }
+            }
+        }
+
+        // New chunks are compressed here, so that the writer only has to
+        // append them.
+        auto prepare_chunk = [&](const Digest& hash, ByteSpan chunk) -> std::optional<NewChunk> {
+            StageTimer lookup(&metrics_, Stage::Lookup);
+            const bool exists = repo_.chunk_exists(hash);
+            lookup.stop();
+            if (exists) {
+                return std::nullopt;
+            }
+            NewChunk new_chunk{hash, chunk_buffers.acquire(), ChunkCodec::Raw, chunk.size};
+            if (options_.compress) {
+                StageTimer compress(&metrics_, Stage::Compress);
+                new_chunk.codec = compress_chunk(chunk, new_chunk.data);
+            }
+            if (new_chunk.codec == ChunkCodec::Raw) {
+                new_chunk.data.assign(chunk.data, chunk.data + chunk.size);
+            }
+            return new_chunk;
+        };
+
+        auto handle_chunk = [&](const Digest& hash, ByteSpan chunk, std::optional<NewChunk> new_chunk) {
+            manifest.chunk_hashes.push_back(hash);
+            manifest.chunk_lengths.push_back(static_cast<uint32_t>(chunk.size));
+            metrics_.add(Counter::Chunks);
+            metrics_.add(Counter::BytesIn, chunk.size);
+            metrics_.chunk_sizes().record(chunk.size);
+
+            if (new_chunk) {
+                store_queue.push(std::move(*new_chunk));
+            } else if (options_.verbosity >= 2) {
+                std::lock_guard<std::mutex> lock(console_mutex);
+                std::cout << "  Chunk already exists: " << hash << '\n';
+            }
+        };
+
+        if (!is_mapped) {
+            file_stream.clear();
+            file_stream.seekg(static_cast<std::streamoff>(resume_at));
+        }
+
+        // What the chunker does between two calls back is find the next
+        // chunks (reading them in, for a stream).
+        StageTimer chunking(&metrics_, Stage::Chunk);
+
+        // A large file gets every core: each window is scanned in segments
+        // on the pool, then its chunks are hashed and compressed in groups,
+        // a round of groups at a time.
+        auto hash_batch = [&](const std::byte* base, const std::vector<ChunkBoundary>& chunks) {
+            chunking.stop(chunks.size());
+            const size_t groups = (chunks.size() + HASH_GROUP_SIZE - 1) / HASH_GROUP_SIZE;
+            const size_t round = HASH_GROUPS_PER_THREAD * (pool.size() + 1);
+            const size_t round_chunks = std::min(chunks.size(), round * HASH_GROUP_SIZE);
+            std::vector<Digest> digests(round_chunks);
+            std::vector<std::optional<NewChunk>> new_chunks(round_chunks);
+            for (size_t first_group = 0; first_group < groups; first_group += round) {
+                // Chunk indices in this round are relative to 'start'.
+                const size_t start = first_group * HASH_GROUP_SIZE;
+                const size_t end = std::min(chunks.size(), start + round_chunks);
+                pool.parallel_for(std::min(round, groups - first_group), [&](size_t g) {
+                    const size_t first = g * HASH_GROUP_SIZE;
+                    const size_t count = std::min(HASH_GROUP_SIZE, end - start - first);
+                    std::array<ByteSpan, HASH_GROUP_SIZE> spans;
+                    for (size_t i = 0; i < count; ++i) {
+                        const auto& boundary = chunks[start + first + i];
+                        spans[i] = ByteSpan(base + boundary.offset, boundary.length);
+                    }
+                    StageTimer hashing(&metrics_, Stage::Hash);
+                    hasher_.compute_many(spans.data(), count, digests.data() + first);
+                    hashing.stop(count);
+                    for (size_t i = 0; i < count; ++i) {
+                        new_chunks[first + i] = prepare_chunk(digests[first + i], spans[i]);
+                    }
+                });
+                for (size_t i = start; i < end; ++i) {
+                    handle_chunk(digests[i - start], ByteSpan(base + chunks[i].offset, chunks[i].length),
+                                 std::move(new_chunks[i - start]));
+                }
+            }
+            chunking.restart();
+        };
+        auto hash_chunk = [&](ByteSpan chunk) {
+            chunking.stop();
+            StageTimer hashing(&metrics_, Stage::Hash);
+            const Digest hash = hasher_.compute(chunk.data, chunk.size);
+            hashing.stop();
+            handle_chunk(hash, chunk, prepare_chunk(hash, chunk));
+            chunking.restart();
+        };
+
+        // The mapping may have caught the file at a different size than the
+        // scan did; chunk what is there now, as the stream would.
+        const uint64_t remaining = is_mapped ? mapped.size() - std::min<uint64_t>(resume_at, mapped.size())
+                                             : stat.size - resume_at;
+        const bool split = pool.size() > 0 && remaining >= options_.split_file_size;
+        if (is_mapped) {
+            const std::byte* data = mapped.data() + (mapped.size() - remaining);
+            if (split) {
+                chunker_.chunk(data, remaining, pool, hash_batch);
+            } else {
+                chunker_.for_each_chunk(data, remaining, hash_chunk);
+            }
+        } else if (split) {
+            chunker_.chunk(file_stream, pool, hash_batch);
+        } else {
+            chunker_.chunk(file_stream, hash_chunk, stream_buffer);
         }
+        chunking.cancel(); // Past the last chunk.
 
-        std::vector<Chunk> chunks = chunker_.chunk(file_stream);
-        std::vector<std::string> chunk_hashes;
-        chunk_hashes.reserve(chunks.size());
+        store_queue.push(FileMetadata{std::move(task.file), std::move(manifest)});
+    };
 
-        for (const auto& chunk : chunks) {
-            std::string hash = hasher_.compute(chunk);
-            chunk_hashes.push_back(hash);
+    std::atomic<unsigned> workers_left{jobs};
 
-            if (!repo_.chunk_exists(hash)) {
-                std::cout << "  Storing new chunk: " << hash << std::endl;
-                repo_.store_chunk(hash, chunk);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < jobs; ++i) {
+        workers.emplace_back([&]() {
+            try {
+                std::vector<std::byte> stream_buffer;
+                while (auto task = file_queue.pop()) {
+                    if (stopped) break; // Don't drain the queue after a failure.
+                    process_file(*task, stream_buffer);
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+            // The last worker out tells the writer nothing more is coming.
+            if (--workers_left == 0) {
+                store_queue.close();
+            }
+        });
+    }
+
+    // --- Stage 3: write new chunks and metadata (on this thread) ---
+    // A single writer keeps repository writes sequential, and makes the
+    // re-check below enough to catch the same new chunk coming from two
+    // workers at once.
+    // (path relative to source_path, manifest) of every file the snapshot
+    // does not take over in an unchanged directory's tree.
+    std::vector<std::pair<std::string, Digest>> snapshot_files;
+    std::vector<Subtree> unchanged_trees;
+    std::optional<Subtree> unchanged_root;
+    std::vector<ScannedDirectory> changed_directories; // Children first.
+    try {
+        while (auto task = store_queue.pop()) {
+            if (auto* chunk = std::get_if<NewChunk>(&*task)) {
+                if (!repo_.chunk_exists(chunk->hash)) {
+                    StageTimer write(&metrics_, Stage::Write);
+                    repo_.store_chunk(chunk->hash, chunk->data, chunk->codec);
+                    write.stop();
+                    metrics_.add(Counter::NewChunks);
+                    metrics_.add(Counter::NewBytes, chunk->raw_size);
+                    metrics_.add(Counter::StoredBytes, chunk->data.size());
+                    if (options_.verbosity >= 2) {
+                        std::lock_guard<std::mutex> lock(console_mutex);
+                        std::cout << "  Storing new chunk: " << chunk->hash << '\n';
+                    }
+                }
+                chunk_buffers.release(std::move(chunk->data));
+            } else if (auto* metadata = std::get_if<FileMetadata>(&*task)) {
+                const auto& file = metadata->file;
+                StageTimer store(&metrics_, Stage::Metadata);
+                const Digest ref = repo_.store_manifest(file.path, metadata->manifest, file.stat, file.racy);
+                store.stop();
+                metrics_.add(Counter::FilesBackedUp);
+                snapshot_files.emplace_back(file.relative_path, ref);
+                if (options_.verbosity >= 1) {
+                    std::lock_guard<std::mutex> lock(console_mutex);
+                    std::cout << "  Saved metadata for " << file.path.filename() << '\n';
+                }
+            } else if (auto* unchanged = std::get_if<UnchangedFile>(&*task)) {
+                snapshot_files.emplace_back(std::move(unchanged->relative_path), unchanged->manifest);
+            } else if (auto* tree = std::get_if<Subtree>(&*task)) {
+                if (tree->path.empty()) {
+                    unchanged_root = std::move(*tree);
+                } else {
+                    unchanged_trees.push_back(std::move(*tree));
+                }
             } else {
-                // --- THIS IS THE FIX ---
-                // Add this else block to confirm when deduplication happens.
-                std::cout << "  Chunk already exists: " << hash << std::endl;
+                changed_directories.push_back(std::move(std::get<ScannedDirectory>(*task)));
             }
         }
+        repo_.flush();
+    } catch (...) {
+        fail(std::current_exception());
+    }
 
-        // --- METADATA GENERATION ---
-        nlohmann::json metadata;
-        metadata["original_path"] = file_path.string();
-        metadata["mod_time_ns"] = current_mod_time.time_since_epoch().count();
-        metadata["chunk_hashes"] = chunk_hashes;
+    walker.join();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
 
-        repo_.store_metadata(file_path, metadata);
-        std::cout << "  Saved metadata for " << file_path.filename() << std::endl;
+    // --- Record the snapshot ---
+    // Only the trees of directories with a change under them are built;
+    // the others are taken over from the catalog as they were. Each built
+    // tree is recorded there for the next backup.
+    Snapshot snapshot;
+    snapshot.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count();
+    snapshot.source_path = source_root.string();
+    if (unchanged_root) {
+        snapshot.root = unchanged_root->ref;
+        snapshot.file_count = unchanged_root->files;
+    } else {
+        std::unordered_map<std::string, Subtree> built;
+        snapshot.root = build_trees(snapshot_files, unchanged_trees,
+                                    [&](const std::string& path, const Tree& tree, uint64_t files) {
+                                        metrics_.add(Counter::TreesStored);
+                                        const Digest ref = repo_.store_tree(tree);
+                                        built[path] = Subtree{path, ref, files};
+                                        return ref;
+                                    });
+        snapshot.file_count = built[""].files;
+        for (const auto& directory : changed_directories) {
+            const auto found = built.find(directory.relative_path);
+            const Subtree tree = found != built.end() ? found->second : Subtree{};
+            repo_.store_directory(directory.path, DirectoryRecord{directory.stat, tree.ref, tree.files, directory.racy});
+        }
     }
+    return repo_.store_snapshot(std::move(snapshot));
 }
 void BackupOrchestrator::run_restore(const std::filesystem::path& destination_dir, 
                                      const std::optional<std::filesystem::path>& original_path_opt) {
     
-    std::vector<nlohmann::json> metadatas_to_restore;
+    std::vector<Manifest> manifests_to_restore;
 
     if (original_path_opt.has_value()) {
         // --- Case 1: Restore a single, specific file ---
-        std::cout << "Attempting to restore single file: " << original_path_opt.value() << std::endl;
-        auto metadata_opt = repo_.retrieve_metadata(original_path_opt.value());
-        if (metadata_opt) {
-            metadatas_to_restore.push_back(metadata_opt.value());
+        if (options_.verbosity >= 1) {
+            std::cout << "Attempting to restore single file: " << original_path_opt.value() << std::endl;
+        }
+        auto manifest_opt = repo_.retrieve_manifest(original_path_opt.value());
+        if (manifest_opt) {
+            manifests_to_restore.push_back(std::move(*manifest_opt));
         }
     } else {
         // --- Case 2: Restore all files in the repository ---
-        std::cout << "Attempting to restore all files from repository..." << std::endl;
-        metadatas_to_restore = repo_.list_all_metadata();
+        if (options_.verbosity >= 1) {
+            std::cout << "Attempting to restore all files from repository..." << std::endl;
+        }
+        manifests_to_restore = repo_.list_all_manifests();
     }
 
-    if (metadatas_to_restore.empty()) {
-        std::cout << "No files found to restore." << std::endl;
+    if (manifests_to_restore.empty()) {
+        if (options_.verbosity >= 1) {
+            std::cout << "No files found to restore." << std::endl;
+        }
         return;
     }
 
     // Ensure the destination directory exists
     std::filesystem::create_directories(destination_dir);
 
-    for (const auto& metadata : metadatas_to_restore) {
-        std::filesystem::path original_path = metadata.value("original_path", "");
+    std::vector<RestoreItem> items;
+    for (auto& manifest : manifests_to_restore) {
+        std::filesystem::path original_path = manifest.original_path;
         if (original_path.empty()) continue;
 
         // The final destination for the file is the target dir + the original filename
         std::filesystem::path final_destination = destination_dir / original_path.filename();
         
-        std::cout << "Restoring '" << original_path.string() << "' to '" << final_destination.string() << "'" << std::endl;
-        
-        auto chunk_hashes = metadata["chunk_hashes"].get<std::vector<std::string>>();
-        
-        std::ofstream out_file(final_destination, std::ios::binary | std::ios::trunc);
-        if (!out_file) {
-            std::cerr << "  Error: Could not open destination file for writing: " << final_destination << std::endl;
-            continue; // Skip to next file
+        if (options_.verbosity >= 1) {
+            std::cout << "Restoring '" << original_path.string() << "' to '" << final_destination.string() << "'" << std::endl;
         }
+        items.push_back(RestoreItem{std::move(manifest), std::move(final_destination)});
+    }
+    restore_items(items);
+    if (options_.verbosity >= 1) {
+        std::cout << "Restore process complete." << std::endl;
+    }
+}
 
-        bool success = true;
-        for (const auto& hash : chunk_hashes) {
-            try {
-                Chunk chunk_data = repo_.retrieve_chunk(hash);
-                out_file.write(reinterpret_cast<const char*>(chunk_data.data()), chunk_data.size());
-            } catch (const std::exception& e) {
-                std::cerr << "  Fatal error restoring " << original_path.filename() << ": Could not retrieve chunk " << hash << ". Restore for this file aborted." << std::endl;
-                success = false;
-                break; // Stop processing chunks for this file
-            }
+void BackupOrchestrator::run_restore_snapshot(const std::string& snapshot_id,
+                                              const std::filesystem::path& destination_dir,
+                                              const std::optional<std::filesystem::path>& original_path_opt) {
+    const Snapshot snapshot = repo_.find_snapshot(snapshot_id);
+    auto load_tree = [&](const Digest& ref) { return repo_.load_tree(ref); };
+
+    // (relative path, manifest) of the files to restore.
+    std::vector<std::pair<std::string, Digest>> files;
+    if (original_path_opt.has_value()) {
+        const auto relative_path = canonical_file_path(original_path_opt.value())
+                                       .lexically_relative(snapshot.source_path)
+                                       .generic_string();
+        if (options_.verbosity >= 1) {
+            std::cout << "Attempting to restore single file: " << original_path_opt.value() << std::endl;
+        }
+        if (auto ref = find_in_trees(snapshot.root, relative_path, load_tree)) {
+            files.emplace_back(relative_path, *ref);
         }
+    } else {
+        if (options_.verbosity >= 1) {
+            std::cout << "Attempting to restore snapshot " << snapshot.id.substr(0, 8) << " of " << snapshot.source_path
+                      << "..." << std::endl;
+        }
+        walk_trees(snapshot.root, load_tree,
+                   [&](const std::string& path, const Digest& ref) { files.emplace_back(path, ref); });
+    }
 
-        out_file.close();
-        if (!success) {
-            // Clean up partially written file on error
-            std::filesystem::remove(final_destination);
+    if (files.empty()) {
+        if (options_.verbosity >= 1) {
+            std::cout << "No files found to restore." << std::endl;
+        }
+        return;
+    }
+
+    std::vector<RestoreItem> items;
+    for (const auto& [relative_path, ref] : files) {
+        Manifest manifest;
+        try {
+            manifest = repo_.load_manifest(ref);
+        } catch (const std::exception& e) {
+            std::cerr << "  Error: Corrupt manifest for " << relative_path << ": " << e.what() << std::endl;
+            continue;
+        }
+        const auto final_destination = destination_dir / std::filesystem::path(relative_path);
+        std::filesystem::create_directories(final_destination.parent_path());
+        if (options_.verbosity >= 1) {
+            std::cout << "Restoring '" << manifest.original_path << "' to '" << final_destination.string() << "'" << std::endl;
+        }
+        items.push_back(RestoreItem{std::move(manifest), final_destination});
+    }
+    restore_items(items);
+    if (options_.verbosity >= 1) {
+        std::cout << "Restore process complete." << std::endl;
+    }
+}
+
+void BackupOrchestrator::restore_items(const std::vector<RestoreItem>& items) {
+    std::unique_ptr<ChunkCache> cache;
+    if (options_.restore_cache_bytes > 0) {
+        cache = std::make_unique<ChunkCache>(options_.restore_cache_bytes);
+    }
+    RestoreEngine(repo_, cache.get(), &metrics_).restore(items);
+    if (cache) {
+        const auto stats = cache->stats();
+        metrics_.add(Counter::CacheHits, stats.hits);
+        metrics_.add(Counter::CacheMisses, stats.misses);
+        if (options_.verbosity >= 1 && stats.hits + stats.misses > 0) {
+            std::cout << "Chunk cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+                      << (100 * stats.hits / (stats.hits + stats.misses)) << "% hit rate), " << stats.evictions
+                      << " evictions." << std::endl;
         }
     }
-    std::cout << "Restore process complete." << std::endl;
 }
 
 } // namespace dv
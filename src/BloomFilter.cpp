@@ -0,0 +1,93 @@
+// src/BloomFilter.cpp
+#include <duplivault/BloomFilter.h>
+#include <duplivault/FileSync.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace dv {
+
+namespace {
+
+constexpr char FILTER_MAGIC[8] = {'D', 'V', 'B', 'L', 'M', '0', '0', '1'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct FilterHeader {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t reserved;
+    uint64_t blocks;
+    uint64_t keys;
+};
+static_assert(sizeof(FilterHeader) == 32, "FilterHeader is an on-disk format");
+
+uint64_t word_at(const Digest& hash, size_t offset) {
+    uint64_t w;
+    std::memcpy(&w, hash.bytes.data() + offset, sizeof(w));
+    return w;
+}
+
+} // anonymous namespace
+
+BloomFilter::BloomFilter(size_t capacity)
+    : blocks_(std::max<size_t>(1, (capacity * BITS_PER_KEY + BLOCK_BITS - 1) / BLOCK_BITS), Block{}) {}
+
+// The first 8 digest bytes are the chunk index's probe position, so the
+// filter uses the other three words: one picks the block, two generate
+// the bit positions within it by double hashing.
+void BloomFilter::insert(const Digest& hash) {
+    Block& block = blocks_[word_at(hash, 8) % blocks_.size()];
+    const uint64_t h1 = word_at(hash, 16);
+    const uint64_t h2 = word_at(hash, 24) | 1;
+    for (size_t i = 0; i < KEY_BITS; ++i) {
+        const uint64_t bit = (h1 + i * h2) >> 55; // Top 9 bits: 0..511.
+        block.words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    keys_++;
+}
+
+bool BloomFilter::may_contain(const Digest& hash) const {
+    const Block& block = blocks_[word_at(hash, 8) % blocks_.size()];
+    const uint64_t h1 = word_at(hash, 16);
+    const uint64_t h2 = word_at(hash, 24) | 1;
+    for (size_t i = 0; i < KEY_BITS; ++i) {
+        const uint64_t bit = (h1 + i * h2) >> 55;
+        if ((block.words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BloomFilter::load(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    FilterHeader header{};
+    if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, FILTER_MAGIC, sizeof(FILTER_MAGIC)) != 0 || header.byte_order != BYTE_ORDER_MARK ||
+        header.blocks == 0) {
+        return false;
+    }
+    std::vector<Block> blocks(header.blocks);
+    if (!in.read(reinterpret_cast<char*>(blocks.data()), static_cast<std::streamsize>(blocks.size() * sizeof(Block)))) {
+        return false;
+    }
+    blocks_.swap(blocks);
+    keys_ = header.keys;
+    return true;
+}
+
+void BloomFilter::save(const std::filesystem::path& path) const {
+    FilterHeader header{};
+    std::memcpy(header.magic, FILTER_MAGIC, sizeof(FILTER_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.blocks = blocks_.size();
+    header.keys = keys_;
+
+    write_file_atomically(path, "chunk filter", [&](std::ostream& out) {
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(blocks_.data()), static_cast<std::streamsize>(blocks_.size() * sizeof(Block)));
+    });
+}
+
+} // namespace dv
@@ -0,0 +1,43 @@
+// src/BufferPool.cpp
+#include <duplivault/BufferPool.h>
+
+namespace dv {
+
+BufferPool::BufferPool(size_t buffer_capacity, size_t max_free)
+    : buffer_capacity_(buffer_capacity), max_free_(max_free) {
+    free_.reserve(max_free_);
+}
+
+Chunk BufferPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            Chunk buffer = std::move(free_.back());
+            free_.pop_back();
+            return buffer;
+        }
+    }
+    Chunk buffer;
+    buffer.reserve(buffer_capacity_);
+    return buffer;
+}
+
+void BufferPool::release(Chunk&& buffer) {
+    // A buffer that grew for one oversized payload (e.g. a large manifest)
+    // would keep that memory for every chunk after it.
+    if (buffer.capacity() < buffer_capacity_ || buffer.capacity() > 2 * buffer_capacity_) {
+        return;
+    }
+    buffer.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.size() < max_free_) {
+        free_.push_back(std::move(buffer));
+    }
+}
+
+size_t BufferPool::free_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
+} // namespace dv
@@ -0,0 +1,207 @@
+// src/Catalog.cpp
+#include <duplivault/Catalog.h>
+#include <duplivault/FileSync.h>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace dv {
+
+namespace {
+
+constexpr char CATALOG_MAGIC[8] = {'D', 'V', 'C', 'A', 'T', '0', '0', '1'};
+constexpr uint32_t RACY_FLAG = 0x1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct CatalogHeader {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t string_bytes;
+};
+static_assert(sizeof(CatalogHeader) == 32, "CatalogHeader is an on-disk format");
+
+struct Record {
+    uint64_t path_offset;
+    uint32_t path_length;
+    uint32_t flags;
+    int64_t mod_time_ns;
+    int64_t change_time_ns;
+    uint64_t size;
+    uint64_t inode;
+    uint64_t device;
+    std::array<uint8_t, Digest::SIZE> manifest;
+};
+static_assert(sizeof(Record) == 88, "Record is an on-disk format");
+
+// The image is a byte buffer, so records are copied out rather than
+// accessed through a cast pointer.
+Record record_in(const std::vector<std::byte>& image, size_t i) {
+    Record record;
+    std::memcpy(&record, image.data() + sizeof(CatalogHeader) + i * sizeof(Record), sizeof(record));
+    return record;
+}
+
+} // anonymous namespace
+
+std::string_view Catalog::path_at(size_t i) const {
+    const Record record = record_in(image_, i);
+    return std::string_view(reinterpret_cast<const char*>(image_.data() + strings_at_ + record.path_offset),
+                            record.path_length);
+}
+
+CatalogEntry Catalog::entry_at(size_t i) const {
+    const Record record = record_in(image_, i);
+    CatalogEntry entry;
+    entry.path = std::string(path_at(i));
+    entry.stat.mod_time_ns = record.mod_time_ns;
+    entry.stat.change_time_ns = record.change_time_ns;
+    entry.stat.size = record.size;
+    entry.stat.inode = record.inode;
+    entry.stat.device = record.device;
+    entry.manifest.bytes = record.manifest;
+    entry.racy = (record.flags & RACY_FLAG) != 0;
+    return entry;
+}
+
+size_t Catalog::lower_bound(std::string_view path) const {
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (path_at(mid) < path) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+std::optional<CatalogEntry> Catalog::find(std::string_view path) const {
+    if (auto it = pending_.find(path); it != pending_.end()) {
+        return it->second;
+    }
+    const size_t i = lower_bound(path);
+    if (i < count_ && path_at(i) == path) {
+        return entry_at(i);
+    }
+    return std::nullopt;
+}
+
+void Catalog::insert(CatalogEntry entry) {
+    if (pending_.count(entry.path) == 0) {
+        const size_t i = lower_bound(entry.path);
+        if (i == count_ || path_at(i) != entry.path) {
+            added_++;
+        }
+    }
+    std::string key = entry.path;
+    pending_.insert_or_assign(std::move(key), std::move(entry));
+}
+
+void Catalog::for_each(const std::function<void(const CatalogEntry&)>& fn) const {
+    // Merge the two sorted sequences; a pending entry replaces a stored one.
+    size_t i = 0;
+    auto it = pending_.begin();
+    while (i < count_ || it != pending_.end()) {
+        if (it == pending_.end() || (i < count_ && path_at(i) < it->first)) {
+            fn(entry_at(i++));
+        } else {
+            if (i < count_ && path_at(i) == it->first) {
+                i++;
+            }
+            fn((it++)->second);
+        }
+    }
+}
+
+bool Catalog::load(const std::filesystem::path& path) {
+    image_.clear();
+    count_ = 0;
+    strings_at_ = 0;
+    pending_.clear();
+    added_ = 0;
+
+    std::error_code error;
+    const auto file_size = std::filesystem::file_size(path, error);
+    if (error || file_size < sizeof(CatalogHeader)) {
+        return false;
+    }
+    std::vector<std::byte> image(file_size);
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !in.read(reinterpret_cast<char*>(image.data()), static_cast<std::streamsize>(image.size()))) {
+        return false;
+    }
+
+    CatalogHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    if (std::memcmp(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0 || header.byte_order != BYTE_ORDER_MARK ||
+        header.record_size != sizeof(Record) ||
+        header.count > (file_size - sizeof(CatalogHeader)) / sizeof(Record) ||
+        sizeof(CatalogHeader) + header.count * sizeof(Record) + header.string_bytes != file_size) {
+        return false;
+    }
+    for (size_t i = 0; i < header.count; ++i) {
+        const Record record = record_in(image, i);
+        if (record.path_offset > header.string_bytes || record.path_length > header.string_bytes - record.path_offset) {
+            return false;
+        }
+    }
+
+    image_.swap(image);
+    count_ = header.count;
+    strings_at_ = sizeof(CatalogHeader) + count_ * sizeof(Record);
+    return true;
+}
+
+void Catalog::save(const std::filesystem::path& path) {
+    std::vector<Record> records;
+    std::string strings;
+    records.reserve(size());
+    for_each([&](const CatalogEntry& entry) {
+        Record record{};
+        record.path_offset = strings.size();
+        record.path_length = static_cast<uint32_t>(entry.path.size());
+        record.flags = entry.racy ? RACY_FLAG : 0;
+        record.mod_time_ns = entry.stat.mod_time_ns;
+        record.change_time_ns = entry.stat.change_time_ns;
+        record.size = entry.stat.size;
+        record.inode = entry.stat.inode;
+        record.device = entry.stat.device;
+        record.manifest = entry.manifest.bytes;
+        records.push_back(record);
+        strings += entry.path;
+    });
+
+    CatalogHeader header{};
+    std::memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.record_size = sizeof(Record);
+    header.count = records.size();
+    header.string_bytes = strings.size();
+
+    // Build the new image in memory: it is both what gets written and what
+    // later lookups run against.
+    std::vector<std::byte> image(sizeof(header) + records.size() * sizeof(Record) + strings.size());
+    std::memcpy(image.data(), &header, sizeof(header));
+    if (!records.empty()) {
+        std::memcpy(image.data() + sizeof(header), records.data(), records.size() * sizeof(Record));
+    }
+    if (!strings.empty()) {
+        std::memcpy(image.data() + sizeof(header) + records.size() * sizeof(Record), strings.data(), strings.size());
+    }
+
+    write_file_atomically(path, "catalog", [&](std::ostream& out) {
+        out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    });
+
+    image_.swap(image);
+    count_ = records.size();
+    strings_at_ = sizeof(header) + count_ * sizeof(Record);
+    pending_.clear();
+    added_ = 0;
+}
+
+} // namespace dv
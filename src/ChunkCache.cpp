@@ -0,0 +1,58 @@
+// src/ChunkCache.cpp
+#include <duplivault/ChunkCache.h>
+
+namespace dv {
+
+ChunkCache::ChunkCache(size_t capacity_bytes) : shard_capacity_(capacity_bytes / SHARDS) {}
+
+std::shared_ptr<const Chunk> ChunkCache::get(const Digest& hash) {
+    Shard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.entries.find(hash);
+    if (it == shard.entries.end()) {
+        shard.misses++;
+        return nullptr;
+    }
+    shard.hits++;
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->data;
+}
+
+void ChunkCache::put(const Digest& hash, ByteSpan data) {
+    if (data.size > shard_capacity_) {
+        return;
+    }
+    // Copy outside the lock.
+    auto copy = std::make_shared<const Chunk>(data.data, data.data + data.size);
+
+    Shard& shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (const auto it = shard.entries.find(hash); it != shard.entries.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return; // Another thread cached it first.
+    }
+    while (shard.bytes + data.size > shard_capacity_) {
+        const Entry& oldest = shard.lru.back();
+        shard.bytes -= oldest.data->size();
+        shard.entries.erase(oldest.hash);
+        shard.lru.pop_back();
+        shard.evictions++;
+    }
+    shard.lru.push_front(Entry{hash, std::move(copy)});
+    shard.entries.emplace(hash, shard.lru.begin());
+    shard.bytes += data.size;
+}
+
+ChunkCacheStats ChunkCache::stats() const {
+    ChunkCacheStats stats;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+} // namespace dv
@@ -0,0 +1,221 @@
+// src/ChunkIndex.cpp
+#include <duplivault/ChunkIndex.h>
+#include <duplivault/FileSync.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace dv {
+
+namespace {
+
+constexpr char TABLE_MAGIC[8] = {'D', 'V', 'C', 'I', 'X', '0', '0', '1'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr const char* TABLE_FILE = "chunk-index.tbl";
+constexpr const char* LOG_FILE = "chunk-index.log";
+
+constexpr size_t MIN_CAPACITY = 1024;
+// The log is folded into the table once it holds this many slots, or a
+// quarter of the table's entries if that is more.
+constexpr size_t MIN_LOG_BEFORE_COMPACTION = 64 * 1024;
+
+struct TableHeader {
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t slot_size;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t watermark_end;
+    uint32_t watermark_pack;
+    uint32_t reserved[5];
+};
+static_assert(sizeof(TableHeader) == 64, "TableHeader is an on-disk format");
+
+uint64_t slot_hash(const uint8_t* digest) {
+    uint64_t h;
+    std::memcpy(&h, digest, sizeof(h));
+    return h;
+}
+
+bool after(uint32_t pack_a, uint64_t end_a, const ChunkIndex::Watermark& b) {
+    return pack_a > b.pack_id || (pack_a == b.pack_id && end_a > b.end);
+}
+
+} // anonymous namespace
+
+ChunkIndex::ChunkIndex() {
+    clear();
+}
+
+void ChunkIndex::clear() {
+    slots_.assign(MIN_CAPACITY, Slot{});
+    count_ = 0;
+    watermark_ = {};
+    pending_.clear();
+    log_entries_ = 0;
+    table_stale_ = true;
+}
+
+size_t ChunkIndex::probe(const Digest& hash) const {
+    const size_t mask = slots_.size() - 1;
+    size_t i = slot_hash(hash.bytes.data()) & mask;
+    while (slots_[i].pack_id != 0 && std::memcmp(slots_[i].digest.data(), hash.bytes.data(), Digest::SIZE) != 0) {
+        i = (i + 1) & mask;
+    }
+    return i; // Either the matching slot or the empty one ending the run.
+}
+
+void ChunkIndex::place(const Slot& slot) {
+    if (slot.pack_id == 0) {
+        return; // An empty slot; there is nothing to insert.
+    }
+    Digest hash;
+    hash.bytes = slot.digest;
+    Slot& target = slots_[probe(hash)];
+    if (target.pack_id == 0) {
+        target = slot;
+        count_++;
+    }
+}
+
+void ChunkIndex::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{});
+    old.swap(slots_);
+    count_ = 0;
+    for (const Slot& slot : old) {
+        if (slot.pack_id != 0) {
+            place(slot);
+        }
+    }
+}
+
+std::optional<PackLocation> ChunkIndex::find(const Digest& hash) const {
+    const Slot& slot = slots_[probe(hash)];
+    if (slot.pack_id == 0) {
+        return std::nullopt;
+    }
+    return PackLocation{slot.pack_id, slot.offset, slot.length, slot.flags};
+}
+
+bool ChunkIndex::insert(const Digest& hash, const PackLocation& location) {
+    // Keep the load factor at or below 0.7 so probe runs stay short.
+    if ((count_ + 1) * 10 > slots_.size() * 7) {
+        grow();
+    }
+    Slot& slot = slots_[probe(hash)];
+    if (slot.pack_id != 0) {
+        return false;
+    }
+    slot = Slot{hash.bytes, location.offset, location.pack_id, location.length, location.flags, 0};
+    count_++;
+    pending_.push_back(slot);
+    cover(location.pack_id, location.offset + location.length);
+    return true;
+}
+
+void ChunkIndex::for_each(const std::function<void(const Digest&, const PackLocation&)>& fn) const {
+    for (const Slot& slot : slots_) {
+        if (slot.pack_id != 0) {
+            Digest hash;
+            hash.bytes = slot.digest;
+            fn(hash, PackLocation{slot.pack_id, slot.offset, slot.length, slot.flags});
+        }
+    }
+}
+
+void ChunkIndex::cover(uint32_t pack_id, uint64_t end) {
+    if (after(pack_id, end, watermark_)) {
+        watermark_ = {pack_id, end};
+    }
+}
+
+bool ChunkIndex::load(const std::filesystem::path& dir) {
+    clear();
+
+    std::ifstream table(dir / TABLE_FILE, std::ios::binary);
+    TableHeader header{};
+    if (!table || !table.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) != 0 || header.byte_order != BYTE_ORDER_MARK ||
+        header.slot_size != sizeof(Slot) || header.capacity < MIN_CAPACITY ||
+        (header.capacity & (header.capacity - 1)) != 0 || header.count > header.capacity) {
+        return false;
+    }
+
+    std::vector<Slot> slots(header.capacity);
+    if (!table.read(reinterpret_cast<char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(Slot)))) {
+        return false;
+    }
+    slots_.swap(slots);
+    count_ = header.count;
+    watermark_ = {header.watermark_pack, header.watermark_end};
+    table_stale_ = false;
+
+    // Replay the log. A partial slot at the end is from an interrupted
+    // save() and is ignored, and so is everything from the first empty
+    // slot on: a crash can leave the log's tail zero-filled.
+    std::ifstream log(dir / LOG_FILE, std::ios::binary);
+    Slot slot;
+    while (log && log.read(reinterpret_cast<char*>(&slot), sizeof(slot))) {
+        if (slot.pack_id == 0) {
+            break;
+        }
+        log_entries_++;
+        if ((count_ + 1) * 10 > slots_.size() * 7) {
+            grow();
+        }
+        place(slot);
+        cover(slot.pack_id, slot.offset + slot.length);
+    }
+    return true;
+}
+
+void ChunkIndex::save(const std::filesystem::path& dir) {
+    if (pending_.empty() && !table_stale_) {
+        return;
+    }
+    std::filesystem::create_directories(dir);
+
+    const size_t log_limit = std::max(MIN_LOG_BEFORE_COMPACTION, count_ / 4);
+    if (!table_stale_ && log_entries_ + pending_.size() <= log_limit) {
+        {
+            std::ofstream log(dir / LOG_FILE, std::ios::binary | std::ios::app);
+            if (!log.write(reinterpret_cast<const char*>(pending_.data()),
+                           static_cast<std::streamsize>(pending_.size() * sizeof(Slot))) ||
+                !log.flush()) {
+                throw std::runtime_error("Failed to append to chunk index log in " + dir.string());
+            }
+        }
+        // The first append creates the log, so its directory entry is synced too.
+        sync_file(dir / LOG_FILE);
+        sync_directory(dir);
+        log_entries_ += pending_.size();
+        pending_.clear();
+        return;
+    }
+
+    // Rewrite the whole table. It is written beside the old one and renamed
+    // over it, so a crash leaves either the old or the new table in place.
+    TableHeader header{};
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.slot_size = sizeof(Slot);
+    header.capacity = slots_.size();
+    header.count = count_;
+    header.watermark_pack = watermark_.pack_id;
+    header.watermark_end = watermark_.end;
+
+    write_file_atomically(dir / TABLE_FILE, "chunk index", [&](std::ostream& table) {
+        table.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        table.write(reinterpret_cast<const char*>(slots_.data()), static_cast<std::streamsize>(slots_.size() * sizeof(Slot)));
+    });
+
+    // Everything in the log is in the new table now. Should emptying it
+    // not reach the disk, replaying it again later is harmless.
+    std::ofstream log(dir / LOG_FILE, std::ios::binary | std::ios::trunc);
+    log_entries_ = 0;
+    pending_.clear();
+    table_stale_ = false;
+}
+
+} // namespace dv
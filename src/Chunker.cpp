@@ -1,7 +1,13 @@
 // src/Chunker.cpp
 #include <duplivault/Chunker.h>
+#include <duplivault/ThreadPool.h>
+#include "ChunkerKernels.h"
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <stdexcept>
 
 namespace dv {
 
@@ -11,20 +17,10 @@ namespace { // Use an anonymous namespace for implementation details
 // It's a private detail of the Chunker's implementation.
 struct RollingHash {
     // The size of the sliding window the hash is calculated over.
-    static constexpr size_t WINDOW_SIZE = 64;
+    static constexpr size_t WINDOW_SIZE = detail::HASH_WINDOW_SIZE;
     
     // A pre-computed table of random values for each possible byte value.
-    // Initialized once and reused.
-    const std::array<uint32_t, 256> T = []() {
-        std::array<uint32_t, 256> table{};
-        // A simple Linear Congruential Generator to produce pseudo-random numbers
-        uint64_t state = 1;
-        for (int i = 0; i < 256; ++i) {
-            state = state * 1103515245 + 12345;
-            table[i] = static_cast<uint32_t>(state >> 32);
-        }
-        return table;
-    }();
+    static constexpr const std::array<uint32_t, 256>& T = detail::BUZHASH_TABLE;
 
     // The current window of bytes.
     std::array<std::byte, WINDOW_SIZE> window{};
@@ -34,7 +30,7 @@ struct RollingHash {
     uint32_t hash = 0;
 
     // A helper function for circular left shift.
-    uint32_t s(uint32_t x) {
+    static uint32_t s(uint32_t x) {
         return (x << 1) | (x >> 31);
     }
 
@@ -53,61 +49,419 @@ struct RollingHash {
     }
 };
 
+// Because WINDOW_SIZE is a multiple of 32, a byte's contribution has
+// rotated all the way around by the time it leaves the window and cancels
+// out exactly. The hash after any byte is therefore a function of the last
+// WINDOW_SIZE bytes only, so we can start hashing WINDOW_SIZE bytes before
+// MIN_CHUNK_SIZE instead of at the chunk start and get identical cut points.
+static_assert(RollingHash::WINDOW_SIZE % 32 == 0, "window must cancel out under rotation");
+static_assert(Chunker::MIN_CHUNK_SIZE >= RollingHash::WINDOW_SIZE, "window must fit before the minimum");
+
+// The gear hash used by FastCDC: fp = (fp << 1) + G[byte]. One shift, one
+// add and one table lookup per byte, with no window to maintain, because
+// the shift pushes a byte's contribution out after 64 steps.
+struct GearHash {
+    static constexpr size_t WINDOW_SIZE = detail::HASH_WINDOW_SIZE;
+
+    static constexpr const std::array<uint64_t, 256>& G = detail::GEAR_TABLE;
+
+    uint64_t hash = 0;
+
+    void update(std::byte byte_in) {
+        hash = (hash << 1) + G[static_cast<size_t>(byte_in)];
+    }
+};
+
 } // anonymous namespace
 
-std::vector<Chunk> Chunker::chunk(std::istream& stream) const {
-    std::vector<Chunk> all_chunks;
-    Chunk current_chunk;
-    current_chunk.reserve(AVG_CHUNK_SIZE);
+namespace detail {
 
+size_t scan_buzhash_scalar(const std::byte* data, size_t limit) {
     RollingHash rh; // Create an instance of our rolling hash helper.
 
-    const size_t buffer_size = 4096;
-    std::vector<std::byte> buffer(buffer_size);
+    // Prime the window with the bytes just before the minimum size.
+    size_t i = Chunker::MIN_CHUNK_SIZE - RollingHash::WINDOW_SIZE;
+    for (; i < Chunker::MIN_CHUNK_SIZE - 1; ++i) {
+        rh.update(data[i]);
+    }
 
-    while (stream) {
-        stream.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-        size_t bytes_read = stream.gcount();
-        if (bytes_read == 0) {
-            break;
+    // Only consider cutting once we're past the minimum size.
+    for (; i < limit; ++i) {
+        rh.update(data[i]);
+        if ((rh.hash & Chunker::CHUNK_PATTERN) == 0) {
+            return i + 1;
         }
+    }
+    return 0;
+}
+
+size_t scan_fastcdc_scalar(const std::byte* data, size_t limit) {
+    GearHash gh;
 
-        for (size_t i = 0; i < bytes_read; ++i) {
-            const auto current_byte = buffer[i];
-            current_chunk.push_back(current_byte);
-
-            // Update the rolling hash with the new byte.
-            rh.update(current_byte);
-
-            bool should_cut = false;
-            
-            // Rule 1: Force a cut if we hit the maximum size.
-            if (current_chunk.size() >= MAX_CHUNK_SIZE) {
-                should_cut = true;
-            } 
-            // Rule 2: Only consider cutting if we're past the minimum size.
-            else if (current_chunk.size() >= MIN_CHUNK_SIZE) {
-                // --- THIS IS THE UPGRADED LOGIC ---
-                // We now check the rolling hash value against our pattern.
-                if ((rh.hash & CHUNK_PATTERN) == 0) {
-                    should_cut = true;
+    // Skip straight to the minimum size, as FastCDC does, but prime a full
+    // window first so every decision depends on the same 64 bytes no
+    // matter where the chunk started.
+    size_t i = Chunker::MIN_CHUNK_SIZE - GearHash::WINDOW_SIZE;
+    for (; i < Chunker::MIN_CHUNK_SIZE - 1; ++i) {
+        gh.update(data[i]);
+    }
+
+    // Normalized chunking: the strict mask below the average size...
+    const size_t normal = limit < Chunker::AVG_CHUNK_SIZE ? limit : Chunker::AVG_CHUNK_SIZE;
+    for (; i < normal; ++i) {
+        gh.update(data[i]);
+        if ((gh.hash & Chunker::FASTCDC_MASK_S) == 0) {
+            return i + 1;
+        }
+    }
+    // ...and the loose mask above it.
+    for (; i < limit; ++i) {
+        gh.update(data[i]);
+        if ((gh.hash & Chunker::FASTCDC_MASK_L) == 0) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace detail
+
+namespace {
+
+detail::ScanFn pick_scan(ChunkingEngine engine, ScanBackend backend) {
+    const bool fastcdc = engine == ChunkingEngine::FastCdc;
+    if (backend == ScanBackend::Avx2) {
+        return fastcdc ? detail::scan_fastcdc_avx2 : detail::scan_buzhash_avx2;
+    }
+    return fastcdc ? detail::scan_fastcdc_scalar : detail::scan_buzhash_scalar;
+}
+
+// Seconds taken to chunk 'data' end to end with one kernel.
+double time_scan(detail::ScanFn scan, const std::vector<std::byte>& data) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    size_t checksum = 0; // Keeps the work observable.
+    while (data.size() - offset >= Chunker::MAX_CHUNK_SIZE) {
+        size_t cut = scan(data.data() + offset, Chunker::MAX_CHUNK_SIZE);
+        cut = cut != 0 ? cut : Chunker::MAX_CHUNK_SIZE;
+        checksum += cut;
+        offset += cut;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return checksum != 0 ? elapsed.count() : 0.0;
+}
+
+// The vector kernels lean on AVX2 gathers, whose speed varies widely
+// between x86 parts; on some they are no faster than the scalar loop. So
+// the first Auto chunker for each engine times both kernels on a small
+// synthetic buffer and every later one reuses the winner.
+ScanBackend fastest_scan(ChunkingEngine engine) {
+    auto measure = [engine]() {
+        if (!detail::avx2_supported()) {
+            return ScanBackend::Scalar;
+        }
+        std::vector<std::byte> data(512 * 1024);
+        uint64_t state = 0x9e3779b97f4a7c15ULL;
+        for (auto& b : data) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            b = static_cast<std::byte>(state >> 56);
+        }
+        double scalar = 1e9, avx2 = 1e9;
+        for (int round = 0; round < 3; ++round) {
+            scalar = std::min(scalar, time_scan(pick_scan(engine, ScanBackend::Scalar), data));
+            avx2 = std::min(avx2, time_scan(pick_scan(engine, ScanBackend::Avx2), data));
+        }
+        return avx2 < scalar ? ScanBackend::Avx2 : ScanBackend::Scalar;
+    };
+    if (engine == ChunkingEngine::FastCdc) {
+        static const ScanBackend fastcdc = measure();
+        return fastcdc;
+    }
+    static const ScanBackend buzhash = measure();
+    return buzhash;
+}
+
+// A position where the rolling hash matches, recorded as the end offset of
+// the chunk that would be cut there. For FastCDC, every position matching
+// the loose mask is recorded and 'strong' says whether it also matches the
+// strict one (whose bits are a superset). Buzhash has only one pattern.
+struct Candidate {
+    size_t end;
+    bool strong;
+};
+
+static_assert((Chunker::FASTCDC_MASK_S & Chunker::FASTCDC_MASK_L) == Chunker::FASTCDC_MASK_L,
+              "a strict-mask match must also be a loose-mask match");
+
+// Records every candidate whose last byte lies in [begin, end). Reads from
+// WINDOW_SIZE - 1 bytes before 'begin', so 'begin' must be at least that.
+void collect_candidates(ChunkingEngine engine, const std::byte* data, size_t begin, size_t end,
+                        std::vector<Candidate>& out) {
+    size_t i = begin - (detail::HASH_WINDOW_SIZE - 1);
+    if (engine == ChunkingEngine::FastCdc) {
+        GearHash gh;
+        for (; i < begin; ++i) {
+            gh.update(data[i]);
+        }
+        for (; i < end; ++i) {
+            gh.update(data[i]);
+            if ((gh.hash & Chunker::FASTCDC_MASK_L) == 0) {
+                out.push_back({i + 1, (gh.hash & Chunker::FASTCDC_MASK_S) == 0});
+            }
+        }
+        return;
+    }
+    RollingHash rh;
+    for (; i < begin; ++i) {
+        rh.update(data[i]);
+    }
+    for (; i < end; ++i) {
+        rh.update(data[i]);
+        if ((rh.hash & Chunker::CHUNK_PATTERN) == 0) {
+            out.push_back({i + 1, true});
+        }
+    }
+}
+
+// Replays next_boundary() chunk by chunk over precomputed candidates,
+// appending to 'out'. Returns how many bytes the new chunks cover, which
+// is less than 'size' when the last cut needs more input to decide.
+size_t pick_cuts(ChunkingEngine engine, const std::vector<Candidate>& candidates, size_t size, bool at_eof,
+                 std::vector<ChunkBoundary>& out) {
+    size_t offset = 0;
+    size_t k = 0; // First candidate that could end the current chunk.
+    while (offset < size) {
+        const size_t remaining = size - offset;
+        const size_t limit = std::min(remaining, Chunker::MAX_CHUNK_SIZE);
+        while (k < candidates.size() && candidates[k].end < offset + Chunker::MIN_CHUNK_SIZE) {
+            ++k;
+        }
+
+        size_t cut = 0;
+        if (engine == ChunkingEngine::FastCdc) {
+            // The strict mask up to the average size, then the loose one.
+            const size_t normal = std::min(limit, Chunker::AVG_CHUNK_SIZE);
+            size_t j = k;
+            for (; j < candidates.size() && candidates[j].end <= offset + normal; ++j) {
+                if (candidates[j].strong) {
+                    cut = candidates[j].end - offset;
+                    break;
                 }
             }
+            if (cut == 0 && j < candidates.size() && candidates[j].end <= offset + limit) {
+                cut = candidates[j].end - offset;
+            }
+        } else if (k < candidates.size() && candidates[k].end <= offset + limit) {
+            cut = candidates[k].end - offset;
+        }
 
-            if (should_cut) {
-                all_chunks.push_back(std::move(current_chunk));
-                // current_chunk is now empty and ready for the next chunk.
-                current_chunk.reserve(AVG_CHUNK_SIZE);
+        if (cut == 0) {
+            if (remaining >= Chunker::MAX_CHUNK_SIZE) {
+                cut = Chunker::MAX_CHUNK_SIZE;
+            } else if (at_eof) {
+                cut = remaining;
+            } else {
+                break; // Needs more input.
             }
         }
+        out.push_back({offset, cut});
+        offset += cut;
     }
+    return offset;
+}
 
-    // After the loop, if there's any data left, add it as the final chunk.
-    if (!current_chunk.empty()) {
-        all_chunks.push_back(std::move(current_chunk));
+// The parallel equivalent of calling next_boundary() until it runs out of
+// input. Returns the number of bytes covered by the chunks added to 'out'.
+size_t find_boundaries_parallel(ChunkingEngine engine, const std::byte* data, size_t size, bool at_eof,
+                                ThreadPool& pool, std::vector<ChunkBoundary>& out) {
+    // No chunk can end before a full hash window, so scanning starts there.
+    const size_t first = detail::HASH_WINDOW_SIZE - 1;
+    const size_t scanned = size > first ? size - first : 0;
+    const size_t segments = (scanned + Chunker::PARALLEL_SEGMENT_SIZE - 1) / Chunker::PARALLEL_SEGMENT_SIZE;
+
+    std::vector<std::vector<Candidate>> found(segments);
+    pool.parallel_for(segments, [&](size_t s) {
+        const size_t begin = first + s * Chunker::PARALLEL_SEGMENT_SIZE;
+        const size_t end = std::min(begin + Chunker::PARALLEL_SEGMENT_SIZE, size);
+        collect_candidates(engine, data, begin, end, found[s]);
+    });
+
+    std::vector<Candidate> candidates;
+    for (const auto& segment : found) {
+        candidates.insert(candidates.end(), segment.begin(), segment.end());
     }
+    out.reserve(out.size() + size / Chunker::AVG_CHUNK_SIZE + 1);
+    return pick_cuts(engine, candidates, size, at_eof, out);
+}
 
+} // anonymous namespace
+
+const char* to_string(ChunkingEngine engine) {
+    switch (engine) {
+        case ChunkingEngine::Buzhash: return "buzhash";
+        case ChunkingEngine::FastCdc: return "fastcdc";
+    }
+    return "unknown";
+}
+
+std::optional<ChunkingEngine> parse_chunking_engine(std::string_view name) {
+    if (name == "buzhash") return ChunkingEngine::Buzhash;
+    if (name == "fastcdc") return ChunkingEngine::FastCdc;
+    return std::nullopt;
+}
+
+Chunker::Chunker(ChunkingEngine engine, ScanBackend scan)
+    : engine_(engine),
+      scan_backend_(scan != ScanBackend::Auto ? scan : fastest_scan(engine)) {
+    if (!is_supported(scan_backend_)) {
+        throw std::invalid_argument("Chunk scan backend is not supported by this CPU.");
+    }
+    scan_ = pick_scan(engine_, scan_backend_);
+}
+
+bool Chunker::is_supported(ScanBackend scan) {
+    switch (scan) {
+        case ScanBackend::Auto:
+        case ScanBackend::Scalar: return true;
+        case ScanBackend::Avx2: return detail::avx2_supported();
+    }
+    return false;
+}
+
+size_t Chunker::next_boundary(const std::byte* data, size_t size, bool at_eof) const {
+    const size_t limit = size < MAX_CHUNK_SIZE ? size : MAX_CHUNK_SIZE;
+
+    if (limit >= MIN_CHUNK_SIZE) {
+        const size_t cut = scan_(data, limit);
+        if (cut != 0) {
+            return cut;
+        }
+    }
+
+    // Force a cut if we hit the maximum size.
+    if (size >= MAX_CHUNK_SIZE) {
+        return MAX_CHUNK_SIZE;
+    }
+    // Otherwise the rest of the input is the final chunk, if we know it ends here.
+    return at_eof ? size : 0;
+}
+
+void Chunker::for_each_chunk(const std::byte* data, size_t size, const ChunkCallback& on_chunk) const {
+    size_t offset = 0;
+    while (offset < size) {
+        const size_t length = next_boundary(data + offset, size - offset, true);
+        on_chunk(ByteSpan(data + offset, length));
+        offset += length;
+    }
+}
+
+std::vector<ChunkBoundary> Chunker::find_boundaries(const std::byte* data, size_t size) const {
+    std::vector<ChunkBoundary> boundaries;
+    boundaries.reserve(size / AVG_CHUNK_SIZE + 1);
+    size_t offset = 0;
+    while (offset < size) {
+        const size_t length = next_boundary(data + offset, size - offset, true);
+        boundaries.push_back({offset, length});
+        offset += length;
+    }
+    return boundaries;
+}
+
+std::vector<ChunkBoundary> Chunker::find_boundaries(const std::byte* data, size_t size, ThreadPool& pool) const {
+    std::vector<ChunkBoundary> boundaries;
+    find_boundaries_parallel(engine_, data, size, true, pool, boundaries);
+    return boundaries;
+}
+
+void Chunker::chunk(std::istream& stream, const ChunkCallback& on_chunk) const {
+    std::vector<std::byte> buffer;
+    chunk(stream, on_chunk, buffer);
+}
+
+void Chunker::chunk(std::istream& stream, const ChunkCallback& on_chunk, std::vector<std::byte>& buffer) const {
+    static_assert(STREAM_BUFFER_SIZE >= MAX_CHUNK_SIZE, "buffer must hold a full chunk");
+
+    buffer.resize(STREAM_BUFFER_SIZE);
+    size_t begin = 0; // First byte not yet emitted.
+    size_t end = 0;   // One past the last byte read.
+    bool at_eof = false;
+
+    while (true) {
+        // Refill once less than a maximum-size chunk is buffered, so every
+        // boundary decision can be made without another read.
+        if (!at_eof && end - begin < MAX_CHUNK_SIZE) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            while (end < buffer.size()) {
+                stream.read(reinterpret_cast<char*>(buffer.data() + end), buffer.size() - end);
+                end += static_cast<size_t>(stream.gcount());
+                if (!stream) {
+                    at_eof = true;
+                    break;
+                }
+            }
+        }
+        if (begin == end) {
+            break;
+        }
+
+        const size_t length = next_boundary(buffer.data() + begin, end - begin, at_eof);
+        on_chunk(ByteSpan(buffer.data() + begin, length));
+        begin += length;
+    }
+}
+
+std::vector<Chunk> Chunker::chunk(std::istream& stream) const {
+    std::vector<Chunk> all_chunks;
+    chunk(stream, [&](ByteSpan piece) {
+        all_chunks.emplace_back(piece.data, piece.data + piece.size);
+    });
     return all_chunks;
 }
 
+void Chunker::chunk(std::istream& stream, ThreadPool& pool, const ChunkBatchCallback& on_batch) const {
+    static_assert(PARALLEL_WINDOW_SIZE >= MAX_CHUNK_SIZE, "window must hold a full chunk");
+
+    std::vector<std::byte> buffer(PARALLEL_WINDOW_SIZE);
+    std::vector<ChunkBoundary> batch;
+    size_t end = 0; // One past the last byte read.
+    bool at_eof = false;
+
+    while (true) {
+        while (!at_eof && end < buffer.size()) {
+            stream.read(reinterpret_cast<char*>(buffer.data() + end), buffer.size() - end);
+            end += static_cast<size_t>(stream.gcount());
+            if (!stream) {
+                at_eof = true;
+            }
+        }
+        if (end == 0) {
+            break;
+        }
+
+        // A full window always yields chunks: only the bytes after the last
+        // decided cut (less than MAX_CHUNK_SIZE) are carried over.
+        batch.clear();
+        const size_t consumed = find_boundaries_parallel(engine_, buffer.data(), end, at_eof, pool, batch);
+        on_batch(buffer.data(), batch);
+        std::memmove(buffer.data(), buffer.data() + consumed, end - consumed);
+        end -= consumed;
+    }
+}
+
+void Chunker::chunk(const std::byte* data, size_t size, ThreadPool& pool, const ChunkBatchCallback& on_batch) const {
+    // The same windows as the stream overload sees, without the copies.
+    std::vector<ChunkBoundary> batch;
+    size_t offset = 0;
+    while (offset < size) {
+        const size_t window = std::min(PARALLEL_WINDOW_SIZE, size - offset);
+        batch.clear();
+        const size_t consumed =
+            find_boundaries_parallel(engine_, data + offset, window, offset + window == size, pool, batch);
+        on_batch(data + offset, batch);
+        offset += consumed;
+    }
+}
+
 } // namespace dv
@@ -0,0 +1,197 @@
+// src/ChunkerAvx2.cpp
+// AVX2 boundary scanning. Both rolling hashes are linear recurrences,
+//   Buzhash: h[p] = rotl(h[p-1], 1) ^ T[b[p-64]] ^ T[b[p]]
+//   Gear:    h[p] = (h[p-1] << 1)   + G[b[p]]
+// so the hashes of a whole vector of consecutive positions can be derived
+// from the previous hash with a log-step prefix scan. The cut mask is then
+// tested on every lane at once and we only leave vector code to report the
+// first matching lane. Results are identical to the scalar kernels.
+#include "ChunkerKernels.h"
+#include "sha256.h" // For the shared runtime AVX2 probe.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define DV_TARGET(isa)
+#else
+#define DV_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace dv::detail {
+
+namespace {
+
+inline unsigned lowest_set_bit(unsigned bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+}
+
+inline uint32_t rotl32(uint32_t x, unsigned n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+// The FastCDC mask for the four positions starting at 'p'.
+DV_TARGET("avx2")
+inline __m256i mask_for(size_t p, size_t normal, __m256i mask_s, __m256i mask_l) {
+    if (p + 4 <= normal) return mask_s;
+    if (p >= normal) return mask_l;
+    const __m256i pos = _mm256_setr_epi64x(0, 1, 2, 3);
+    const __m256i below = _mm256_cmpgt_epi64(_mm256_set1_epi64x(static_cast<long long>(normal - p)), pos);
+    return _mm256_blendv_epi8(mask_l, mask_s, below);
+}
+
+// One bit per 64-bit lane whose hash has all 'mask' bits clear.
+DV_TARGET("avx2")
+inline unsigned hit_bits(__m256i hashes, __m256i mask) {
+    const __m256i hits = _mm256_cmpeq_epi64(_mm256_and_si256(hashes, mask), _mm256_setzero_si256());
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(hits)));
+}
+
+// Rotates every 32-bit lane left by a constant.
+#define DV_ROTL32(x, n) _mm256_or_si256(_mm256_slli_epi32((x), (n)), _mm256_srli_epi32((x), 32 - (n)))
+
+} // anonymous namespace
+
+DV_TARGET("avx2")
+size_t scan_buzhash_avx2(const std::byte* data, size_t limit) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    const auto* table = reinterpret_cast<const int*>(BUZHASH_TABLE.data());
+
+    // Hash of the full window ending just before the first candidate.
+    size_t p = Chunker::MIN_CHUNK_SIZE - 1;
+    uint32_t h = 0;
+    for (size_t i = p - HASH_WINDOW_SIZE; i < p; ++i) {
+        h = rotl32(h, 1) ^ BUZHASH_TABLE[bytes[i]];
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i pattern = _mm256_set1_epi32(static_cast<int>(Chunker::CHUNK_PATTERN));
+    const __m256i shift1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i shift2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+    const __m256i shift4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+    const __m256i carry_left = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+    const __m256i carry_right = _mm256_setr_epi32(31, 30, 29, 28, 27, 26, 25, 24);
+
+    for (; p + 8 <= limit; p += 8) {
+        // d[j] = T[leaving byte] ^ T[entering byte] for positions p..p+7.
+        const __m256i in = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + p)));
+        const __m256i out = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + p - HASH_WINDOW_SIZE)));
+        __m256i d = _mm256_xor_si256(_mm256_i32gather_epi32(table, in, 4), _mm256_i32gather_epi32(table, out, 4));
+
+        // Prefix scan: d[j] = XOR over i <= j of rotl(d[i], j - i).
+        d = _mm256_xor_si256(d, DV_ROTL32(_mm256_blend_epi32(_mm256_permutevar8x32_epi32(d, shift1), zero, 0x01), 1));
+        d = _mm256_xor_si256(d, DV_ROTL32(_mm256_blend_epi32(_mm256_permutevar8x32_epi32(d, shift2), zero, 0x03), 2));
+        d = _mm256_xor_si256(d, DV_ROTL32(_mm256_blend_epi32(_mm256_permutevar8x32_epi32(d, shift4), zero, 0x0F), 4));
+
+        // Fold in the previous hash, rotated once more for every lane.
+        const __m256i prev = _mm256_set1_epi32(static_cast<int>(h));
+        const __m256i carry = _mm256_or_si256(_mm256_sllv_epi32(prev, carry_left), _mm256_srlv_epi32(prev, carry_right));
+        const __m256i hashes = _mm256_xor_si256(d, carry);
+
+        const __m256i hits = _mm256_cmpeq_epi32(_mm256_and_si256(hashes, pattern), zero);
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(hits)));
+        if (mask != 0) {
+            return p + lowest_set_bit(mask) + 1;
+        }
+        // Advance the carried hash from the scan alone, so the loop-carried
+        // dependency is one rotate and one xor per 8 bytes.
+        h = rotl32(h, 8) ^ static_cast<uint32_t>(_mm256_extract_epi32(d, 7));
+    }
+
+    // Finish the last few positions one at a time.
+    for (; p < limit; ++p) {
+        h = rotl32(h, 1) ^ BUZHASH_TABLE[bytes[p - HASH_WINDOW_SIZE]] ^ BUZHASH_TABLE[bytes[p]];
+        if ((h & Chunker::CHUNK_PATTERN) == 0) {
+            return p + 1;
+        }
+    }
+    return 0;
+}
+
+DV_TARGET("avx2")
+size_t scan_fastcdc_avx2(const std::byte* data, size_t limit) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    const auto* table = reinterpret_cast<const long long*>(GEAR_TABLE.data());
+    const size_t normal = limit < Chunker::AVG_CHUNK_SIZE ? limit : Chunker::AVG_CHUNK_SIZE;
+
+    size_t p = Chunker::MIN_CHUNK_SIZE - 1;
+    uint64_t h = 0;
+    for (size_t i = p - HASH_WINDOW_SIZE; i < p; ++i) {
+        h = (h << 1) + GEAR_TABLE[bytes[i]];
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i shift_lo = _mm256_setr_epi64x(1, 2, 3, 4);
+    const __m256i shift_hi = _mm256_setr_epi64x(5, 6, 7, 8);
+    const __m256i mask_s = _mm256_set1_epi64x(static_cast<long long>(Chunker::FASTCDC_MASK_S));
+    const __m256i mask_l = _mm256_set1_epi64x(static_cast<long long>(Chunker::FASTCDC_MASK_L));
+
+    // Eight positions per step, as two vectors of four 64-bit lanes.
+    for (; p + 8 <= limit; p += 8) {
+        const __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + p)));
+        __m256i lo = _mm256_i32gather_epi64(table, _mm256_castsi256_si128(idx), 8);
+        __m256i hi = _mm256_i32gather_epi64(table, _mm256_extracti128_si256(idx, 1), 8);
+
+        // Prefix scan within each half: g[j] = sum over i <= j of g[i] << (j - i)...
+        lo = _mm256_add_epi64(lo, _mm256_slli_epi64(
+            _mm256_blend_epi32(_mm256_permute4x64_epi64(lo, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03), 1));
+        lo = _mm256_add_epi64(lo, _mm256_slli_epi64(
+            _mm256_blend_epi32(_mm256_permute4x64_epi64(lo, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F), 2));
+        hi = _mm256_add_epi64(hi, _mm256_slli_epi64(
+            _mm256_blend_epi32(_mm256_permute4x64_epi64(hi, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03), 1));
+        hi = _mm256_add_epi64(hi, _mm256_slli_epi64(
+            _mm256_blend_epi32(_mm256_permute4x64_epi64(hi, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F), 2));
+        // ...then carry the low half's last lane into the high half.
+        hi = _mm256_add_epi64(hi, _mm256_sllv_epi64(_mm256_permute4x64_epi64(lo, 0xFF), shift_lo));
+
+        // Fold in the previous hash.
+        const __m256i prev = _mm256_set1_epi64x(static_cast<long long>(h));
+        const __m256i hashes_lo = _mm256_add_epi64(lo, _mm256_sllv_epi64(prev, shift_lo));
+        const __m256i hashes_hi = _mm256_add_epi64(hi, _mm256_sllv_epi64(prev, shift_hi));
+
+        // Normalized chunking: strict mask for positions below the average.
+        const unsigned bits = hit_bits(hashes_lo, mask_for(p, normal, mask_s, mask_l)) |
+                              (hit_bits(hashes_hi, mask_for(p + 4, normal, mask_s, mask_l)) << 4);
+        if (bits != 0) {
+            return p + lowest_set_bit(bits) + 1;
+        }
+        h = (h << 8) + static_cast<uint64_t>(_mm256_extract_epi64(hi, 3));
+    }
+
+    for (; p < limit; ++p) {
+        h = (h << 1) + GEAR_TABLE[bytes[p]];
+        const uint64_t m = p < normal ? Chunker::FASTCDC_MASK_S : Chunker::FASTCDC_MASK_L;
+        if ((h & m) == 0) {
+            return p + 1;
+        }
+    }
+    return 0;
+}
+
+#undef DV_ROTL32
+
+bool avx2_supported() {
+    return sha256_cpu_has_avx2();
+}
+
+} // namespace dv::detail
+
+#else // Not x86: the scalar kernels are the only ones.
+
+namespace dv::detail {
+
+size_t scan_buzhash_avx2(const std::byte* data, size_t limit) { return scan_buzhash_scalar(data, limit); }
+size_t scan_fastcdc_avx2(const std::byte* data, size_t limit) { return scan_fastcdc_scalar(data, limit); }
+bool avx2_supported() { return false; }
+
+} // namespace dv::detail
+
+#endif
@@ -0,0 +1,53 @@
+// src/ChunkerKernels.h
+// Private to the Chunker: the rolling-hash tables and the boundary scan
+// kernels. Every kernel returns the first cut in [MIN_CHUNK_SIZE, limit)
+// for a chunk starting at 'data', or 0 if there is none, and must agree
+// bit-for-bit with the scalar kernel of the same engine.
+#pragma once
+
+#include <duplivault/Chunker.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace dv::detail {
+
+// Buzhash: a random 32-bit value for each possible byte value.
+inline constexpr std::array<uint32_t, 256> BUZHASH_TABLE = []() {
+    std::array<uint32_t, 256> table{};
+    // A simple Linear Congruential Generator to produce pseudo-random numbers
+    uint64_t state = 1;
+    for (int i = 0; i < 256; ++i) {
+        state = state * 1103515245 + 12345;
+        table[i] = static_cast<uint32_t>(state >> 32);
+    }
+    return table;
+}();
+
+// Gear hash: 256 random 64-bit values from a fixed-seed SplitMix64 generator.
+inline constexpr std::array<uint64_t, 256> GEAR_TABLE = []() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x6475706c69766175ULL; // "duplivau"
+    for (int i = 0; i < 256; ++i) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        table[i] = z ^ (z >> 31);
+    }
+    return table;
+}();
+
+// Both hashes look at exactly this many trailing bytes.
+inline constexpr size_t HASH_WINDOW_SIZE = 64;
+
+using ScanFn = size_t (*)(const std::byte* data, size_t limit);
+
+size_t scan_buzhash_scalar(const std::byte* data, size_t limit);
+size_t scan_fastcdc_scalar(const std::byte* data, size_t limit);
+
+// Vectorized kernels (ChunkerAvx2.cpp). Only call them if avx2_supported().
+size_t scan_buzhash_avx2(const std::byte* data, size_t limit);
+size_t scan_fastcdc_avx2(const std::byte* data, size_t limit);
+bool avx2_supported();
+
+} // namespace dv::detail
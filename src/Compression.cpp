@@ -0,0 +1,224 @@
+// src/Compression.cpp
+#include <duplivault/Compression.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace dv {
+
+// The Lz stream follows a u32 little-endian raw length. It is a series of
+// sequences, each a run of literal bytes followed by a back-reference:
+//
+//   token u8        high nibble: literal count, low nibble: match length - 4
+//   [extra count]   if a nibble is 15, bytes of 255 and then one below 255
+//                   are added to it (literal count here)
+//   literals
+//   offset u16      distance back to the match, 1..65535
+//   [extra length]  as for the literal count
+//
+// The last sequence stops after its literals, at the end of the stream.
+// This is the LZ4 block layout, so its well-known speed and safety
+// properties carry over; the encoder below is a simple greedy one.
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 4;
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr unsigned HASH_BITS = 12;
+
+// Smaller chunks are not worth the header and the call.
+constexpr size_t MIN_COMPRESS_SIZE = 64;
+
+// After this many misses in a row the search stride grows by one.
+constexpr unsigned SKIP_SHIFT = 6;
+
+uint32_t load_u32(const std::byte* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash_u32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void put_length(Chunk& out, size_t extra) {
+    while (extra >= 255) {
+        out.push_back(std::byte{255});
+        extra -= 255;
+    }
+    out.push_back(static_cast<std::byte>(extra));
+}
+
+void put_sequence(Chunk& out, const std::byte* literals, size_t literal_count, size_t offset, size_t match_length) {
+    const size_t match_code = match_length - MIN_MATCH;
+    const auto token = static_cast<uint8_t>((std::min<size_t>(literal_count, 15) << 4) |
+                                            (match_length ? std::min<size_t>(match_code, 15) : 0));
+    out.push_back(static_cast<std::byte>(token));
+    if (literal_count >= 15) put_length(out, literal_count - 15);
+    out.insert(out.end(), literals, literals + literal_count);
+    if (match_length == 0) return; // The last sequence.
+    out.push_back(static_cast<std::byte>(offset & 0xff));
+    out.push_back(static_cast<std::byte>(offset >> 8));
+    if (match_code >= 15) put_length(out, match_code - 15);
+}
+
+// Reads an extended count; false if it runs past the end.
+bool get_length(const std::byte*& in, const std::byte* end, size_t& length) {
+    uint8_t b;
+    do {
+        if (in == end) return false;
+        b = static_cast<uint8_t>(*in++);
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+} // anonymous namespace
+
+const char* to_string(ChunkCodec codec) {
+    switch (codec) {
+    case ChunkCodec::Raw: return "raw";
+    case ChunkCodec::Lz: return "lz";
+    }
+    return "unknown";
+}
+
+std::optional<ChunkCodec> parse_chunk_codec(std::string_view name) {
+    if (name == "raw") return ChunkCodec::Raw;
+    if (name == "lz") return ChunkCodec::Lz;
+    return std::nullopt;
+}
+
+ChunkCodec compress_chunk(ByteSpan raw, Chunk& out) {
+    const size_t n = raw.size;
+    if (n < MIN_COMPRESS_SIZE || n > UINT32_MAX) {
+        return ChunkCodec::Raw;
+    }
+    // Anything that saves less than 1/16 is stored raw: it would cost a
+    // decode on every read for little gain.
+    const size_t budget = n - n / 16;
+
+    out.clear();
+    out.reserve(compress_bound(n));
+    for (size_t i = 0; i < HEADER_SIZE; ++i) {
+        out.push_back(static_cast<std::byte>(n >> (8 * i)));
+    }
+
+    const std::byte* src = raw.data;
+    // Positions are stored plus one, so 0 means "none yet".
+    std::array<uint32_t, size_t(1) << HASH_BITS> table{};
+    size_t anchor = 0;
+    size_t pos = 0;
+    unsigned misses = 1u << SKIP_SHIFT;
+    while (pos + MIN_MATCH <= n) {
+        const uint32_t word = load_u32(src + pos);
+        uint32_t& slot = table[hash_u32(word)];
+        const size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || load_u32(src + candidate - 1) != word) {
+            if (anchor == 0 && pos >= INCOMPRESSIBLE_PROBE_SIZE) {
+                return ChunkCodec::Raw;
+            }
+            pos += misses++ >> SKIP_SHIFT;
+            continue;
+        }
+
+        size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (pos + length < n && src[match + length] == src[pos + length]) {
+            ++length;
+        }
+        while (pos > anchor && match > 0 && src[pos - 1] == src[match - 1]) {
+            --pos;
+            --match;
+            ++length;
+        }
+        put_sequence(out, src + anchor, pos - anchor, pos - match, length);
+        if (out.size() >= budget) {
+            return ChunkCodec::Raw;
+        }
+        pos += length;
+        anchor = pos;
+        misses = 1u << SKIP_SHIFT;
+    }
+    put_sequence(out, src + anchor, n - anchor, 0, 0);
+    return out.size() < budget ? ChunkCodec::Lz : ChunkCodec::Raw;
+}
+
+std::optional<size_t> raw_size_of(ChunkCodec codec, ByteSpan stored) {
+    switch (codec) {
+    case ChunkCodec::Raw:
+        return stored.size;
+    case ChunkCodec::Lz: {
+        if (stored.size < HEADER_SIZE) return std::nullopt;
+        size_t size = 0;
+        for (size_t i = 0; i < HEADER_SIZE; ++i) {
+            size |= static_cast<size_t>(stored.data[i]) << (8 * i);
+        }
+        return size;
+    }
+    }
+    return std::nullopt;
+}
+
+bool decompress_chunk(ChunkCodec codec, ByteSpan stored, std::byte* out, size_t raw_size) {
+    if (raw_size_of(codec, stored) != raw_size) {
+        return false;
+    }
+    if (codec == ChunkCodec::Raw) {
+        if (raw_size) std::memcpy(out, stored.data, raw_size);
+        return true;
+    }
+
+    const std::byte* in = stored.data + HEADER_SIZE;
+    const std::byte* const in_end = stored.data + stored.size;
+    size_t written = 0;
+    while (in != in_end) {
+        const auto token = static_cast<uint8_t>(*in++);
+        size_t literals = token >> 4;
+        if (literals == 15 && !get_length(in, in_end, literals)) return false;
+        if (literals > static_cast<size_t>(in_end - in) || literals > raw_size - written) return false;
+        if (literals) std::memcpy(out + written, in, literals);
+        in += literals;
+        written += literals;
+        if (in == in_end) break; // The last sequence.
+
+        if (in_end - in < 2) return false;
+        const size_t offset = static_cast<size_t>(in[0]) | static_cast<size_t>(in[1]) << 8;
+        in += 2;
+        size_t length = (token & 15);
+        if (length == 15 && !get_length(in, in_end, length)) return false;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > written || length > raw_size - written) return false;
+
+        std::byte* dst = out + written;
+        const std::byte* from = dst - offset;
+        if (offset >= length) {
+            std::memcpy(dst, from, length);
+        } else {
+            // Overlapping: the match repeats bytes it is itself writing.
+            for (size_t i = 0; i < length; ++i) dst[i] = from[i];
+        }
+        written += length;
+    }
+    return written == raw_size;
+}
+
+Chunk decompress_chunk(ChunkCodec codec, ByteSpan stored) {
+    const auto size = raw_size_of(codec, stored);
+    if (!size) {
+        throw std::runtime_error("Unknown or truncated chunk encoding (codec " +
+                                 std::to_string(static_cast<unsigned>(codec)) + ")");
+    }
+    Chunk raw(*size);
+    if (!decompress_chunk(codec, stored, raw.data(), raw.size())) {
+        throw std::runtime_error(std::string("Corrupt ") + to_string(codec) + " chunk data");
+    }
+    return raw;
+}
+
+} // namespace dv
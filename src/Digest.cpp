@@ -0,0 +1,55 @@
+// src/Digest.cpp
+#include <duplivault/Digest.h>
+#include <ostream>
+#include <stdexcept>
+
+namespace dv {
+
+namespace {
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // anonymous namespace
+
+std::string Digest::to_hex() const {
+    std::string hex(SIZE * 2, '0');
+    for (size_t i = 0; i < SIZE; ++i) {
+        hex[i * 2] = HEX_DIGITS[bytes[i] >> 4];
+        hex[i * 2 + 1] = HEX_DIGITS[bytes[i] & 0x0f];
+    }
+    return hex;
+}
+
+Digest Digest::from_hex(std::string_view hex) {
+    if (hex.size() != SIZE * 2) {
+        throw std::invalid_argument("Digest must be 64 hex characters: " + std::string(hex));
+    }
+    Digest digest;
+    for (size_t i = 0; i < SIZE; ++i) {
+        int hi = hex_value(hex[i * 2]);
+        int lo = hex_value(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            throw std::invalid_argument("Digest contains a non-hex character: " + std::string(hex));
+        }
+        digest.bytes[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return digest;
+}
+
+std::ostream& operator<<(std::ostream& os, const Digest& digest) {
+    char hex[Digest::SIZE * 2];
+    for (size_t i = 0; i < Digest::SIZE; ++i) {
+        hex[i * 2] = HEX_DIGITS[digest.bytes[i] >> 4];
+        hex[i * 2 + 1] = HEX_DIGITS[digest.bytes[i] & 0x0f];
+    }
+    return os.write(hex, sizeof(hex));
+}
+
+} // namespace dv
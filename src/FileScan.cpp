@@ -0,0 +1,194 @@
+// src/FileScan.cpp
+#include <duplivault/FileScan.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#endif
+
+namespace dv {
+
+namespace {
+
+#ifndef _WIN32
+
+int64_t nanoseconds(const struct timespec& ts) {
+    return static_cast<int64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+FileStat to_file_stat(const struct stat& st) {
+    FileStat stat;
+#ifdef __APPLE__
+    stat.mod_time_ns = nanoseconds(st.st_mtimespec);
+    stat.change_time_ns = nanoseconds(st.st_ctimespec);
+#else
+    stat.mod_time_ns = nanoseconds(st.st_mtim);
+    stat.change_time_ns = nanoseconds(st.st_ctim);
+#endif
+    stat.size = static_cast<uint64_t>(st.st_size);
+    stat.inode = static_cast<uint64_t>(st.st_ino);
+    stat.device = static_cast<uint64_t>(st.st_dev);
+    return stat;
+}
+
+int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return nanoseconds(ts);
+}
+
+} // anonymous namespace
+
+EntryKind classify_entry(int dir_fd, const char* name, unsigned char d_type, FileStat& stat) {
+    if (d_type == DT_DIR) {
+        return EntryKind::Directory;
+    }
+    // Follow symlinks only to see whether they lead to a file. Without a
+    // type from readdir(), the entry is first stat'ed as itself to find out
+    // whether it is a symlink at all.
+    struct stat st;
+    bool is_link = d_type == DT_LNK;
+    if (fstatat(dir_fd, name, &st, is_link ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+        return EntryKind::Skip; // Deleted since readdir(), or a dangling symlink.
+    }
+    if (d_type == DT_UNKNOWN && S_ISLNK(st.st_mode)) {
+        is_link = true;
+        if (fstatat(dir_fd, name, &st, 0) != 0) {
+            return EntryKind::Skip;
+        }
+    }
+    if (S_ISDIR(st.st_mode)) {
+        return is_link ? EntryKind::Skip : EntryKind::Directory;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return EntryKind::Skip;
+    }
+    stat = to_file_stat(st);
+    return EntryKind::File;
+}
+
+namespace {
+
+// Scans the directory open as 'fd' (taking ownership of it). Returns false
+// if fn asked to stop.
+bool scan_directory(int fd, const std::filesystem::path& path, const std::string& prefix,
+                    const std::function<bool(ScannedFile&&)>& fn,
+                    const std::function<bool(ScannedDirectory&&)>& on_directory) {
+    // Every entry is stat'ed after this, so comparing against it can only
+    // mark more files racy than needed, never fewer.
+    const int64_t now = now_ns();
+
+    ScannedDirectory self;
+    struct stat dir_st;
+    if (on_directory) {
+        if (fstat(fd, &dir_st) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat directory " + path.string() + ": " + std::strerror(errno));
+        }
+        self.path = path;
+        self.relative_path = prefix;
+        self.stat = to_file_stat(dir_st);
+        self.racy = std::max(self.stat.mod_time_ns, self.stat.change_time_ns) > now - RACY_WINDOW_NS;
+    }
+
+    DIR* dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        throw std::runtime_error("Cannot read directory " + path.string() + ": " + std::strerror(errno));
+    }
+    // Closes the directory however the scan ends.
+    std::unique_ptr<DIR, int (*)(DIR*)> guard(dir, closedir);
+
+    while (const dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0) {
+            continue;
+        }
+        const std::string relative = prefix.empty() ? name : prefix + "/" + name;
+
+        FileStat stat;
+        const EntryKind kind = classify_entry(dirfd(dir), name, entry->d_type, stat);
+        if (kind == EntryKind::Skip) {
+            continue;
+        }
+        if (kind == EntryKind::Directory) {
+            const int child = openat(dirfd(dir), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (child < 0) {
+                throw std::runtime_error("Cannot open directory " + (path / name).string() + ": " + std::strerror(errno));
+            }
+            if (!scan_directory(child, path / name, relative, fn, on_directory)) {
+                return false;
+            }
+            continue;
+        }
+
+        ScannedFile file;
+        file.path = path / name;
+        file.relative_path = relative;
+        file.stat = stat;
+        file.racy = std::max(file.stat.mod_time_ns, file.stat.change_time_ns) > now - RACY_WINDOW_NS;
+        if (!fn(std::move(file))) {
+            return false;
+        }
+    }
+    return !on_directory || on_directory(std::move(self));
+}
+
+#endif
+
+} // anonymous namespace
+
+void scan_files(const std::filesystem::path& root, const std::function<bool(ScannedFile&&)>& fn) {
+    scan_files(root, fn, nullptr);
+}
+
+void scan_files(const std::filesystem::path& root, const std::function<bool(ScannedFile&&)>& fn,
+                const std::function<bool(ScannedDirectory&&)>& on_directory) {
+#ifndef _WIN32
+    const int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open directory " + root.string() + ": " + std::strerror(errno));
+    }
+    scan_directory(fd, root, "", fn, on_directory);
+#else
+    (void)on_directory; // Directories are not stat'ed here.
+    const auto now = std::filesystem::file_time_type::clock::now().time_since_epoch();
+    const int64_t window = std::chrono::duration_cast<std::filesystem::file_time_type::duration>(
+                               std::chrono::nanoseconds(RACY_WINDOW_NS)).count();
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        ScannedFile file;
+        file.path = entry.path();
+        file.relative_path = entry.path().lexically_relative(root).generic_string();
+        file.stat.mod_time_ns = entry.last_write_time().time_since_epoch().count();
+        file.stat.size = entry.file_size();
+        file.racy = file.stat.mod_time_ns > now.count() - window;
+        if (!fn(std::move(file))) {
+            return;
+        }
+    }
+#endif
+}
+
+std::filesystem::path canonical_file_path(const std::filesystem::path& path) {
+    const auto absolute = std::filesystem::absolute(path).lexically_normal();
+    const auto name = absolute.filename();
+    if (name.empty() || name == "." || name == "..") {
+        return std::filesystem::weakly_canonical(absolute);
+    }
+    return std::filesystem::weakly_canonical(absolute.parent_path()) / name;
+}
+
+} // namespace dv
@@ -0,0 +1,73 @@
+// src/FileSync.cpp
+#include <duplivault/FileSync.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace dv {
+
+namespace {
+
+#ifndef _WIN32
+void sync_path(const std::filesystem::path& path, int flags, const char* what) {
+    const int fd = ::open(path.c_str(), flags | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Failed to open ") + what + " for syncing: " + path.string() + " (" +
+                                 std::strerror(errno) + ")");
+    }
+    int result;
+    do {
+        result = ::fsync(fd);
+    } while (result != 0 && errno == EINTR);
+    const int error = errno;
+    ::close(fd);
+    if (result != 0) {
+        throw std::runtime_error(std::string("Failed to sync ") + what + ": " + path.string() + " (" +
+                                 std::strerror(error) + ")");
+    }
+}
+#endif
+
+} // anonymous namespace
+
+void sync_file(const std::filesystem::path& path) {
+#ifndef _WIN32
+    sync_path(path, O_RDONLY, "file");
+#else
+    (void)path;
+#endif
+}
+
+void sync_directory(const std::filesystem::path& dir) {
+#ifndef _WIN32
+    sync_path(dir, O_RDONLY | O_DIRECTORY, "directory");
+#else
+    (void)dir;
+#endif
+}
+
+void write_file_atomically(const std::filesystem::path& path, const char* what,
+                           const std::function<void(std::ostream&)>& write) {
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        write(out);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error(std::string("Failed to write ") + what + " " + temp_path.string());
+        }
+    }
+    sync_file(temp_path);
+    std::filesystem::rename(temp_path, path);
+    sync_directory(path.has_parent_path() ? path.parent_path() : std::filesystem::path("."));
+}
+
+} // namespace dv
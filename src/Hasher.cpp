@@ -2,19 +2,104 @@
 
 #include <duplivault/Hasher.h>      // The header for our class
 #include "sha256.h"                 // Our own SHA-256 implementation's header
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 namespace dv {
 
+namespace {
+
+HashBackend resolve(HashBackend backend) {
+    if (backend != HashBackend::Auto) {
+        return backend;
+    }
+    // SHA-NI beats 8-lane AVX2 per core, and also speeds up single streams.
+    if (sha256_cpu_has_shani()) return HashBackend::ShaNi;
+    if (sha256_cpu_has_avx2()) return HashBackend::Avx2;
+    return HashBackend::Scalar;
+}
+
+} // anonymous namespace
+
+Hasher::Stream::Stream(Sha256CompressFn compress) {
+    sha256_init(ctx_, compress);
+}
+
+void Hasher::Stream::update(const std::byte* data, size_t size) {
+    sha256_update(ctx_, data, size);
+}
+
+Digest Hasher::Stream::finish() {
+    Digest digest;
+    sha256_final(ctx_, digest.bytes.data());
+    return digest;
+}
+
+Hasher::Hasher(HashBackend backend) : backend_(resolve(backend)) {
+    if (!is_supported(backend_)) {
+        throw std::invalid_argument("SHA-256 backend is not supported by this CPU.");
+    }
+    // The multi-buffer backend only helps batches; single streams stay scalar.
+    compress_ = backend_ == HashBackend::ShaNi ? sha256_compress_shani : sha256_compress_scalar;
+}
+
+bool Hasher::is_supported(HashBackend backend) {
+    switch (backend) {
+        case HashBackend::Auto:
+        case HashBackend::Scalar: return true;
+        case HashBackend::ShaNi: return sha256_cpu_has_shani();
+        case HashBackend::Avx2: return sha256_cpu_has_avx2();
+    }
+    return false;
+}
+
+Hasher::Stream Hasher::begin() const {
+    return Stream(compress_);
+}
+
 // This is the implementation for the method we declared in Hasher.h
-std::string Hasher::compute(const std::vector<std::byte>& data) const {
-    // The sha256 function we wrote expects a string_view.
-    // We can safely reinterpret the underlying data pointer of the byte vector
-    // and create a view of it without making any copies.
-    const char* byte_as_char_ptr = reinterpret_cast<const char*>(data.data());
-    std::string_view data_view(byte_as_char_ptr, data.size());
+Digest Hasher::compute(const std::vector<std::byte>& data) const {
+    return compute(data.data(), data.size());
+}
+
+Digest Hasher::compute(const std::byte* data, size_t size) const {
+    // The streaming context hashes straight from the caller's buffer,
+    // so a one-shot hash is just a single update.
+    Stream stream(compress_);
+    stream.update(data, size);
+    return stream.finish();
+}
+
+std::vector<Digest> Hasher::compute_many(const std::vector<ByteSpan>& inputs) const {
+    std::vector<Digest> hashes(inputs.size());
+    compute_many(inputs.data(), inputs.size(), hashes.data());
+    return hashes;
+}
+
+void Hasher::compute_many(const ByteSpan* inputs, size_t count, Digest* out) const {
+    if (backend_ != HashBackend::Avx2) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = compute(inputs[i].data, inputs[i].size);
+        }
+        return;
+    }
 
-    // Delegate the hard work to our globally-tested sha256 function.
-    return sha256(data_view);
+    // Feed the AVX2 kernel eight inputs at a time.
+    for (size_t first = 0; first < count; first += 8) {
+        const size_t lanes = std::min<size_t>(8, count - first);
+        const uint8_t* data[8];
+        size_t len[8];
+        for (size_t i = 0; i < lanes; ++i) {
+            data[i] = reinterpret_cast<const uint8_t*>(inputs[first + i].data);
+            len[i] = inputs[first + i].size;
+        }
+        uint8_t digests[8][32];
+        sha256_x8_avx2(data, len, lanes, digests);
+        for (size_t i = 0; i < lanes; ++i) {
+            std::memcpy(out[first + i].bytes.data(), digests[i], Digest::SIZE);
+        }
+    }
 }
 
-} // namespace dv
\ No newline at end of file
+} // namespace dv
@@ -0,0 +1,361 @@
+// src/IoBackend.cpp
+#include <duplivault/IoBackend.h>
+#include <duplivault/ThreadPool.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define DV_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace dv {
+
+// --- IoFile ---
+
+bool IoFile::open_for_reading(const std::filesystem::path& path) {
+    close();
+#ifndef _WIN32
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return fd_ >= 0;
+#else
+    stream_.open(path, std::ios::binary | std::ios::in);
+    return static_cast<bool>(stream_);
+#endif
+}
+
+bool IoFile::create(const std::filesystem::path& path, uint64_t size) {
+    close();
+#ifndef _WIN32
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return fd_ >= 0 && ::ftruncate(fd_, static_cast<off_t>(size)) == 0;
+#else
+    if (!std::ofstream(path, std::ios::binary | std::ios::trunc)) {
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::resize_file(path, size, error);
+    stream_.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    return !error && static_cast<bool>(stream_);
+#endif
+}
+
+bool IoFile::read_at(std::byte* data, size_t size, uint64_t offset) {
+#ifndef _WIN32
+    while (size > 0) {
+        const ssize_t n = ::pread(fd_, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false; // An error, or the file is shorter than expected.
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    stream_.seekg(static_cast<std::streamoff>(offset));
+    return static_cast<bool>(stream_.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size)));
+#endif
+}
+
+bool IoFile::write_at(const std::byte* data, size_t size, uint64_t offset) {
+#ifndef _WIN32
+    while (size > 0) {
+        const ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    stream_.seekp(static_cast<std::streamoff>(offset));
+    return static_cast<bool>(stream_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size)));
+#endif
+}
+
+bool IoFile::close() {
+#ifndef _WIN32
+    if (fd_ < 0) return true;
+    const bool ok = ::close(fd_) == 0;
+    fd_ = -1;
+    return ok;
+#else
+    if (!stream_.is_open()) return true;
+    stream_.close();
+    return !stream_.fail();
+#endif
+}
+
+namespace {
+
+// --- Thread-pool backend ---
+
+class ThreadIoBackend : public IoBackend {
+public:
+    explicit ThreadIoBackend(unsigned threads) : pool_(std::max(1u, threads) - 1) {}
+
+    const char* name() const override { return "threads"; }
+
+    void run(std::vector<IoRequest>& requests) override {
+        pool_.parallel_for(requests.size(), [&](size_t i) {
+            IoRequest& request = requests[i];
+            request.ok = request.op == IoRequest::Op::Read
+                             ? request.file->read_at(request.data, request.length, request.offset)
+                             : request.file->write_at(request.data, request.length, request.offset);
+        });
+    }
+
+private:
+    ThreadPool pool_;
+};
+
+#ifdef DV_HAVE_IO_URING
+
+// --- io_uring backend ---
+// Driven through the raw system calls, so there is no liburing dependency.
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+class IoUringBackend : public IoBackend {
+public:
+    static constexpr unsigned QUEUE_DEPTH = 128;
+
+    IoUringBackend() {
+        io_uring_params params{};
+        ring_fd_ = sys_io_uring_setup(QUEUE_DEPTH, &params);
+        if (ring_fd_ < 0) {
+            throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+        }
+        sq_entries_ = params.sq_entries;
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+
+        auto* sq = static_cast<char*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        auto* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUringBackend() override {
+        if (sqes_) ::munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_) ::munmap(sq_ring_, sq_ring_size_);
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    void run(std::vector<IoRequest>& requests) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // What is left of each request; a short transfer is resubmitted
+        // for the rest.
+        struct Progress {
+            size_t done = 0;
+            iovec iov{};
+        };
+        std::vector<Progress> progress(requests.size());
+        std::deque<size_t> waiting;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            requests[i].ok = false;
+            if (requests[i].length == 0) {
+                requests[i].ok = true;
+            } else {
+                waiting.push_back(i);
+            }
+        }
+
+        unsigned in_flight = 0;
+        unsigned unsubmitted = 0; // Queued, but not yet taken by the kernel.
+        while (!waiting.empty() || in_flight > 0 || unsubmitted > 0) {
+            // Fill the submission queue.
+            unsigned tail = *sq_tail_; // Only this thread moves the tail.
+            while (!waiting.empty() && in_flight + unsubmitted < sq_entries_) {
+                const size_t i = waiting.front();
+                waiting.pop_front();
+                IoRequest& request = requests[i];
+                Progress& p = progress[i];
+                p.iov.iov_base = request.data + p.done;
+                p.iov.iov_len = request.length - p.done;
+
+                const unsigned index = tail & sq_mask_;
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = request.op == IoRequest::Op::Read ? IORING_OP_READV : IORING_OP_WRITEV;
+                sqe.fd = request.file->native_handle();
+                sqe.off = request.offset + p.done;
+                sqe.addr = reinterpret_cast<uint64_t>(&p.iov);
+                sqe.len = 1;
+                sqe.user_data = i;
+                sq_array_[index] = index;
+                tail++;
+                unsubmitted++;
+            }
+            __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+            // Submit, and wait for at least one completion if one is bound
+            // to come. The kernel may take fewer entries than offered; the
+            // rest stay in the queue and are offered again next time round.
+            const auto enter = [&](unsigned to_submit, unsigned wait) {
+                int entered;
+                do {
+                    entered = sys_io_uring_enter(ring_fd_, to_submit, wait, wait ? IORING_ENTER_GETEVENTS : 0);
+                } while (entered < 0 && errno == EINTR);
+                return entered;
+            };
+            int entered = enter(unsubmitted, in_flight > 0 ? 1 : 0);
+            if (entered < 0 && (errno == EAGAIN || errno == EBUSY)) {
+                // Short of resources: let some requests finish first.
+                entered = 0;
+                if (in_flight == 0) {
+                    std::this_thread::yield();
+                } else if (enter(0, 1) < 0) {
+                    entered = -1;
+                }
+            }
+            if (entered < 0) {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+            unsubmitted -= static_cast<unsigned>(entered);
+            in_flight += static_cast<unsigned>(entered);
+
+            // Reap every completion available.
+            unsigned head = *cq_head_;
+            const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != cq_tail; ++head) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                const size_t i = static_cast<size_t>(cqe.user_data);
+                in_flight--;
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                    waiting.push_back(i);
+                } else if (cqe.res > 0) {
+                    progress[i].done += static_cast<size_t>(cqe.res);
+                    if (progress[i].done == requests[i].length) {
+                        requests[i].ok = true;
+                    } else {
+                        waiting.push_back(i);
+                    }
+                }
+                // Otherwise an error, or end of file: the request failed.
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+    }
+
+private:
+    void* map(size_t size, off_t offset) {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        if (p == MAP_FAILED) {
+            throw std::runtime_error(std::string("Failed to map io_uring: ") + std::strerror(errno));
+        }
+        return p;
+    }
+
+    std::mutex mutex_; // One batch at a time.
+    int ring_fd_ = -1;
+    unsigned sq_entries_ = 0;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+};
+
+#endif // DV_HAVE_IO_URING
+
+} // anonymous namespace
+
+const char* to_string(IoBackendKind kind) {
+    switch (kind) {
+    case IoBackendKind::Auto: return "auto";
+    case IoBackendKind::Threads: return "threads";
+    case IoBackendKind::IoUring: return "io_uring";
+    }
+    return "unknown";
+}
+
+std::optional<IoBackendKind> parse_io_backend_kind(std::string_view name) {
+    if (name == "auto") return IoBackendKind::Auto;
+    if (name == "threads") return IoBackendKind::Threads;
+    if (name == "io_uring") return IoBackendKind::IoUring;
+    return std::nullopt;
+}
+
+bool io_uring_available() {
+#ifdef DV_HAVE_IO_URING
+    // Kernels without it, or sandboxes that forbid it, refuse the setup.
+    static const bool available = []() {
+        io_uring_params params{};
+        const int fd = sys_io_uring_setup(1, &params);
+        if (fd < 0) {
+            return false;
+        }
+        ::close(fd);
+        return true;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<IoBackend> make_io_backend(IoBackendKind kind, unsigned threads) {
+    if (kind == IoBackendKind::IoUring && !io_uring_available()) {
+        throw std::invalid_argument("io_uring is not available on this system");
+    }
+#ifdef DV_HAVE_IO_URING
+    if (kind != IoBackendKind::Threads && io_uring_available()) {
+        return std::make_unique<IoUringBackend>();
+    }
+#endif
+    return std::make_unique<ThreadIoBackend>(threads);
+}
+
+} // namespace dv
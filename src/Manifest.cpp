@@ -0,0 +1,192 @@
+// src/Manifest.cpp
+#include <duplivault/Manifest.h>
+#include "Varint.h"
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dv {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'V', 'M', 'F'};
+constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 4;
+
+// Digests are copied to and from the contiguous block in bulk.
+static_assert(sizeof(Digest) == Digest::SIZE && std::is_trivially_copyable_v<Digest>, "Digest must be raw bytes");
+
+uint64_t get_varint(const std::byte*& p, const std::byte* end) {
+    return detail::get_varint(p, end, "manifest");
+}
+
+} // anonymous namespace
+
+std::vector<std::byte> Manifest::serialize() const {
+    if (!chunk_lengths.empty() && chunk_lengths.size() != chunk_hashes.size()) {
+        throw std::invalid_argument("Manifest has " + std::to_string(chunk_lengths.size()) + " lengths for " +
+                                    std::to_string(chunk_hashes.size()) + " chunks");
+    }
+
+    std::vector<std::byte> out;
+    out.reserve(HEADER_SIZE + 2 + original_path.size() + 8 + 4 + chunk_hashes.size() * (Digest::SIZE + 3));
+
+    for (char c : MAGIC) out.push_back(static_cast<std::byte>(c));
+    out.push_back(static_cast<std::byte>(ManifestView::VERSION));
+    out.push_back(static_cast<std::byte>(chunk_lengths.empty() ? 0 : ManifestView::HAS_LENGTHS));
+    out.push_back(std::byte{0});
+    out.push_back(std::byte{0});
+
+    detail::put_varint(out, original_path.size());
+    for (char c : original_path) out.push_back(static_cast<std::byte>(c));
+
+    const auto mtime = static_cast<uint64_t>(mod_time_ns);
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::byte>(mtime >> (8 * i)));
+
+    detail::put_varint(out, chunk_hashes.size());
+    const size_t digests_at = out.size();
+    out.resize(digests_at + chunk_hashes.size() * Digest::SIZE);
+    for (size_t i = 0; i < chunk_hashes.size(); ++i) {
+        std::memcpy(out.data() + digests_at + i * Digest::SIZE, chunk_hashes[i].bytes.data(), Digest::SIZE);
+    }
+
+    for (uint32_t length : chunk_lengths) {
+        detail::put_varint(out, length);
+    }
+    return out;
+}
+
+std::vector<uint64_t> Manifest::chunk_offsets() const {
+    std::vector<uint64_t> offsets;
+    if (chunk_lengths.empty() && !chunk_hashes.empty()) {
+        return offsets;
+    }
+    offsets.reserve(chunk_lengths.size() + 1);
+    uint64_t offset = 0;
+    offsets.push_back(offset);
+    for (uint32_t length : chunk_lengths) {
+        offset += length;
+        offsets.push_back(offset);
+    }
+    return offsets;
+}
+
+nlohmann::json Manifest::to_json() const {
+    nlohmann::json json;
+    json["original_path"] = original_path;
+    json["mod_time_ns"] = mod_time_ns;
+    std::vector<std::string> hex;
+    hex.reserve(chunk_hashes.size());
+    for (const auto& hash : chunk_hashes) {
+        hex.push_back(hash.to_hex());
+    }
+    json["chunk_hashes"] = hex;
+    if (!chunk_lengths.empty()) {
+        json["chunk_lengths"] = chunk_lengths;
+    }
+    return json;
+}
+
+Manifest Manifest::from_json(const nlohmann::json& json) {
+    Manifest manifest;
+    manifest.original_path = json.value("original_path", "");
+    manifest.mod_time_ns = json.value("mod_time_ns", int64_t{0});
+    if (json.contains("chunk_hashes")) {
+        for (const auto& hex : json["chunk_hashes"]) {
+            manifest.chunk_hashes.push_back(Digest::from_hex(hex.get<std::string>()));
+        }
+    }
+    if (json.contains("chunk_lengths")) {
+        manifest.chunk_lengths = json["chunk_lengths"].get<std::vector<uint32_t>>();
+        if (manifest.chunk_lengths.size() != manifest.chunk_hashes.size()) {
+            throw std::invalid_argument("Manifest lengths do not match its chunks");
+        }
+    }
+    return manifest;
+}
+
+bool ManifestView::is_manifest(ByteSpan bytes) {
+    return bytes.size >= sizeof(MAGIC) && std::memcmp(bytes.data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+ManifestView::ManifestView(ByteSpan bytes) {
+    if (!is_manifest(bytes) || bytes.size < HEADER_SIZE) {
+        throw std::runtime_error("Not a DupliVault manifest");
+    }
+    const auto version = static_cast<uint8_t>(bytes.data[4]);
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported manifest version " + std::to_string(version));
+    }
+    const auto flags = static_cast<uint8_t>(bytes.data[5]);
+
+    const std::byte* p = bytes.data + HEADER_SIZE;
+    end_ = bytes.data + bytes.size;
+
+    const uint64_t path_size = get_varint(p, end_);
+    if (path_size > static_cast<uint64_t>(end_ - p)) {
+        throw std::runtime_error("Truncated manifest");
+    }
+    original_path_ = std::string_view(reinterpret_cast<const char*>(p), path_size);
+    p += path_size;
+
+    if (end_ - p < 8) {
+        throw std::runtime_error("Truncated manifest");
+    }
+    uint64_t mtime = 0;
+    for (int i = 0; i < 8; ++i) mtime |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    mod_time_ns_ = static_cast<int64_t>(mtime);
+    p += 8;
+
+    const uint64_t count = get_varint(p, end_);
+    if (count > static_cast<uint64_t>(end_ - p) / Digest::SIZE) {
+        throw std::runtime_error("Truncated manifest");
+    }
+    chunk_count_ = count;
+    digests_ = p;
+    p += count * Digest::SIZE;
+
+    if (flags & HAS_LENGTHS) {
+        // Validate the lengths once, so chunk_lengths() cannot fail later.
+        lengths_ = p;
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            if (get_varint(p, end_) > UINT32_MAX) {
+                throw std::runtime_error("Chunk length out of range in manifest");
+            }
+        }
+    }
+    if (p != end_) {
+        throw std::runtime_error("Trailing bytes after manifest");
+    }
+}
+
+Digest ManifestView::chunk_hash(size_t i) const {
+    Digest hash;
+    std::memcpy(hash.bytes.data(), digests_ + i * Digest::SIZE, Digest::SIZE);
+    return hash;
+}
+
+std::vector<uint32_t> ManifestView::chunk_lengths() const {
+    std::vector<uint32_t> lengths;
+    if (!lengths_) {
+        return lengths;
+    }
+    lengths.reserve(chunk_count_);
+    const std::byte* p = lengths_;
+    for (size_t i = 0; i < chunk_count_; ++i) {
+        lengths.push_back(static_cast<uint32_t>(get_varint(p, end_)));
+    }
+    return lengths;
+}
+
+Manifest ManifestView::to_manifest() const {
+    Manifest manifest;
+    manifest.original_path = std::string(original_path_);
+    manifest.mod_time_ns = mod_time_ns_;
+    manifest.chunk_hashes.resize(chunk_count_);
+    if (chunk_count_ != 0) {
+        std::memcpy(manifest.chunk_hashes.data(), digests_, chunk_count_ * Digest::SIZE);
+    }
+    manifest.chunk_lengths = chunk_lengths();
+    return manifest;
+}
+
+} // namespace dv
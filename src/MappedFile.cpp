@@ -0,0 +1,55 @@
+// src/MappedFile.cpp
+#include <duplivault/MappedFile.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dv {
+
+bool MappedFile::map(const std::filesystem::path& path) {
+    unmap();
+#ifndef _WIN32
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd); // Nothing to map; data() stays null.
+        return true;
+    }
+    void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file open.
+    if (p == MAP_FAILED) {
+        size_ = 0;
+        return false;
+    }
+    ::madvise(p, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const std::byte*>(p);
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void MappedFile::unmap() {
+#ifndef _WIN32
+    if (data_) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace dv
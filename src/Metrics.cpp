@@ -0,0 +1,167 @@
+// src/Metrics.cpp
+#include <duplivault/Metrics.h>
+#include <algorithm>
+#include <iomanip>
+
+namespace dv {
+
+namespace {
+
+size_t bucket_of(uint64_t value) {
+    if (value == 0) return 0;
+#if defined(__GNUC__) || defined(__clang__)
+    return 64 - static_cast<size_t>(__builtin_clzll(value));
+#else
+    size_t bits = 0;
+    for (; value; value >>= 1) ++bits;
+    return bits;
+#endif
+}
+
+uint64_t bucket_limit(size_t bucket) {
+    return bucket == 0 ? 0 : bucket == 64 ? UINT64_MAX : (uint64_t(1) << bucket) - 1;
+}
+
+double ratio(uint64_t num, uint64_t den) {
+    return static_cast<double>(num) / static_cast<double>(den);
+}
+
+} // anonymous namespace
+
+void Histogram::record(uint64_t value, uint64_t times) {
+    buckets_[bucket_of(value)].fetch_add(times, std::memory_order_relaxed);
+    count_.fetch_add(times, std::memory_order_relaxed);
+    sum_.fetch_add(value * times, std::memory_order_relaxed);
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t Histogram::quantile(double q) const {
+    const uint64_t total = count();
+    if (total == 0) return 0;
+    // The rank of the quantile sample, 1-based.
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(total) + 0.5));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        seen += buckets_[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(bucket_limit(b), max());
+    }
+    return max();
+}
+
+nlohmann::json Histogram::to_json() const {
+    nlohmann::json out;
+    out["count"] = count();
+    out["sum"] = sum();
+    out["mean"] = count() ? sum() / count() : 0;
+    out["p50"] = quantile(0.50);
+    out["p90"] = quantile(0.90);
+    out["p99"] = quantile(0.99);
+    out["max"] = max();
+    out["buckets"] = nlohmann::json::array();
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        if (const uint64_t n = buckets_[b].load(std::memory_order_relaxed)) {
+            out["buckets"].push_back({{"le", bucket_limit(b)}, {"count", n}});
+        }
+    }
+    return out;
+}
+
+const char* to_string(Stage stage) {
+    switch (stage) {
+    case Stage::Chunk: return "chunk";
+    case Stage::Hash: return "hash";
+    case Stage::Lookup: return "lookup";
+    case Stage::Compress: return "compress";
+    case Stage::Write: return "write";
+    case Stage::Metadata: return "metadata";
+    case Stage::RestoreRead: return "restore_read";
+    case Stage::Decompress: return "decompress";
+    case Stage::Count: break;
+    }
+    return "unknown";
+}
+
+const char* to_string(Counter counter) {
+    switch (counter) {
+    case Counter::FilesScanned: return "files_scanned";
+    case Counter::FilesUnchanged: return "files_unchanged";
+    case Counter::FilesBackedUp: return "files_backed_up";
+    case Counter::FilesFailed: return "files_failed";
+    case Counter::BytesIn: return "bytes_in";
+    case Counter::Chunks: return "chunks";
+    case Counter::NewChunks: return "new_chunks";
+    case Counter::NewBytes: return "new_bytes";
+    case Counter::StoredBytes: return "stored_bytes";
+    case Counter::TreesStored: return "trees_stored";
+    case Counter::FilesRestored: return "files_restored";
+    case Counter::BytesRestored: return "bytes_restored";
+    case Counter::RestoreBytesRead: return "restore_bytes_read";
+    case Counter::CacheHits: return "cache_hits";
+    case Counter::CacheMisses: return "cache_misses";
+    case Counter::Count: break;
+    }
+    return "unknown";
+}
+
+nlohmann::json Metrics::to_json() const {
+    nlohmann::json out;
+    out["counters"] = nlohmann::json::object();
+    for (size_t c = 0; c < static_cast<size_t>(Counter::Count); ++c) {
+        out["counters"][to_string(static_cast<Counter>(c))] = get(static_cast<Counter>(c));
+    }
+    // Bytes chunked per byte that had to be stored: how much dedup saved.
+    if (get(Counter::NewBytes) > 0) {
+        out["dedup_ratio"] = ratio(get(Counter::BytesIn), get(Counter::NewBytes));
+    }
+    if (get(Counter::StoredBytes) > 0) {
+        out["compression_ratio"] = ratio(get(Counter::NewBytes), get(Counter::StoredBytes));
+    }
+    out["stages_ns"] = nlohmann::json::object();
+    for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+        const Histogram& histogram = stages_[s];
+        if (histogram.count() > 0) {
+            out["stages_ns"][to_string(static_cast<Stage>(s))] = histogram.to_json();
+        }
+    }
+    if (chunk_sizes_.count() > 0) {
+        out["chunk_size_bytes"] = chunk_sizes_.to_json();
+    }
+    return out;
+}
+
+void Metrics::print(std::ostream& out) const {
+    for (size_t c = 0; c < static_cast<size_t>(Counter::Count); ++c) {
+        if (const uint64_t value = get(static_cast<Counter>(c))) {
+            out << std::left << std::setw(20) << to_string(static_cast<Counter>(c)) << value << '\n';
+        }
+    }
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+    if (get(Counter::NewBytes) > 0) {
+        out << std::setw(20) << "dedup_ratio" << ratio(get(Counter::BytesIn), get(Counter::NewBytes)) << '\n';
+    }
+    if (get(Counter::StoredBytes) > 0) {
+        out << std::setw(20) << "compression_ratio" << ratio(get(Counter::NewBytes), get(Counter::StoredBytes))
+            << '\n';
+    }
+    out.flags(flags);
+
+    auto row = [&](const char* name, const Histogram& h) {
+        out << std::left << std::setw(14) << name << std::right << std::setw(10) << h.count() << std::setw(12)
+            << h.sum() / h.count() << std::setw(12) << h.quantile(0.5) << std::setw(12) << h.quantile(0.99)
+            << std::setw(12) << h.max() << '\n';
+    };
+    const bool timed = std::any_of(stages_.begin(), stages_.end(), [](const Histogram& h) { return h.count() > 0; });
+    if (!timed && chunk_sizes_.count() == 0) return;
+    out << std::left << std::setw(14) << "stage (ns)" << std::right << std::setw(10) << "count" << std::setw(12)
+        << "mean" << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "max" << '\n';
+    for (size_t s = 0; s < static_cast<size_t>(Stage::Count); ++s) {
+        if (stages_[s].count() > 0) row(to_string(static_cast<Stage>(s)), stages_[s]);
+    }
+    if (chunk_sizes_.count() > 0) row("chunk size (B)", chunk_sizes_);
+    out.flags(flags);
+}
+
+} // namespace dv
@@ -0,0 +1,331 @@
+// src/PackStore.cpp
+#include <duplivault/PackStore.h>
+#include <duplivault/FileSync.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace dv {
+
+namespace {
+
+constexpr char PACK_MAGIC[8] = {'D', 'V', 'P', 'A', 'C', 'K', '0', '1'};
+constexpr char INDEX_MAGIC[8] = {'D', 'V', 'I', 'D', 'X', '0', '0', '1'};
+
+constexpr size_t PACK_HEADER_SIZE = sizeof(PACK_MAGIC);
+constexpr size_t RECORD_HEADER_SIZE = Digest::SIZE + 4 + 4;
+constexpr size_t INDEX_HEADER_SIZE = sizeof(INDEX_MAGIC) + 8 + 8;
+constexpr size_t INDEX_ENTRY_SIZE = Digest::SIZE + 8 + 4 + 4;
+
+void put_u32(char* out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<char>(v >> (8 * i));
+}
+void put_u64(char* out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<char>(v >> (8 * i));
+}
+uint32_t get_u32(const char* in) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return v;
+}
+uint64_t get_u64(const char* in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return v;
+}
+
+// Parses "pack-NNNNNN.pack"; returns 0 for anything else.
+uint32_t parse_pack_id(const std::filesystem::path& path) {
+    const std::string name = path.filename().string();
+    const std::string prefix = "pack-", suffix = ".pack";
+    if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return 0;
+    }
+    const std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if (digits.find_first_not_of("0123456789") != std::string::npos || digits.size() > 9) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::stoul(digits));
+}
+
+} // anonymous namespace
+
+std::filesystem::path PackStore::pack_path(const std::filesystem::path& packs_dir, uint32_t pack_id) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "pack-%06u.pack", pack_id);
+    return packs_dir / name;
+}
+
+std::filesystem::path PackStore::index_path(const std::filesystem::path& packs_dir, uint32_t pack_id) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "pack-%06u.idx", pack_id);
+    return packs_dir / name;
+}
+
+PackStore::PackStore(std::filesystem::path packs_dir, uint64_t target_pack_size, RecordCheck check_recovered)
+    : packs_dir_(std::move(packs_dir)), target_pack_size_(target_pack_size), check_recovered_(std::move(check_recovered)) {
+    if (!std::filesystem::exists(packs_dir_)) {
+        return;
+    }
+
+    std::vector<uint32_t> ids;
+    for (const auto& entry : std::filesystem::directory_iterator(packs_dir_)) {
+        if (entry.is_regular_file()) {
+            if (uint32_t id = parse_pack_id(entry.path())) {
+                ids.push_back(id);
+            }
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    // An index that claims more data than the packs hold (e.g. packs were
+    // restored from an older copy) cannot be trusted; rebuild it.
+    index_.load(packs_dir_);
+    const auto mark = index_.watermark();
+    if (mark.pack_id != 0) {
+        const auto marked = pack_path(packs_dir_, mark.pack_id);
+        if (!std::filesystem::exists(marked) || std::filesystem::file_size(marked) < mark.end) {
+            index_.clear();
+        }
+    }
+    const auto indexed = index_.watermark();
+
+    for (uint32_t id : ids) {
+        // Keep filling the newest pack if it has room, rather than leaving
+        // a small pack behind after every run.
+        const bool reopen = id == ids.back() && std::filesystem::file_size(pack_path(packs_dir_, id)) < target_pack_size_;
+        if (id < indexed.pack_id && !reopen) {
+            continue; // Fully covered by the chunk index.
+        }
+        load_pack(id, id == indexed.pack_id ? indexed.end : (id < indexed.pack_id ? UINT64_MAX : 0), reopen);
+    }
+    last_id_ = ids.empty() ? 0 : ids.back();
+
+    // Persist whatever the packs added to the index.
+    index_.save(packs_dir_);
+}
+
+PackStore::~PackStore() {
+    try {
+        flush();
+    } catch (...) {
+        // Nothing sensible to do in a destructor; the next open rescans
+        // whatever the index does not cover.
+    }
+}
+
+// Reads one pack's records and adds those at or past 'indexed_end' to the
+// chunk index (pass UINT64_MAX when all of them are indexed already).
+void PackStore::load_pack(uint32_t pack_id, uint64_t indexed_end, bool reopen_for_append) {
+    const auto path = pack_path(packs_dir_, pack_id);
+    const uint64_t file_size = std::filesystem::file_size(path);
+
+    std::ifstream in(path, std::ios::binary);
+    char magic[PACK_HEADER_SIZE];
+    if (!in || !in.read(magic, sizeof(magic)) || std::memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a DupliVault pack file: " + path.string());
+    }
+
+    std::vector<std::pair<Digest, PackLocation>> entries;
+
+    // Everything the index lists...
+    uint64_t covered = PACK_HEADER_SIZE;
+    const auto idx_path = index_path(packs_dir_, pack_id);
+    if (std::filesystem::exists(idx_path)) {
+        std::ifstream idx(idx_path, std::ios::binary);
+        char header[INDEX_HEADER_SIZE];
+        if (!idx.read(header, sizeof(header)) || std::memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+            throw std::runtime_error("Not a DupliVault pack index: " + idx_path.string());
+        }
+        covered = get_u64(header + 8);
+        const uint64_t count = get_u64(header + 16);
+        if (covered > file_size) {
+            throw std::runtime_error("Pack index covers more than its pack: " + idx_path.string());
+        }
+
+        std::vector<char> table(count * INDEX_ENTRY_SIZE);
+        if (!idx.read(table.data(), static_cast<std::streamsize>(table.size()))) {
+            throw std::runtime_error("Truncated pack index: " + idx_path.string());
+        }
+        entries.reserve(count);
+        for (uint64_t i = 0; i < count; ++i) {
+            const char* e = table.data() + i * INDEX_ENTRY_SIZE;
+            Digest hash;
+            std::memcpy(hash.bytes.data(), e, Digest::SIZE);
+            entries.push_back({hash, {pack_id, get_u64(e + 32), get_u32(e + 40), get_u32(e + 44)}});
+        }
+    }
+
+    // ...plus any records appended after it was written. A record cut
+    // short by a crash, or failing the check, ends the scan.
+    uint64_t good_end = covered;
+    in.seekg(static_cast<std::streamoff>(covered));
+    char header[RECORD_HEADER_SIZE];
+    Chunk data;
+    while (good_end + RECORD_HEADER_SIZE <= file_size && in.read(header, sizeof(header))) {
+        const uint32_t length = get_u32(header + 32);
+        const uint32_t flags = get_u32(header + 36);
+        const uint64_t data_offset = good_end + RECORD_HEADER_SIZE;
+        if (data_offset + length > file_size) {
+            break;
+        }
+        Digest hash;
+        std::memcpy(hash.bytes.data(), header, Digest::SIZE);
+        if (check_recovered_ && data_offset + length > indexed_end) {
+            data.resize(length);
+            if (!in.read(reinterpret_cast<char*>(data.data()), length) || !check_recovered_(hash, data, flags)) {
+                break;
+            }
+        }
+        entries.push_back({hash, {pack_id, data_offset, length, flags}});
+        good_end = data_offset + length;
+        in.seekg(static_cast<std::streamoff>(good_end));
+    }
+
+    for (const auto& [hash, location] : entries) {
+        const uint64_t record_end = location.offset + location.length;
+        if (record_end > indexed_end) {
+            if (!index_.insert(hash, location)) {
+                index_.cover(pack_id, record_end); // A second copy of a known chunk.
+            }
+        }
+    }
+
+    if (reopen_for_append) {
+        in.close();
+        if (good_end < file_size) {
+            std::filesystem::resize_file(path, good_end); // Drop a torn tail before appending.
+        }
+        active_.open(path, std::ios::binary | std::ios::app);
+        if (!active_) {
+            throw std::runtime_error("Failed to open pack for appending: " + path.string());
+        }
+        active_id_ = pack_id;
+        active_size_ = good_end;
+        active_entries_ = std::move(entries);
+        active_index_dirty_ = good_end != covered;
+    }
+}
+
+void PackStore::open_new_pack() {
+    std::filesystem::create_directories(packs_dir_);
+    active_id_ = ++last_id_;
+    const auto path = pack_path(packs_dir_, active_id_);
+    active_.open(path, std::ios::binary | std::ios::trunc);
+    if (!active_) {
+        throw std::runtime_error("Failed to create pack file: " + path.string());
+    }
+    active_.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+    active_size_ = PACK_HEADER_SIZE;
+    active_entries_.clear();
+    active_index_dirty_ = true;
+}
+
+std::optional<PackLocation> PackStore::find(const Digest& hash) const {
+    return index_.find(hash);
+}
+
+void PackStore::append(const Digest& hash, ByteSpan data, uint32_t flags) {
+    if (active_id_ == 0) {
+        open_new_pack();
+    }
+
+    char header[RECORD_HEADER_SIZE];
+    std::memcpy(header, hash.bytes.data(), Digest::SIZE);
+    put_u32(header + 32, static_cast<uint32_t>(data.size));
+    put_u32(header + 36, flags);
+    active_.write(header, sizeof(header));
+    active_.write(reinterpret_cast<const char*>(data.data), static_cast<std::streamsize>(data.size));
+    if (!active_) {
+        throw std::runtime_error("Failed to write to pack " + pack_path(packs_dir_, active_id_).string());
+    }
+
+    const PackLocation location{active_id_, active_size_ + RECORD_HEADER_SIZE, static_cast<uint32_t>(data.size), flags};
+    active_size_ += RECORD_HEADER_SIZE + data.size;
+    active_entries_.push_back({hash, location});
+    if (!index_.insert(hash, location)) {
+        index_.cover(active_id_, active_size_);
+    }
+    active_index_dirty_ = true;
+
+    // A full pack is closed for good; the next chunk starts a new one.
+    if (active_size_ >= target_pack_size_) {
+        flush();
+        active_.close();
+        active_id_ = 0;
+        active_entries_.clear();
+    }
+}
+
+std::filesystem::path PackStore::prepare_read(const PackLocation& location) {
+    if (location.pack_id == active_id_) {
+        active_.flush(); // The record may still be in our write buffer.
+    }
+    return pack_path(packs_dir_, location.pack_id);
+}
+
+Chunk PackStore::read(const PackLocation& location) {
+    const auto path = prepare_read(location);
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open pack for reading: " + path.string());
+    }
+    Chunk data(location.length);
+    in.seekg(static_cast<std::streamoff>(location.offset));
+    if (!in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        throw std::runtime_error("Failed to read chunk data from pack: " + path.string());
+    }
+    return data;
+}
+
+void PackStore::flush() {
+    // Pack data first, so neither index ever points at bytes not yet on
+    // disk. This is the only place pack data is synced: once per flush and
+    // per filled pack, not per chunk.
+    if (active_id_ != 0) {
+        active_.flush();
+        if (active_index_dirty_) {
+            if (!active_) {
+                throw std::runtime_error("Failed to write to pack " + pack_path(packs_dir_, active_id_).string());
+            }
+            sync_file(pack_path(packs_dir_, active_id_));
+            sync_directory(packs_dir_); // For a pack created since the last flush.
+            write_active_index();
+        }
+    }
+    if (std::filesystem::exists(packs_dir_)) {
+        index_.save(packs_dir_);
+    }
+}
+
+void PackStore::write_active_index() {
+    auto entries = active_entries_;
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<char> out(INDEX_HEADER_SIZE + entries.size() * INDEX_ENTRY_SIZE);
+    std::memcpy(out.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    put_u64(out.data() + 8, active_size_);
+    put_u64(out.data() + 16, entries.size());
+    char* e = out.data() + INDEX_HEADER_SIZE;
+    for (const auto& [hash, location] : entries) {
+        std::memcpy(e, hash.bytes.data(), Digest::SIZE);
+        put_u64(e + 32, location.offset);
+        put_u32(e + 40, location.length);
+        put_u32(e + 44, location.flags);
+        e += INDEX_ENTRY_SIZE;
+    }
+
+    // Replaced whole, so a crash never leaves a truncated .idx behind
+    // (which would make the pack unreadable).
+    write_file_atomically(index_path(packs_dir_, active_id_), "pack index", [&](std::ostream& idx) {
+        idx.write(out.data(), static_cast<std::streamsize>(out.size()));
+    });
+    active_index_dirty_ = false;
+}
+
+} // namespace dv
@@ -0,0 +1,372 @@
+// src/RestoreEngine.cpp
+#include <duplivault/RestoreEngine.h>
+#include <duplivault/ChunkCache.h>
+#include <duplivault/Compression.h>
+#include <duplivault/IoBackend.h>
+#include <duplivault/Metrics.h>
+#include <duplivault/StorageRepository.h>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace dv {
+
+namespace {
+
+// Where one copy of a chunk goes: a file of the batch and an offset in it.
+struct Target {
+    size_t file;
+    uint64_t offset;
+};
+
+// One distinct chunk to read, and every place it is written to.
+struct ChunkRead {
+    Digest hash;
+    size_t source; // Index into the batch's source files.
+    uint64_t offset;
+    uint32_t stored; // Bytes to read.
+    ChunkCodec codec;
+    uint32_t length; // Once decoded.
+    std::vector<Target> targets;
+    std::shared_ptr<const Chunk> cached; // Set if it needs no read.
+};
+
+// Neighbouring reads from one source file, done as a single request.
+struct Span {
+    size_t source;
+    uint64_t offset;
+    uint64_t length;
+    size_t first; // Range of the sorted reads it covers.
+    size_t last;
+};
+
+// Consecutive spans read as one batch of requests.
+struct Window {
+    size_t first = 0; // Range of spans.
+    size_t last = 0;
+    std::vector<std::byte> buffer;
+    std::vector<size_t> at;                   // Offset of each span in buffer.
+    std::vector<std::unique_ptr<IoFile>> files; // Sources opened for the reads.
+    std::vector<IoRequest> reads;
+    std::vector<size_t> read_of_span; // Index into reads, or NO_READ.
+};
+
+constexpr size_t NO_READ = static_cast<size_t>(-1);
+
+} // anonymous namespace
+
+RestoreEngine::RestoreEngine(StorageRepository& repo, ChunkCache* cache, Metrics* metrics)
+    : repo_(repo), cache_(cache), metrics_(metrics) {}
+
+size_t RestoreEngine::restore(const std::vector<RestoreItem>& items) {
+    // Written one after another, the last of several files with the same
+    // destination would be the one left; keep only that one.
+    std::unordered_map<std::string, size_t> last_for_destination;
+    for (size_t i = 0; i < items.size(); ++i) {
+        last_for_destination[items[i].destination.string()] = i;
+    }
+
+    std::vector<std::vector<const RestoreItem*>> batches;
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (last_for_destination[items[i].destination.string()] != i) {
+            continue;
+        }
+        if (batches.empty() || batches.back().size() == MAX_OPEN_FILES) {
+            batches.emplace_back();
+        }
+        batches.back().push_back(&items[i]);
+    }
+
+    // Which chunks are worth caching is known up front: those that more
+    // than one batch uses. Only they are kept in 'batches_left', so only
+    // they are looked up in the cache.
+    std::unordered_map<Digest, uint32_t> batches_left;
+    if (cache_) {
+        std::unordered_map<Digest, size_t> last_batch;
+        for (size_t b = 0; b < batches.size(); ++b) {
+            for (const RestoreItem* item : batches[b]) {
+                for (const auto& hash : item->manifest.chunk_hashes) {
+                    auto [it, inserted] = last_batch.emplace(hash, b);
+                    if (inserted || it->second != b) {
+                        it->second = b;
+                        batches_left[hash]++;
+                    }
+                }
+            }
+        }
+        for (auto it = batches_left.begin(); it != batches_left.end();) {
+            it = it->second > 1 ? std::next(it) : batches_left.erase(it);
+        }
+    }
+
+    size_t restored = 0;
+    for (const auto& batch : batches) {
+        restored += restore_batch(batch, batches_left);
+    }
+    return restored;
+}
+
+size_t RestoreEngine::restore_batch(const std::vector<const RestoreItem*>& batch,
+                                    std::unordered_map<Digest, uint32_t>& batches_left) {
+    std::vector<bool> failed(batch.size(), false);
+    auto fail = [&](size_t file, const std::string& reason) {
+        if (!failed[file]) {
+            failed[file] = true;
+            std::cerr << "  Fatal error restoring " << batch[file]->destination.filename() << ": " << reason
+                      << ". Restore for this file aborted." << std::endl;
+        }
+    };
+
+    // --- Resolve every chunk of the batch to a location ---
+    std::vector<std::filesystem::path> sources;
+    std::unordered_map<std::string, size_t> source_ids;
+    std::vector<ChunkRead> reads;
+    std::unordered_map<Digest, size_t> read_of;
+    std::vector<uint64_t> sizes(batch.size(), 0);
+    for (size_t f = 0; f < batch.size(); ++f) {
+        const Manifest& manifest = batch[f]->manifest;
+        std::vector<size_t> file_reads;
+        file_reads.reserve(manifest.chunk_hashes.size());
+        for (size_t c = 0; c < manifest.chunk_hashes.size(); ++c) {
+            const Digest& hash = manifest.chunk_hashes[c];
+            if (auto it = read_of.find(hash); it != read_of.end()) {
+                file_reads.push_back(it->second);
+                continue;
+            }
+            // Only chunks used by more than one batch can be cached.
+            if (auto cached = cache_ && batches_left.count(hash) ? cache_->get(hash) : nullptr) {
+                read_of.emplace(hash, reads.size());
+                file_reads.push_back(reads.size());
+                const auto length = static_cast<uint32_t>(cached->size());
+                reads.push_back(ChunkRead{hash, 0, 0, 0, ChunkCodec::Raw, length, {}, std::move(cached)});
+                continue;
+            }
+            const auto source = repo_.locate_chunk(hash);
+            if (!source) {
+                fail(f, "Could not retrieve chunk " + hash.to_hex());
+                break;
+            }
+            // Files are laid out before anything is read, so a compressed
+            // chunk's size comes from the manifest. Only manifests from
+            // before compression lack lengths, and their chunks are raw.
+            uint32_t length = source->length;
+            if (source->codec != ChunkCodec::Raw) {
+                if (manifest.chunk_lengths.empty()) {
+                    fail(f, "The manifest has no length for compressed chunk " + hash.to_hex());
+                    break;
+                }
+                length = manifest.chunk_lengths[c];
+            }
+            const auto [id, inserted] = source_ids.emplace(source->file.string(), sources.size());
+            if (inserted) {
+                sources.push_back(source->file);
+            }
+            read_of.emplace(hash, reads.size());
+            file_reads.push_back(reads.size());
+            reads.push_back(
+                ChunkRead{hash, id->second, source->offset, source->length, source->codec, length, {}, nullptr});
+        }
+        if (failed[f]) {
+            continue;
+        }
+        uint64_t offset = 0;
+        for (size_t r : file_reads) {
+            reads[r].targets.push_back(Target{f, offset});
+            offset += reads[r].length;
+        }
+        sizes[f] = offset;
+    }
+
+    // --- Create the destination files at their final sizes ---
+    std::vector<std::unique_ptr<IoFile>> outputs(batch.size());
+    for (size_t f = 0; f < batch.size(); ++f) {
+        if (failed[f]) continue;
+        outputs[f] = std::make_unique<IoFile>();
+        if (!outputs[f]->create(batch[f]->destination, sizes[f])) {
+            failed[f] = true;
+            std::cerr << "  Error: Could not open destination file for writing: " << batch[f]->destination
+                      << std::endl;
+        }
+    }
+
+    // --- Order the reads by location and merge neighbours into spans ---
+    std::vector<size_t> order;
+    std::vector<size_t> from_cache;
+    for (size_t i = 0; i < reads.size(); ++i) {
+        (reads[i].cached ? from_cache : order).push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return reads[a].source != reads[b].source ? reads[a].source < reads[b].source
+                                                  : reads[a].offset < reads[b].offset;
+    });
+    std::vector<Span> spans;
+    for (size_t k = 0; k < order.size(); ++k) {
+        const ChunkRead& read = reads[order[k]];
+        const uint64_t read_end = read.offset + read.stored;
+        if (!spans.empty()) {
+            Span& span = spans.back();
+            const uint64_t span_end = span.offset + span.length;
+            if (span.source == read.source && read.offset <= span_end + MAX_READ_GAP &&
+                read_end - span.offset <= READ_SPAN_SIZE) {
+                span.length = std::max(span_end, read_end) - span.offset;
+                span.last = k + 1;
+                continue;
+            }
+        }
+        spans.push_back(Span{read.source, read.offset, read.stored, k, k + 1});
+    }
+
+    // A chunk is cached when read only if a later batch needs it too.
+    auto wanted_later = [&](const Digest& hash) {
+        const auto it = batches_left.find(hash);
+        return it != batches_left.end() && it->second > 1;
+    };
+
+    // Opens the sources of the spans from 'first' on that fit in one
+    // window, and sets up their reads.
+    auto prepare_window = [&](size_t first) {
+        Window window;
+        window.first = window.last = std::min(first, spans.size());
+        size_t bytes = 0;
+        while (window.last < spans.size() && window.last - window.first < MAX_WINDOW_SPANS &&
+               (bytes == 0 || bytes + spans[window.last].length <= READ_WINDOW_SIZE)) {
+            window.at.push_back(bytes);
+            bytes += spans[window.last++].length;
+        }
+        window.buffer.resize(bytes);
+
+        std::map<size_t, IoFile*> opened;
+        for (size_t s = window.first; s < window.last; ++s) {
+            const Span& span = spans[s];
+            IoFile*& file = opened[span.source];
+            if (!file) {
+                window.files.push_back(std::make_unique<IoFile>());
+                if (window.files.back()->open_for_reading(sources[span.source])) {
+                    file = window.files.back().get();
+                }
+            }
+            if (!file) {
+                window.read_of_span.push_back(NO_READ);
+                continue;
+            }
+            window.read_of_span.push_back(window.reads.size());
+            window.reads.push_back(IoRequest{IoRequest::Op::Read, file, span.offset,
+                                             window.buffer.data() + window.at[s - window.first], span.length});
+        }
+        return window;
+    };
+
+    // --- Read the spans a window at a time, in order ---
+    // The writes of each window go to the backend in one batch together
+    // with the reads of the next, so reads stay queued while data is
+    // written out. Cached chunks are written with the first batch.
+    IoBackend& io = repo_.io();
+    auto run = [&](std::vector<IoRequest>& requests) {
+        StageTimer timer(metrics_, Stage::RestoreRead);
+        io.run(requests);
+    };
+    Window current = prepare_window(0);
+    run(current.reads);
+    bool wrote_cached = false;
+    while (current.first < current.last || !wrote_cached) {
+        Window next = prepare_window(current.last);
+
+        std::vector<IoRequest> requests;
+        std::vector<size_t> written_file; // For each write request.
+        std::vector<Chunk> decoded;       // Compressed chunks of this window, decoded.
+        auto write_chunk = [&](const ChunkRead& read, const std::byte* data) {
+            for (const Target& target : read.targets) {
+                if (failed[target.file]) continue;
+                requests.push_back(IoRequest{IoRequest::Op::Write, outputs[target.file].get(), target.offset,
+                                             const_cast<std::byte*>(data), read.length});
+                written_file.push_back(target.file);
+            }
+        };
+        for (size_t s = current.first; s < current.last; ++s) {
+            const Span& span = spans[s];
+            const size_t r = current.read_of_span[s - current.first];
+            const bool read_ok = r != NO_READ && current.reads[r].ok;
+            if (read_ok && metrics_) {
+                metrics_->add(Counter::RestoreBytesRead, span.length);
+            }
+            for (size_t k = span.first; k < span.last; ++k) {
+                const ChunkRead& read = reads[order[k]];
+                if (!read_ok) {
+                    for (const Target& target : read.targets) {
+                        fail(target.file, "Could not read chunk data from " + sources[span.source].string());
+                    }
+                    continue;
+                }
+                const std::byte* data = current.buffer.data() + current.at[s - current.first] + (read.offset - span.offset);
+                if (read.codec != ChunkCodec::Raw) {
+                    decoded.emplace_back(read.length);
+                    StageTimer decode(metrics_, Stage::Decompress);
+                    const bool decoded_ok =
+                        decompress_chunk(read.codec, ByteSpan(data, read.stored), decoded.back().data(), read.length);
+                    decode.stop();
+                    if (!decoded_ok) {
+                        for (const Target& target : read.targets) {
+                            fail(target.file, "Chunk " + read.hash.to_hex() + " is corrupt");
+                        }
+                        continue;
+                    }
+                    data = decoded.back().data();
+                }
+                if (cache_ && wanted_later(read.hash)) {
+                    cache_->put(read.hash, ByteSpan(data, read.length));
+                }
+                write_chunk(read, data);
+            }
+        }
+        if (!wrote_cached) {
+            for (size_t r : from_cache) {
+                write_chunk(reads[r], reads[r].cached->data());
+            }
+            wrote_cached = true;
+        }
+
+        const size_t writes = requests.size();
+        requests.insert(requests.end(), next.reads.begin(), next.reads.end());
+        run(requests);
+        for (size_t w = 0; w < writes; ++w) {
+            if (!requests[w].ok) {
+                fail(written_file[w], "Could not write to " + batch[written_file[w]]->destination.string());
+            }
+        }
+        for (size_t r = 0; r < next.reads.size(); ++r) {
+            next.reads[r].ok = requests[writes + r].ok;
+        }
+        current = std::move(next);
+    }
+
+    for (const auto& [hash, read] : read_of) {
+        if (auto it = batches_left.find(hash); it != batches_left.end() && --it->second == 0) {
+            batches_left.erase(it);
+        }
+    }
+
+    // --- Close the files, removing those that could not be completed ---
+    size_t restored = 0;
+    for (size_t f = 0; f < batch.size(); ++f) {
+        if (outputs[f] && !outputs[f]->close()) {
+            fail(f, "Could not write to " + batch[f]->destination.string());
+        }
+        if (failed[f]) {
+            std::error_code ignored;
+            if (outputs[f]) std::filesystem::remove(batch[f]->destination, ignored);
+        } else {
+            restored++;
+            if (metrics_) {
+                metrics_->add(Counter::FilesRestored);
+                metrics_->add(Counter::BytesRestored, sizes[f]);
+            }
+        }
+    }
+    return restored;
+}
+
+} // namespace dv
@@ -0,0 +1,240 @@
+// src/Snapshot.cpp
+#include <duplivault/Snapshot.h>
+#include "Varint.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+namespace dv {
+
+namespace {
+
+constexpr char TREE_MAGIC[4] = {'D', 'V', 'T', 'R'};
+constexpr char SNAPSHOT_MAGIC[4] = {'D', 'V', 'S', 'N'};
+constexpr size_t HEADER_SIZE = 8;
+
+void put_header(std::vector<std::byte>& out, const char (&magic)[4], uint8_t version) {
+    for (char c : magic) out.push_back(static_cast<std::byte>(c));
+    out.push_back(static_cast<std::byte>(version));
+    out.insert(out.end(), 3, std::byte{0});
+}
+
+// Checks the header and returns a pointer past it.
+const std::byte* check_header(ByteSpan bytes, const char (&magic)[4], uint8_t version, const char* what) {
+    if (bytes.size < HEADER_SIZE || std::memcmp(bytes.data, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error(std::string("Not a DupliVault ") + what);
+    }
+    if (static_cast<uint8_t>(bytes.data[4]) != version) {
+        throw std::runtime_error(std::string("Unsupported ") + what + " version " +
+                                 std::to_string(static_cast<uint8_t>(bytes.data[4])));
+    }
+    return bytes.data + HEADER_SIZE;
+}
+
+void put_string(std::vector<std::byte>& out, const std::string& s) {
+    detail::put_varint(out, s.size());
+    for (char c : s) out.push_back(static_cast<std::byte>(c));
+}
+
+std::string get_string(const std::byte*& p, const std::byte* end, const char* what) {
+    const uint64_t size = detail::get_varint(p, end, what);
+    if (size > static_cast<uint64_t>(end - p)) {
+        throw std::runtime_error(std::string("Truncated ") + what);
+    }
+    std::string s(reinterpret_cast<const char*>(p), size);
+    p += size;
+    return s;
+}
+
+void put_digest(std::vector<std::byte>& out, const Digest& digest) {
+    const auto* bytes = reinterpret_cast<const std::byte*>(digest.bytes.data());
+    out.insert(out.end(), bytes, bytes + Digest::SIZE);
+}
+
+Digest get_digest(const std::byte*& p, const std::byte* end, const char* what) {
+    if (end - p < static_cast<std::ptrdiff_t>(Digest::SIZE)) {
+        throw std::runtime_error(std::string("Truncated ") + what);
+    }
+    Digest digest;
+    std::memcpy(digest.bytes.data(), p, Digest::SIZE);
+    p += Digest::SIZE;
+    return digest;
+}
+
+// A directory while its trees are being built.
+struct DirNode {
+    std::map<std::string, DirNode> dirs;
+    std::map<std::string, Digest> files;
+    std::optional<Subtree> reused; // Taken over whole; the maps stay empty.
+};
+
+using TreeStorer = std::function<Digest(const std::string& path, const Tree&, uint64_t files)>;
+
+// Returns the node's tree ref and the number of files under it.
+std::pair<Digest, uint64_t> store_node(const DirNode& node, const std::string& path, const TreeStorer& store_tree) {
+    if (node.reused) {
+        return {node.reused->ref, node.reused->files};
+    }
+    // Both maps are sorted, so merging them keeps the entries sorted.
+    Tree tree;
+    uint64_t files = node.files.size();
+    auto dir = node.dirs.begin();
+    auto file = node.files.begin();
+    while (dir != node.dirs.end() || file != node.files.end()) {
+        if (file == node.files.end() || (dir != node.dirs.end() && dir->first < file->first)) {
+            const auto [ref, count] = store_node(dir->second, path.empty() ? dir->first : path + "/" + dir->first,
+                                                 store_tree);
+            tree.entries.push_back({dir->first, TreeEntryType::Directory, ref});
+            files += count;
+            ++dir;
+        } else {
+            tree.entries.push_back({file->first, TreeEntryType::File, file->second});
+            ++file;
+        }
+    }
+    return {store_tree(path, tree, files), files};
+}
+
+// The node for the directory at 'path', created with its parents if need be.
+DirNode& node_at(DirNode& root, const std::string& path) {
+    DirNode* node = &root;
+    size_t start = 0;
+    for (size_t slash = path.find('/'); start < path.size(); slash = path.find('/', start)) {
+        if (slash == std::string::npos) slash = path.size();
+        node = &node->dirs[path.substr(start, slash - start)];
+        start = slash + 1;
+    }
+    return *node;
+}
+
+void walk_node(const Digest& ref, const std::string& prefix, const std::function<Tree(const Digest&)>& load_tree,
+               const std::function<void(const std::string&, const Digest&)>& fn) {
+    for (const auto& entry : load_tree(ref).entries) {
+        const std::string path = prefix.empty() ? entry.name : prefix + "/" + entry.name;
+        if (entry.type == TreeEntryType::Directory) {
+            walk_node(entry.ref, path, load_tree, fn);
+        } else {
+            fn(path, entry.ref);
+        }
+    }
+}
+
+} // anonymous namespace
+
+std::vector<std::byte> Tree::serialize() const {
+    std::vector<std::byte> out;
+    put_header(out, TREE_MAGIC, VERSION);
+    detail::put_varint(out, entries.size());
+    for (const auto& entry : entries) {
+        out.push_back(static_cast<std::byte>(entry.type));
+        put_string(out, entry.name);
+        put_digest(out, entry.ref);
+    }
+    return out;
+}
+
+Tree Tree::parse(ByteSpan bytes) {
+    const std::byte* p = check_header(bytes, TREE_MAGIC, VERSION, "tree");
+    const std::byte* end = bytes.data + bytes.size;
+    Tree tree;
+    const uint64_t count = detail::get_varint(p, end, "tree");
+    for (uint64_t i = 0; i < count; ++i) {
+        if (p == end) {
+            throw std::runtime_error("Truncated tree");
+        }
+        const auto type = static_cast<uint8_t>(*p++);
+        if (type > static_cast<uint8_t>(TreeEntryType::Directory)) {
+            throw std::runtime_error("Unknown tree entry type " + std::to_string(type));
+        }
+        TreeEntry entry;
+        entry.type = static_cast<TreeEntryType>(type);
+        entry.name = get_string(p, end, "tree");
+        entry.ref = get_digest(p, end, "tree");
+        tree.entries.push_back(std::move(entry));
+    }
+    if (p != end) {
+        throw std::runtime_error("Trailing bytes after tree");
+    }
+    return tree;
+}
+
+std::vector<std::byte> Snapshot::serialize() const {
+    std::vector<std::byte> out;
+    put_header(out, SNAPSHOT_MAGIC, VERSION);
+    const auto time = static_cast<uint64_t>(time_ns);
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<std::byte>(time >> (8 * i)));
+    put_digest(out, root);
+    detail::put_varint(out, file_count);
+    put_string(out, source_path);
+    return out;
+}
+
+Snapshot Snapshot::parse(ByteSpan bytes) {
+    const std::byte* p = check_header(bytes, SNAPSHOT_MAGIC, VERSION, "snapshot");
+    const std::byte* end = bytes.data + bytes.size;
+    if (end - p < 8) {
+        throw std::runtime_error("Truncated snapshot");
+    }
+    Snapshot snapshot;
+    uint64_t time = 0;
+    for (int i = 0; i < 8; ++i) time |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    snapshot.time_ns = static_cast<int64_t>(time);
+    p += 8;
+    snapshot.root = get_digest(p, end, "snapshot");
+    snapshot.file_count = detail::get_varint(p, end, "snapshot");
+    snapshot.source_path = get_string(p, end, "snapshot");
+    if (p != end) {
+        throw std::runtime_error("Trailing bytes after snapshot");
+    }
+    return snapshot;
+}
+
+Digest build_trees(const std::vector<std::pair<std::string, Digest>>& files,
+                   const std::function<Digest(const Tree&)>& store_tree) {
+    return build_trees(files, {}, [&](const std::string&, const Tree& tree, uint64_t) { return store_tree(tree); });
+}
+
+Digest build_trees(const std::vector<std::pair<std::string, Digest>>& files, const std::vector<Subtree>& subtrees,
+                   const std::function<Digest(const std::string& path, const Tree&, uint64_t files)>& store_tree) {
+    DirNode root;
+    for (const auto& subtree : subtrees) {
+        node_at(root, subtree.path).reused = subtree;
+    }
+    for (const auto& [path, ref] : files) {
+        const size_t slash = path.rfind('/');
+        DirNode& node = slash == std::string::npos ? root : node_at(root, path.substr(0, slash));
+        node.files[slash == std::string::npos ? path : path.substr(slash + 1)] = ref;
+    }
+    return store_node(root, "", store_tree).first;
+}
+
+void walk_trees(const Digest& root, const std::function<Tree(const Digest&)>& load_tree,
+                const std::function<void(const std::string&, const Digest&)>& fn) {
+    walk_node(root, "", load_tree, fn);
+}
+
+std::optional<Digest> find_in_trees(const Digest& root, const std::string& relative_path,
+                                    const std::function<Tree(const Digest&)>& load_tree) {
+    Digest ref = root;
+    size_t start = 0;
+    while (true) {
+        const size_t slash = relative_path.find('/', start);
+        const bool last = slash == std::string::npos;
+        const std::string name = relative_path.substr(start, last ? std::string::npos : slash - start);
+        const Tree tree = load_tree(ref);
+        const auto it = std::lower_bound(tree.entries.begin(), tree.entries.end(), name,
+                                         [](const TreeEntry& entry, const std::string& n) { return entry.name < n; });
+        if (it == tree.entries.end() || it->name != name || (it->type == TreeEntryType::Directory) == last) {
+            return std::nullopt;
+        }
+        if (last) {
+            return it->ref;
+        }
+        ref = it->ref;
+        start = slash + 1;
+    }
+}
+
+} // namespace dv
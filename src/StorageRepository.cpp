@@ -1,55 +1,198 @@
 // src/StorageRepository.cpp
 #include <duplivault/StorageRepository.h>
+#include <duplivault/PackStore.h>
+#include <duplivault/FileSync.h>
+#include <duplivault/FileScan.h>
+#include <algorithm>
 #include <fstream>
+#include <mutex>
 #include <iostream>
 #include <stdexcept>
+#include <tuple>
 #include <duplivault/Hasher.h>
 #include "json.hpp"
 
 namespace dv {
 
-StorageRepository::StorageRepository(std::filesystem::path repo_path) : root_path_(std::move(repo_path)) {}
+namespace {
 
-void StorageRepository::init() {
-    std::filesystem::create_directories(root_path_ / "objects");
-    std::filesystem::create_directories(root_path_ / "metadata");
+// Pack records past the synced indexes may hold garbage after a power
+// loss. One is kept only if its content still hashes to its digest, so
+// chunk_exists() never vouches for a chunk that cannot be read back.
+bool record_is_intact(const Digest& hash, ByteSpan stored, uint32_t flags) {
+    const ChunkCodec codec = codec_from_flags(flags);
+    if (codec == ChunkCodec::Raw) {
+        return Hasher().compute(stored.data, stored.size) == hash;
+    }
+    // A garbage header could claim any size; no valid stream expands
+    // by more than 255 times.
+    const auto size = raw_size_of(codec, stored);
+    if (!size || *size / 256 > stored.size) {
+        return false;
+    }
+    Chunk raw(*size);
+    return decompress_chunk(codec, stored, raw.data(), raw.size()) && Hasher().compute(raw) == hash;
 }
 
-std::filesystem::path StorageRepository::path_for_chunk(const std::string& hash) const {
-    // Use the first 2 characters of the hash as a subdirectory
-    // to prevent having too many files in one folder.
-    // e.g., hash "0a1b2c..." -> <repo>/objects/0a/0a1b2c...
-    if (hash.length() < 2) {
-        throw std::invalid_argument("Hash is too short.");
+// Directories are cataloged under their path with a trailing '/', which
+// no file's path has.
+std::string directory_key(const std::filesystem::path& canonical_path) {
+    std::string key = canonical_path.string();
+    if (key.empty() || key.back() != '/') key += '/';
+    return key;
+}
+
+// Marks the record of the directory holding 'key' (a file's or a
+// directory's) racy, so the next backup through it rebuilds its tree.
+void invalidate_parent(Catalog& catalog, const std::string& key) {
+    if (key.size() <= 1) return; // The root has no parent.
+    const size_t end = key.back() == '/' ? key.size() - 1 : key.size();
+    const size_t slash = key.rfind('/', end - 1);
+    if (slash == std::string::npos) return;
+    auto parent = catalog.find(key.substr(0, slash + 1));
+    if (parent && !parent->racy) {
+        parent->racy = true;
+        catalog.insert(std::move(*parent));
+    }
+}
+
+} // anonymous namespace
+
+StorageRepository::StorageRepository(std::filesystem::path repo_path, uint64_t target_pack_size)
+    : root_path_(std::move(repo_path)),
+      packs_(std::make_unique<PackStore>(root_path_ / "packs", target_pack_size, record_is_intact)) {
+    // One directory walk now instead of a stat per lookup later.
+    const auto objects_path = root_path_ / "objects";
+    if (std::filesystem::exists(objects_path)) {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(objects_path)) {
+            if (!entry.is_regular_file()) continue;
+            try {
+                loose_objects_.insert(Digest::from_hex(entry.path().filename().string()));
+            } catch (const std::invalid_argument&) {
+                // Not an object; migrate_loose_objects() reports it.
+            }
+        }
     }
-    return root_path_ / "objects" / hash.substr(0, 2) / hash;
+
+    // A filter that does not hold exactly the stored chunks (e.g. a crash
+    // came between saving the index and the filter) could give false
+    // negatives, so it is only trusted if its key count matches.
+    const size_t stored = packs().size() + loose_objects_.size();
+    if (!filter_.load(root_path_ / "chunk-filter.bin") || filter_.size() != stored || stored > filter_.capacity()) {
+        rebuild_filter_locked();
+    }
+
+    catalog_.load(root_path_ / "catalog.bin");
+    const auto metadata_path = root_path_ / "metadata";
+    has_legacy_metadata_ = std::filesystem::exists(metadata_path) && !std::filesystem::is_empty(metadata_path);
 }
 
-bool StorageRepository::chunk_exists(const std::string& hash) const {
-    return std::filesystem::exists(path_for_chunk(hash));
+StorageRepository::~StorageRepository() {
+    try {
+        flush();
+    } catch (...) {
+        // The next open rebuilds whatever was not saved.
+    }
 }
 
-void StorageRepository::store_chunk(const std::string& hash, const Chunk& chunk_data) {
-    const auto final_path = path_for_chunk(hash);
-    const auto parent_dir = final_path.parent_path();
+void StorageRepository::init(ChunkingEngine engine) {
+    std::filesystem::create_directories(root_path_ / "packs");
+
+    const auto config_path = root_path_ / "config";
+    if (std::filesystem::exists(config_path)) {
+        if (chunking_engine() != engine) {
+            throw std::runtime_error("Repository already uses the '" + std::string(to_string(chunking_engine())) +
+                                     "' chunking engine.");
+        }
+        return;
+    }
+
+    nlohmann::json config;
+    config["version"] = 1;
+    config["chunker"] = to_string(engine);
+    write_file_atomically(config_path, "repository config", [&](std::ostream& out) { out << config.dump(4); });
+}
+
+ChunkingEngine StorageRepository::chunking_engine() const {
+    const auto config_path = root_path_ / "config";
+    if (!std::filesystem::exists(config_path)) {
+        return ChunkingEngine::Buzhash;
+    }
+    std::ifstream in_file(config_path);
+    const auto config = nlohmann::json::parse(in_file);
+    const auto engine = parse_chunking_engine(config.value("chunker", "buzhash"));
+    if (!engine) {
+        throw std::runtime_error("Unknown chunking engine in " + config_path.string());
+    }
+    return *engine;
+}
+
+std::filesystem::path StorageRepository::path_for_chunk(const Digest& hash) const {
+    // Loose objects (from before pack files) use the first 2 characters
+    // of the hash as a subdirectory.
+    // e.g., hash "0a1b2c..." -> <repo>/objects/0a/0a1b2c...
+    const std::string hex = hash.to_hex();
+    return root_path_ / "objects" / hex.substr(0, 2) / hex;
+}
 
-    // Create the subdirectory (e.g., '.../objects/0a/') if it doesn't exist
-    if (!std::filesystem::exists(parent_dir)) {
-        std::filesystem::create_directories(parent_dir);
+bool StorageRepository::chunk_exists(const Digest& hash) const {
+    std::shared_lock<std::shared_mutex> lock(chunks_mutex_);
+    if (!filter_.may_contain(hash)) {
+        definitely_new_.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
+    if (packs().find(hash).has_value() || loose_objects_.count(hash) != 0) {
+        confirmed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    false_positives_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void StorageRepository::store_chunk(const Digest& hash, ByteSpan chunk_data) {
+    Chunk compressed = compress_buffers_.acquire();
+    if (compress_chunk(chunk_data, compressed) == ChunkCodec::Lz) {
+        store_chunk(hash, compressed, ChunkCodec::Lz);
+    } else {
+        store_chunk(hash, chunk_data, ChunkCodec::Raw);
+    }
+    compress_buffers_.release(std::move(compressed));
+}
 
-    // Write the chunk data to the file
-    std::ofstream out_file(final_path, std::ios::binary | std::ios::trunc);
-    if (!out_file) {
-        throw std::runtime_error("Failed to open file for writing: " + final_path.string());
+void StorageRepository::store_chunk(const Digest& hash, ByteSpan stored, ChunkCodec codec) {
+    std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+    packs().append(hash, stored, flags_for_codec(codec));
+    if (filter_.size() >= filter_.capacity()) {
+        rebuild_filter_locked(); // Now includes 'hash'.
+    } else {
+        filter_.insert(hash);
+        filter_dirty_ = true;
     }
-    out_file.write(reinterpret_cast<const char*>(chunk_data.data()), chunk_data.size());
 }
 
-Chunk StorageRepository::retrieve_chunk(const std::string& hash) const {
+Chunk StorageRepository::retrieve_chunk(const Digest& hash) const {
+    {
+        // Reading may flush the active pack's write buffer.
+        std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+        if (auto location = packs().find(hash)) {
+            Chunk stored = packs().read(*location);
+            const ChunkCodec codec = codec_from_flags(location->flags);
+            if (codec == ChunkCodec::Raw) {
+                return stored;
+            }
+            lock.unlock();
+            try {
+                return decompress_chunk(codec, stored);
+            } catch (const std::runtime_error& e) {
+                throw std::runtime_error("Chunk " + hash.to_hex() + ": " + e.what());
+            }
+        }
+    }
+
+    // Fall back to a loose object from an unmigrated repository.
     const auto final_path = path_for_chunk(hash);
     if (!std::filesystem::exists(final_path)) {
-        throw std::runtime_error("Chunk does not exist: " + hash);
+        throw std::runtime_error("Chunk does not exist: " + hash.to_hex());
     }
 
     std::ifstream in_file(final_path, std::ios::binary | std::ios::ate);
@@ -62,55 +205,376 @@ Chunk StorageRepository::retrieve_chunk(const std::string& hash) const {
 
     Chunk chunk_data(size);
     if (!in_file.read(reinterpret_cast<char*>(chunk_data.data()), size)) {
-        throw std::runtime_error("Failed to read chunk data: " + hash);
+        throw std::runtime_error("Failed to read chunk data: " + hash.to_hex());
     }
     
     return chunk_data;
 }
+
+std::optional<ChunkSource> StorageRepository::locate_chunk(const Digest& hash) const {
+    {
+        std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+        if (auto location = packs().find(hash)) {
+            return ChunkSource{packs().prepare_read(*location), location->offset, location->length,
+                               codec_from_flags(location->flags)};
+        }
+    }
+    const auto loose_path = path_for_chunk(hash);
+    std::error_code error;
+    const auto size = std::filesystem::file_size(loose_path, error);
+    if (error) {
+        return std::nullopt;
+    }
+    return ChunkSource{loose_path, 0, static_cast<uint32_t>(size)};
+}
+
+size_t StorageRepository::chunk_count() const {
+    std::shared_lock<std::shared_mutex> lock(chunks_mutex_);
+    return packs().size() + loose_objects_.size();
+}
+
+void StorageRepository::flush() {
+    {
+        std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+        packs().flush();
+        // Legacy repositories that were never written to stay untouched.
+        if (filter_dirty_ && std::filesystem::exists(root_path_ / "packs")) {
+            filter_.save(root_path_ / "chunk-filter.bin");
+            filter_dirty_ = false;
+        }
+    }
+
+    // After the packs, so the catalog never refers to an unwritten manifest.
+    std::unique_lock<std::shared_mutex> lock(catalog_mutex_);
+    if (catalog_.dirty()) {
+        catalog_.save(root_path_ / "catalog.bin");
+    }
+    // Once the catalog is on disk, older metadata files for the same paths
+    // are no longer needed.
+    for (const auto& path : superseded_metadata_) {
+        std::error_code ignored;
+        std::filesystem::remove(path, ignored);
+    }
+    superseded_metadata_.clear();
+}
+
+void StorageRepository::rebuild_filter() {
+    std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+    rebuild_filter_locked();
+}
+
+void StorageRepository::rebuild_filter_locked() {
+    // Twice the current count leaves room to grow before the next rebuild.
+    constexpr size_t MIN_FILTER_CAPACITY = 64 * 1024;
+    const size_t stored = packs().size() + loose_objects_.size();
+    filter_ = BloomFilter(std::max(MIN_FILTER_CAPACITY, 2 * stored));
+    packs().index().for_each([this](const Digest& hash, const PackLocation&) { filter_.insert(hash); });
+    for (const auto& hash : loose_objects_) {
+        filter_.insert(hash);
+    }
+    filter_dirty_ = true;
+}
+
+FilterStats StorageRepository::filter_stats() const {
+    FilterStats stats;
+    stats.definitely_new = definitely_new_.load(std::memory_order_relaxed);
+    stats.confirmed = confirmed_.load(std::memory_order_relaxed);
+    stats.false_positives = false_positives_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+IoBackend& StorageRepository::io() const {
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    if (!io_) {
+        io_ = make_io_backend();
+    }
+    return *io_;
+}
+
+void StorageRepository::set_io_backend(std::unique_ptr<IoBackend> io) {
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    io_ = std::move(io);
+}
+
+size_t StorageRepository::migrate_loose_objects() {
+    const auto objects_path = root_path_ / "objects";
+    if (!std::filesystem::exists(objects_path)) {
+        return 0;
+    }
+
+    // Collect first: we delete files as we go.
+    std::vector<std::filesystem::path> loose;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(objects_path)) {
+        if (entry.is_regular_file()) {
+            loose.push_back(entry.path());
+        }
+    }
+
+    Hasher hasher;
+    std::vector<std::filesystem::path> migrated;
+    for (const auto& path : loose) {
+        Digest hash;
+        try {
+            hash = Digest::from_hex(path.filename().string());
+        } catch (const std::invalid_argument&) {
+            std::cerr << "Warning: Skipping unexpected file in objects/: " << path << std::endl;
+            continue;
+        }
+
+        Chunk data = retrieve_chunk(hash);
+        if (hasher.compute(data) != hash) {
+            std::cerr << "Warning: Loose object " << path << " does not match its hash; left in place." << std::endl;
+            continue;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+        if (!packs().find(hash)) {
+            packs().append(hash, data);
+        }
+        migrated.push_back(path);
+    }
+
+    // The packs must be on disk before the loose copies go.
+    flush();
+    for (const auto& path : migrated) {
+        std::filesystem::remove(path);
+        std::unique_lock<std::shared_mutex> lock(chunks_mutex_);
+        loose_objects_.erase(Digest::from_hex(path.filename().string()));
+    }
+
+    // Remove the now-empty fan-out directories.
+    for (const auto& entry : std::filesystem::directory_iterator(objects_path)) {
+        if (entry.is_directory() && std::filesystem::is_empty(entry.path())) {
+            std::filesystem::remove(entry.path());
+        }
+    }
+    return migrated.size();
+}
+
 // This helper creates a unique, safe filename for a metadata file
 // by hashing the original file's canonical path.
-std::filesystem::path StorageRepository::path_for_metadata(const std::filesystem::path& original_path) {
+std::filesystem::path StorageRepository::path_for_metadata(const std::filesystem::path& original_path) const {
     dv::Hasher hasher; // We can create a hasher on the fly
     std::string path_str = std::filesystem::weakly_canonical(original_path).string();
     std::vector<std::byte> path_bytes(path_str.size());
     std::transform(path_str.begin(), path_str.end(), path_bytes.begin(), [](char c){ return std::byte(c); });
 
-    std::string path_hash = hasher.compute(path_bytes);
-    return root_path_ / "metadata" / path_hash;
+    return root_path_ / "metadata" / hasher.compute(path_bytes).to_hex();
 }
 
-void StorageRepository::store_metadata(const std::filesystem::path& original_path, const nlohmann::json& metadata) {
-    const auto final_path = path_for_metadata(original_path);
-    std::ofstream out_file(final_path);
-    out_file << metadata.dump(4); // pretty-print with 4-space indent
+namespace {
+
+Manifest read_manifest_file(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<std::byte> bytes(std::filesystem::file_size(path));
+    if (!in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+        throw std::runtime_error("Failed to read manifest " + path.string());
+    }
+    const ByteSpan span(bytes.data(), bytes.size());
+    if (ManifestView::is_manifest(span)) {
+        return ManifestView(span).to_manifest();
+    }
+    // Written by a version that stored metadata as JSON.
+    try {
+        return Manifest::from_json(nlohmann::json::parse(bytes.begin(), bytes.end()));
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Failed to parse manifest " + path.string() + ": " + e.what());
+    }
 }
 
-std::optional<nlohmann::json> StorageRepository::retrieve_metadata(const std::filesystem::path& original_path) {
+} // anonymous namespace
+
+Digest StorageRepository::store_blob(ByteSpan bytes) {
+    const Digest ref = Hasher().compute(bytes.data, bytes.size);
+    if (!chunk_exists(ref)) {
+        store_chunk(ref, bytes);
+    }
+    return ref;
+}
+
+Manifest StorageRepository::load_manifest(const Digest& ref) const {
+    const Chunk bytes = retrieve_chunk(ref);
+    return ManifestView(bytes).to_manifest();
+}
+
+std::optional<CatalogEntry> StorageRepository::find_file(const std::filesystem::path& canonical_path) const {
+    std::shared_lock<std::shared_mutex> lock(catalog_mutex_);
+    return catalog_.find(canonical_path.string());
+}
+
+Digest StorageRepository::store_manifest(const std::filesystem::path& canonical_path, const Manifest& manifest,
+                                         const FileStat& stat, bool racy) {
+    const Digest ref = store_blob(manifest.serialize());
+
+    std::unique_lock<std::shared_mutex> lock(catalog_mutex_);
+    catalog_.insert(CatalogEntry{canonical_path.string(), stat, ref, racy});
+    invalidate_parent(catalog_, canonical_path.string());
+    if (has_legacy_metadata_) {
+        superseded_metadata_.push_back(path_for_metadata(canonical_path));
+    }
+    return ref;
+}
+
+std::optional<Manifest> StorageRepository::retrieve_manifest(const std::filesystem::path& original_path) {
+    if (auto entry = find_file(canonical_file_path(original_path))) {
+        return load_manifest(entry->manifest);
+    }
+    if (!has_legacy_metadata_) {
+        return std::nullopt;
+    }
     const auto final_path = path_for_metadata(original_path);
     if (!std::filesystem::exists(final_path)) {
         return std::nullopt;
     }
-    std::ifstream in_file(final_path);
-    return nlohmann::json::parse(in_file);
+    return read_manifest_file(final_path);
 }
-std::vector<nlohmann::json> StorageRepository::list_all_metadata() {
-    std::vector<nlohmann::json> all_metadata;
-    const auto metadata_path = root_path_ / "metadata";
-    if (!std::filesystem::exists(metadata_path)) {
-        return all_metadata; // Return empty vector if metadata dir doesn't exist
+
+std::vector<Manifest> StorageRepository::list_all_manifests() {
+    std::vector<CatalogEntry> entries;
+    {
+        std::shared_lock<std::shared_mutex> lock(catalog_mutex_);
+        entries.reserve(catalog_.size());
+        catalog_.for_each([&](const CatalogEntry& entry) {
+            if (entry.path.back() != '/') entries.push_back(entry);
+        });
+    }
+
+    std::vector<Manifest> manifests;
+    for (const auto& entry : entries) {
+        try {
+            manifests.push_back(load_manifest(entry.manifest));
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Warning: Could not read the manifest of " << entry.path << ". Error: " << e.what() << std::endl;
+        }
     }
 
+    const auto metadata_path = root_path_ / "metadata";
+    if (!has_legacy_metadata_ || !std::filesystem::exists(metadata_path)) {
+        return manifests;
+    }
     for (const auto& dir_entry : std::filesystem::directory_iterator(metadata_path)) {
         if (dir_entry.is_regular_file()) {
-            std::ifstream in_file(dir_entry.path());
             try {
-                all_metadata.push_back(nlohmann::json::parse(in_file));
-            } catch (const nlohmann::json::parse_error& e) {
-                std::cerr << "Warning: Could not parse metadata file " << dir_entry.path() << ". Error: " << e.what() << std::endl;
+                manifests.push_back(read_manifest_file(dir_entry.path()));
+            } catch (const std::runtime_error& e) {
+                std::cerr << "Warning: Could not read metadata file " << dir_entry.path() << ". Error: " << e.what() << std::endl;
             }
         }
     }
+    return manifests;
+}
+
+std::optional<DirectoryRecord> StorageRepository::find_directory(const std::filesystem::path& canonical_path) const {
+    std::shared_lock<std::shared_mutex> lock(catalog_mutex_);
+    const auto entry = catalog_.find(directory_key(canonical_path));
+    if (!entry) return std::nullopt;
+    FileStat stat = entry->stat;
+    stat.size = 0;
+    return DirectoryRecord{stat, entry->manifest, entry->stat.size, entry->racy};
+}
+
+void StorageRepository::store_directory(const std::filesystem::path& canonical_path, const DirectoryRecord& record) {
+    std::string key = directory_key(canonical_path);
+    FileStat stat = record.stat;
+    stat.size = record.files;
+
+    std::unique_lock<std::shared_mutex> lock(catalog_mutex_);
+    const auto previous = catalog_.find(key);
+    if (!previous || previous->manifest != record.tree) {
+        invalidate_parent(catalog_, key);
+    }
+    catalog_.insert(CatalogEntry{std::move(key), stat, record.tree, record.racy});
+}
+
+Digest StorageRepository::store_tree(const Tree& tree) {
+    return store_blob(tree.serialize());
+}
+
+Tree StorageRepository::load_tree(const Digest& ref) const {
+    const Chunk bytes = retrieve_chunk(ref);
+    return Tree::parse(bytes);
+}
+
+std::string StorageRepository::store_snapshot(Snapshot snapshot) {
+    // Everything the snapshot refers to must be on disk before it is.
+    flush();
+
+    const auto bytes = snapshot.serialize();
+    snapshot.id = Hasher().compute(bytes).to_hex();
+    const auto snapshots_path = root_path_ / "snapshots";
+    std::filesystem::create_directories(snapshots_path);
+
+    write_file_atomically(snapshots_path / snapshot.id, "snapshot", [&](std::ostream& out) {
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    });
+    return snapshot.id;
+}
+
+std::vector<Snapshot> StorageRepository::list_snapshots() const {
+    std::vector<Snapshot> snapshots;
+    const auto snapshots_path = root_path_ / "snapshots";
+    if (!std::filesystem::exists(snapshots_path)) {
+        return snapshots;
+    }
+    for (const auto& dir_entry : std::filesystem::directory_iterator(snapshots_path)) {
+        if (!dir_entry.is_regular_file() || dir_entry.path().extension() == ".tmp") {
+            continue;
+        }
+        try {
+            std::ifstream in(dir_entry.path(), std::ios::binary);
+            std::vector<std::byte> bytes(dir_entry.file_size());
+            if (!in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+                throw std::runtime_error("Failed to read file");
+            }
+            Snapshot snapshot = Snapshot::parse(bytes);
+            snapshot.id = dir_entry.path().filename().string();
+            snapshots.push_back(std::move(snapshot));
+        } catch (const std::runtime_error& e) {
+            std::cerr << "Warning: Could not read snapshot " << dir_entry.path() << ". Error: " << e.what() << std::endl;
+        }
+    }
+    std::sort(snapshots.begin(), snapshots.end(),
+              [](const Snapshot& a, const Snapshot& b) { return std::tie(a.time_ns, a.id) < std::tie(b.time_ns, b.id); });
+    return snapshots;
+}
+
+Snapshot StorageRepository::find_snapshot(const std::string& id_prefix) const {
+    std::optional<Snapshot> found;
+    for (auto& snapshot : list_snapshots()) {
+        if (!id_prefix.empty() && snapshot.id.compare(0, id_prefix.size(), id_prefix) == 0) {
+            if (found) {
+                throw std::runtime_error("Snapshot id '" + id_prefix + "' is ambiguous.");
+            }
+            found = std::move(snapshot);
+        }
+    }
+    if (!found) {
+        throw std::runtime_error("No snapshot with id '" + id_prefix + "'.");
+    }
+    return *found;
+}
+
+void StorageRepository::store_metadata(const std::filesystem::path& original_path, const nlohmann::json& metadata) {
+    const Manifest manifest = Manifest::from_json(metadata);
+    FileStat stat;
+    stat.mod_time_ns = manifest.mod_time_ns;
+    store_manifest(canonical_file_path(original_path), manifest, stat);
+}
+
+std::optional<nlohmann::json> StorageRepository::retrieve_metadata(const std::filesystem::path& original_path) {
+    auto manifest = retrieve_manifest(original_path);
+    if (!manifest) {
+        return std::nullopt;
+    }
+    return manifest->to_json();
+}
+
+std::vector<nlohmann::json> StorageRepository::list_all_metadata() {
+    std::vector<nlohmann::json> all_metadata;
+    for (const auto& manifest : list_all_manifests()) {
+        all_metadata.push_back(manifest.to_json());
+    }
     return all_metadata;
 }
 
-} // namespace dv
\ No newline at end of file
+} // namespace dv
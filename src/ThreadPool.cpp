@@ -0,0 +1,130 @@
+// src/ThreadPool.cpp
+#include <duplivault/ThreadPool.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace dv {
+
+namespace {
+
+// Shared by the caller of parallel_for() and the helper tasks it queues.
+// Helpers may be dequeued after the loop has returned, so they hold it by
+// shared_ptr and check 'closed' before touching the caller's function.
+struct LoopState {
+    const std::function<void(size_t)>* fn = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    unsigned active = 0; // Helpers currently running indices.
+    bool closed = false; // Set once the caller has stopped waiting for helpers to join.
+
+    // Claims and runs indices until none are left.
+    void run() {
+        while (!failed) {
+            const size_t i = next++;
+            if (i >= count) {
+                return;
+            }
+            try {
+                (*fn)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    has_work_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    has_work_.notify_one();
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            has_work_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return; // Stopping, and nothing left to do.
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    auto state = std::make_shared<LoopState>();
+    state->fn = &fn;
+    state->count = count;
+
+    // One helper per worker at most; the calling thread covers the rest.
+    const size_t helpers = std::min<size_t>(count - 1, workers_.size());
+    for (size_t h = 0; h < helpers; ++h) {
+        enqueue([state]() {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->closed) {
+                    return; // The loop already finished without us.
+                }
+                ++state->active;
+            }
+            state->run();
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                --state->active;
+            }
+            state->idle.notify_all();
+        });
+    }
+
+    state->run();
+
+    // Every index has been claimed. Wait only for helpers that are still
+    // running one; any that have not started yet will see 'closed'.
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->idle.wait(lock, [&] { return state->active == 0; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+} // namespace dv
@@ -0,0 +1,39 @@
+// src/Varint.h
+// Private to the metadata formats (manifests, trees, snapshots): unsigned
+// LEB128 varints, 7 bits per byte, low bits first.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dv::detail {
+
+inline void put_varint(std::vector<std::byte>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::byte>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::byte>(v));
+}
+
+// Decodes a varint at 'p', advancing it. Throws if it runs past 'end';
+// 'what' names the format in the message.
+inline uint64_t get_varint(const std::byte*& p, const std::byte* end, const char* what) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) {
+            throw std::runtime_error(std::string("Truncated ") + what);
+        }
+        const auto b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return v;
+        }
+    }
+    throw std::runtime_error(std::string("Malformed varint in ") + what);
+}
+
+} // namespace dv::detail
@@ -1,8 +1,13 @@
 // src/main.cpp
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
 #include <string>
 #include <filesystem>
 #include <optional>
+#include <thread>
 
 #include "CLI11.hpp"
 #include <duplivault/StorageRepository.h>
@@ -10,48 +15,112 @@
 #include <duplivault/Chunker.h>
 #include <duplivault/BackupOrchestrator.h>
 
+namespace {
+
+// --stats and -v together decide how chatty a run is: a JSON report must
+// be all that is on stdout, unless per-chunk lines were asked for too.
+unsigned verbosity_for(int verbose, const std::string& stats) {
+    if (verbose > 0) return 2;
+    return stats == "json" ? 0 : 1;
+}
+
+} // anonymous namespace
+
 int main(int argc, char** argv) {
     CLI::App app{"DupliVault: A deduplicating backup tool"};
+    int exit_code = 0;
     app.require_subcommand(1);
 
-    // --- 'init' subcommand (unchanged) ---
+    // --- 'init' subcommand ---
     std::string init_repo_path;
+    std::string init_chunker = "buzhash";
     CLI::App* init_cmd = app.add_subcommand("init", "Initialize a new DupliVault repository.");
     init_cmd->add_option("repo_path", init_repo_path, "The path to create the repository at.")->required();
+    init_cmd->add_option("--chunker", init_chunker, "Chunking engine for this repository (fixed for its lifetime).")
+        ->check(CLI::IsMember({"buzhash", "fastcdc"}));
     init_cmd->callback([&]() {
         try {
             dv::StorageRepository repo(init_repo_path);
-            repo.init();
+            repo.init(*dv::parse_chunking_engine(init_chunker));
             std::cout << "Successfully initialized empty repository at: " << init_repo_path << std::endl;
         } catch (const std::exception& e) {
             std::cerr << "Error during initialization: " << e.what() << std::endl;
         }
     });
 
-    // --- 'backup' subcommand (unchanged) ---
+    // --- 'backup' subcommand ---
     std::string backup_source_path;
     std::string backup_repo_path;
+    unsigned backup_jobs = std::max(1u, std::thread::hardware_concurrency());
+    bool backup_append_aware = false;
+    bool backup_mmap = false;
+    bool backup_no_compress = false;
+    int backup_verbose = 0;
+    std::string backup_stats;
     CLI::App* backup_cmd = app.add_subcommand("backup", "Backs up a source directory to a repository.");
     backup_cmd->add_option("source_path", backup_source_path, "The source directory to back up.")->required();
     backup_cmd->add_option("repo_path", backup_repo_path, "The path of the repository.")->required();
+    backup_cmd->add_option("-j,--jobs", backup_jobs, "Number of files to read, chunk and hash in parallel.")
+        ->check(CLI::PositiveNumber);
+    backup_cmd->add_flag("--append-aware", backup_append_aware,
+                         "Assume changed files were only appended to, and chunk just their new tails.");
+    backup_cmd->add_flag("--mmap", backup_mmap,
+                         "Map files instead of reading them as streams (only for sources no one writes to meanwhile).");
+    backup_cmd->add_flag("--no-compress", backup_no_compress, "Store new chunks uncompressed.");
+    backup_cmd->add_flag("-v,--verbose", backup_verbose, "Also print a line for every chunk.");
+    backup_cmd->add_option("--stats", backup_stats, "Report counters and stage timings at the end, as text or json.")
+        ->check(CLI::IsMember({"text", "json"}));
     backup_cmd->callback([&]() {
         try {
             dv::StorageRepository repo(backup_repo_path);
             dv::Hasher hasher;
-            dv::Chunker chunker;
-            dv::BackupOrchestrator orchestrator(chunker, hasher, repo);
-            std::cout << "Starting backup..." << std::endl;
-            orchestrator.run_backup(backup_source_path);
-            std::cout << "Backup complete." << std::endl;
+            dv::Chunker chunker(repo.chunking_engine());
+            dv::OrchestratorOptions options;
+            options.jobs = backup_jobs;
+            options.append_aware = backup_append_aware;
+            options.map_files = backup_mmap;
+            options.compress = !backup_no_compress;
+            options.verbosity = verbosity_for(backup_verbose, backup_stats);
+            dv::BackupOrchestrator orchestrator(chunker, hasher, repo, options);
+            if (backup_stats != "json") std::cout << "Starting backup..." << std::endl;
+            const std::string snapshot_id = orchestrator.run_backup(backup_source_path);
+            const auto filter = repo.filter_stats();
+            if (const uint64_t failed = orchestrator.metrics().get(dv::Counter::FilesFailed)) {
+                std::cerr << "Warning: " << failed
+                          << " changed files could not be read; the snapshot keeps their previous versions."
+                          << std::endl;
+                exit_code = 1;
+            }
+            if (backup_stats == "json") {
+                auto report = orchestrator.metrics().to_json();
+                report["snapshot"] = snapshot_id;
+                report["chunk_lookups"] = {{"definitely_new", filter.definitely_new},
+                                           {"confirmed", filter.confirmed},
+                                           {"false_positives", filter.false_positives}};
+                std::cout << report.dump(4) << std::endl;
+                return;
+            }
+            std::cout << "Backup complete. Created snapshot " << snapshot_id.substr(0, 8) << "." << std::endl;
+            std::cout << "Chunk lookups: " << filter.definitely_new << " ruled out by the filter, " << filter.confirmed
+                      << " found in the index, " << filter.false_positives << " filter false positives." << std::endl;
+            if (backup_stats == "text") {
+                orchestrator.metrics().print(std::cout);
+            }
         } catch (const std::exception& e) {
             std::cerr << "Error during backup: " << e.what() << std::endl;
         }
     });
 
     // --- 'restore' subcommand (CORRECTED) ---
+    std::string restore_snapshot_id;
     std::string restore_repo_path;
     std::string restore_destination_dir;
     std::optional<std::string> restore_original_path_opt;
+    unsigned restore_jobs = std::max(1u, std::thread::hardware_concurrency());
+    size_t restore_cache_mb = 256;
+    std::string restore_io = "auto";
+    int restore_verbose = 0;
+    std::string restore_stats;
     CLI::App* restore_cmd = app.add_subcommand("restore", "Restores files from a repository.");
     
     // --- THIS IS THE FIX ---
@@ -59,26 +128,107 @@ int main(int argc, char** argv) {
     restore_cmd->add_option("-p,--path", restore_original_path_opt, "The original path of the specific file to restore. If omitted, all files are restored.");
     restore_cmd->add_option("-d,--dest", restore_destination_dir, "The folder where files will be restored.")->required();
     restore_cmd->add_option("-r,--repo", restore_repo_path, "The path of the repository.")->required();
+    restore_cmd->add_option("-s,--snapshot", restore_snapshot_id, "Restore from this snapshot (an id or a unique prefix of one) instead of the latest version of each file.");
+    restore_cmd->add_option("-j,--jobs", restore_jobs, "Reads and writes in flight at once with the 'threads' I/O backend.")
+        ->check(CLI::PositiveNumber);
+    restore_cmd->add_option("--io", restore_io, "I/O backend: auto (io_uring where available), threads or io_uring.")
+        ->check(CLI::IsMember({"auto", "threads", "io_uring"}));
+    restore_cmd->add_option("--cache-mb", restore_cache_mb,
+                            "Memory for chunks used by more than one restored file, in MB (0 disables it).");
+    restore_cmd->add_flag("-v,--verbose", restore_verbose, "Print progress (the default unless --stats json is given).");
+    restore_cmd->add_option("--stats", restore_stats, "Report counters and stage timings at the end, as text or json.")
+        ->check(CLI::IsMember({"text", "json"}));
 
     restore_cmd->callback([&]() {
         try {
             dv::StorageRepository repo(restore_repo_path);
+            repo.set_io_backend(dv::make_io_backend(*dv::parse_io_backend_kind(restore_io), restore_jobs));
             dv::Hasher hasher;
-            dv::Chunker chunker;
-            dv::BackupOrchestrator orchestrator(chunker, hasher, repo);
+            dv::Chunker chunker(repo.chunking_engine());
+            dv::OrchestratorOptions options;
+            options.restore_cache_bytes = restore_cache_mb * 1024 * 1024;
+            options.verbosity = verbosity_for(restore_verbose, restore_stats);
+            dv::BackupOrchestrator orchestrator(chunker, hasher, repo, options);
             
             std::optional<std::filesystem::path> path_opt;
             if (restore_original_path_opt) {
                 path_opt = restore_original_path_opt.value();
             }
 
-            orchestrator.run_restore(restore_destination_dir, path_opt);
+            if (!restore_snapshot_id.empty()) {
+                orchestrator.run_restore_snapshot(restore_snapshot_id, restore_destination_dir, path_opt);
+            } else {
+                orchestrator.run_restore(restore_destination_dir, path_opt);
+            }
+            if (restore_stats == "json") {
+                std::cout << orchestrator.metrics().to_json().dump(4) << std::endl;
+            } else if (restore_stats == "text") {
+                orchestrator.metrics().print(std::cout);
+            }
 
         } catch (const std::exception& e) {
             std::cerr << "Error during restore: " << e.what() << std::endl;
         }
     });
 
+    // --- 'migrate' subcommand ---
+    std::string migrate_repo_path;
+    CLI::App* migrate_cmd = app.add_subcommand("migrate", "Moves loose chunk files of an older repository into pack files.");
+    migrate_cmd->add_option("repo_path", migrate_repo_path, "The path of the repository.")->required();
+    migrate_cmd->callback([&]() {
+        try {
+            dv::StorageRepository repo(migrate_repo_path);
+            const size_t migrated = repo.migrate_loose_objects();
+            std::cout << "Migrated " << migrated << " loose objects into pack files." << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error during migration: " << e.what() << std::endl;
+        }
+    });
+
+    // --- 'snapshots' subcommand ---
+    std::string snapshots_repo_path;
+    CLI::App* snapshots_cmd = app.add_subcommand("snapshots", "Lists the snapshots in a repository, oldest first.");
+    snapshots_cmd->add_option("repo_path", snapshots_repo_path, "The path of the repository.")->required();
+    snapshots_cmd->callback([&]() {
+        try {
+            dv::StorageRepository repo(snapshots_repo_path);
+            for (const auto& snapshot : repo.list_snapshots()) {
+                const auto time = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(snapshot.time_ns)));
+                const std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+                std::cout << snapshot.id.substr(0, 8) << "  " << std::put_time(std::localtime(&seconds), "%Y-%m-%d %H:%M:%S")
+                          << "  " << snapshot.file_count << " files  " << snapshot.source_path << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error listing snapshots: " << e.what() << std::endl;
+        }
+    });
+
+    // --- 'dump' subcommand ---
+    std::string dump_repo_path;
+    std::string dump_file_path;
+    CLI::App* dump_cmd = app.add_subcommand("dump", "Prints file manifests as JSON, for debugging and export.");
+    dump_cmd->add_option("repo_path", dump_repo_path, "The path of the repository.")->required();
+    dump_cmd->add_option("-p,--path", dump_file_path, "Print only the manifest of this original file path.");
+    dump_cmd->callback([&]() {
+        try {
+            dv::StorageRepository repo(dump_repo_path);
+            nlohmann::json out = nlohmann::json::array();
+            if (!dump_file_path.empty()) {
+                if (auto manifest = repo.retrieve_manifest(dump_file_path)) {
+                    out.push_back(manifest->to_json());
+                }
+            } else {
+                for (const auto& manifest : repo.list_all_manifests()) {
+                    out.push_back(manifest.to_json());
+                }
+            }
+            std::cout << out.dump(4) << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error during dump: " << e.what() << std::endl;
+        }
+    });
+
     CLI11_PARSE(app, argc, argv);
-    return 0;
+    return exit_code;
 }
@@ -2,9 +2,12 @@
 #include <gtest/gtest.h>
 #include <duplivault/BackupOrchestrator.h>
 #include <duplivault/Chunker.h>
+#include <duplivault/FileScan.h>
 #include <duplivault/Hasher.h>
 #include <duplivault/StorageRepository.h>
+#include <chrono>
 #include <fstream>
+#include <thread>
 
 // This fixture sets up a complete environment for an integration test.
 class BackupOrchestratorTest : public ::testing::Test {
@@ -59,7 +62,7 @@ TEST_F(BackupOrchestratorTest, BackupCreatesChunksInRepository) {
     std::ifstream file_to_check(source_dir / "file1.txt", std::ios::binary);
     auto chunks = chunker->chunk(file_to_check);
     ASSERT_FALSE(chunks.empty());
-    std::string expected_hash = hasher->compute(chunks[0]);
+    dv::Digest expected_hash = hasher->compute(chunks[0]);
 
     // 2. Check if the chunk with that hash now exists in the repository.
     EXPECT_TRUE(repo->chunk_exists(expected_hash));
@@ -69,15 +72,8 @@ TEST_F(BackupOrchestratorTest, SecondBackupOfSameDataIsRedundant) {
     // --- First Backup ---
     orchestrator->run_backup(source_dir);
     
-    // Count how many objects are in the repository
-    size_t count_after_first_backup = 0;
-    if (std::filesystem::exists(repo_dir / "objects")) {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(repo_dir / "objects")) {
-            if (entry.is_regular_file()) {
-                count_after_first_backup++;
-            }
-        }
-    }
+    // Count how many chunks are in the repository
+    size_t count_after_first_backup = repo->chunk_count();
     EXPECT_GT(count_after_first_backup, 0);
 
     // --- Second Backup ---
@@ -85,14 +81,373 @@ TEST_F(BackupOrchestratorTest, SecondBackupOfSameDataIsRedundant) {
     orchestrator->run_backup(source_dir);
 
     // Verification:
-    // The number of stored objects should not have changed.
-    size_t count_after_second_backup = 0;
-    if (std::filesystem::exists(repo_dir / "objects")) {
-         for (const auto& entry : std::filesystem::recursive_directory_iterator(repo_dir / "objects")) {
-            if (entry.is_regular_file()) {
-                count_after_second_backup++;
-            }
+    // The number of stored chunks should not have changed.
+    size_t count_after_second_backup = repo->chunk_count();
+    EXPECT_EQ(count_after_first_backup, count_after_second_backup);
+}
+
+TEST_F(BackupOrchestratorTest, RefusesChunkerThatDoesNotMatchRepository) {
+    dv::Chunker fastcdc(dv::ChunkingEngine::FastCdc);
+    dv::BackupOrchestrator mismatched(fastcdc, *hasher, *repo);
+    EXPECT_THROW(mismatched.run_backup(source_dir), std::runtime_error);
+}
+
+TEST_F(BackupOrchestratorTest, ParallelBackupMatchesSingleJobBackup) {
+    // Many files, some sharing content, so workers race on the same new chunks.
+    std::vector<char> block(20000);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>((i * 2654435761u) >> 13);
+    }
+    for (int i = 0; i < 40; ++i) {
+        auto dir = source_dir / ("dir" + std::to_string(i % 4));
+        std::filesystem::create_directories(dir);
+        std::ofstream out(dir / ("file" + std::to_string(i) + ".bin"), std::ios::binary);
+        out.write(block.data(), block.size());
+        out << "unique tail " << i;
+        out.write(block.data(), block.size() / (i % 3 + 1));
+    }
+    // One file large enough to be split across the workers.
+    {
+        std::ofstream out(source_dir / "large.bin", std::ios::binary);
+        for (int i = 0; i < 150; ++i) {
+            out.write(block.data(), block.size());
+            out << "seam " << i;
         }
     }
-    EXPECT_EQ(count_after_first_backup, count_after_second_backup);
-}
\ No newline at end of file
+
+    orchestrator->run_backup(source_dir);
+
+    auto parallel_repo_dir = test_world_path / "parallel_repo";
+    dv::StorageRepository parallel_repo(parallel_repo_dir);
+    parallel_repo.init();
+    dv::OrchestratorOptions options;
+    options.jobs = 4;
+    options.split_file_size = 1024 * 1024;
+    dv::BackupOrchestrator parallel(*chunker, *hasher, parallel_repo, options);
+    parallel.run_backup(source_dir);
+
+    EXPECT_EQ(repo->chunk_count(), parallel_repo.chunk_count());
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(source_dir)) {
+        if (!entry.is_regular_file()) continue;
+        auto expected = repo->retrieve_metadata(entry.path());
+        auto actual = parallel_repo.retrieve_metadata(entry.path());
+        ASSERT_TRUE(expected.has_value());
+        ASSERT_TRUE(actual.has_value());
+        EXPECT_EQ((*expected)["chunk_hashes"], (*actual)["chunk_hashes"]);
+    }
+}
+
+TEST_F(BackupOrchestratorTest, MappedBackupMatchesStreamedBackup) {
+    std::vector<char> block(30000);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>((i * 2654435761u) >> 11);
+    }
+    { std::ofstream(source_dir / "empty.bin", std::ios::binary); }
+    {
+        // Enough chunks that the parallel path hashes them in several rounds.
+        std::ofstream out(source_dir / "large.bin", std::ios::binary);
+        for (int i = 0; i < 200; ++i) {
+            out.write(block.data(), block.size());
+            out << "seam " << i;
+        }
+    }
+
+    // The large file is also chunked in parallel.
+    dv::OrchestratorOptions options;
+    options.jobs = 3;
+    options.map_files = true;
+    options.split_file_size = 1024 * 1024;
+    dv::BackupOrchestrator mapped(*chunker, *hasher, *repo, options);
+    mapped.run_backup(source_dir);
+
+    auto streamed_repo_dir = test_world_path / "streamed_repo";
+    dv::StorageRepository streamed_repo(streamed_repo_dir);
+    streamed_repo.init();
+    options.map_files = false;
+    dv::BackupOrchestrator streamed(*chunker, *hasher, streamed_repo, options);
+    streamed.run_backup(source_dir);
+
+    EXPECT_EQ(repo->chunk_count(), streamed_repo.chunk_count());
+    for (const auto& entry : std::filesystem::directory_iterator(source_dir)) {
+        auto expected = streamed_repo.retrieve_metadata(entry.path());
+        auto actual = repo->retrieve_metadata(entry.path());
+        ASSERT_TRUE(expected.has_value());
+        ASSERT_TRUE(actual.has_value());
+        EXPECT_EQ((*expected)["chunk_hashes"], (*actual)["chunk_hashes"]);
+    }
+}
+
+TEST_F(BackupOrchestratorTest, CountsWhatEachRunDid) {
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += "line " + std::to_string(i) + " of a repetitive log\n";
+    std::ofstream(source_dir / "log.txt", std::ios::binary) << text;
+    std::ofstream(source_dir / "copy.txt", std::ios::binary) << text;
+    const uint64_t total = text.size() * 2 + std::filesystem::file_size(source_dir / "file1.txt");
+
+    dv::OrchestratorOptions options;
+    options.verbosity = 0;
+    dv::BackupOrchestrator quiet(*chunker, *hasher, *repo, options);
+    quiet.run_backup(source_dir);
+
+    const auto& metrics = quiet.metrics();
+    EXPECT_EQ(metrics.get(dv::Counter::FilesScanned), 3u);
+    EXPECT_EQ(metrics.get(dv::Counter::FilesBackedUp), 3u);
+    EXPECT_EQ(metrics.get(dv::Counter::BytesIn), total);
+    EXPECT_EQ(metrics.chunk_sizes().sum(), total);
+    EXPECT_EQ(metrics.chunk_sizes().count(), metrics.get(dv::Counter::Chunks));
+    // The copy deduplicates completely, and the text compresses.
+    EXPECT_EQ(metrics.get(dv::Counter::NewBytes), total - text.size());
+    EXPECT_LT(metrics.get(dv::Counter::StoredBytes), metrics.get(dv::Counter::NewBytes));
+    EXPECT_EQ(metrics.stage(dv::Stage::Hash).count(), metrics.get(dv::Counter::Chunks));
+    EXPECT_EQ(metrics.stage(dv::Stage::Write).count(), metrics.get(dv::Counter::NewChunks));
+    EXPECT_EQ(metrics.stage(dv::Stage::Metadata).count(), 3u);
+
+    // The files were written just now, so they are racy and read again,
+    // but nothing new is stored.
+    const uint64_t new_chunks = metrics.get(dv::Counter::NewChunks);
+    quiet.run_backup(source_dir);
+    EXPECT_EQ(metrics.get(dv::Counter::FilesScanned), 6u);
+    EXPECT_EQ(metrics.get(dv::Counter::BytesIn), 2 * total);
+    EXPECT_EQ(metrics.get(dv::Counter::NewChunks), new_chunks);
+
+    const auto restore_dir = test_world_path / "restored";
+    quiet.run_restore_snapshot(repo->list_snapshots().back().id, restore_dir);
+    EXPECT_EQ(metrics.get(dv::Counter::FilesRestored), 3u);
+    EXPECT_EQ(metrics.get(dv::Counter::BytesRestored), total);
+    EXPECT_GT(metrics.stage(dv::Stage::RestoreRead).count(), 0u);
+}
+
+TEST_F(BackupOrchestratorTest, RacyFilesAreRehashedEvenWithAnUnchangedMtime) {
+    const auto path = std::filesystem::weakly_canonical(source_dir / "file1.txt");
+    orchestrator->run_backup(source_dir);
+
+    // Written just now, so its stat cannot vouch for its contents yet.
+    auto entry = repo->find_file(path);
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_TRUE(entry->racy);
+
+    // Same size, same mtime, different bytes.
+    const auto mtime = std::filesystem::last_write_time(path);
+    {
+        std::ofstream out(path, std::ios::trunc);
+        out << "This is a test file for our backup system!";
+    }
+    std::filesystem::last_write_time(path, mtime);
+    orchestrator->run_backup(source_dir);
+
+    auto updated = repo->find_file(path);
+    ASSERT_TRUE(updated.has_value());
+    EXPECT_NE(updated->manifest, entry->manifest);
+}
+
+TEST_F(BackupOrchestratorTest, SymlinkedFilesAreKeyedByTheLinkPath) {
+    const auto target = test_world_path / "outside.txt";
+    std::ofstream(target) << "Reached through a link.";
+    std::error_code error;
+    std::filesystem::create_symlink(target, source_dir / "link.txt", error);
+    if (error) {
+        GTEST_SKIP() << "Symlinks are not available: " << error.message();
+    }
+    dv::OrchestratorOptions options;
+    options.verbosity = 0;
+    dv::BackupOrchestrator quiet(*chunker, *hasher, *repo, options);
+    quiet.run_backup(source_dir);
+
+    // Looked up as the link, as the scan saw it, not as its target.
+    EXPECT_TRUE(repo->retrieve_manifest(source_dir / "link.txt").has_value());
+    EXPECT_FALSE(repo->retrieve_manifest(target).has_value());
+
+    const auto restore_dir = test_world_path / "restored";
+    quiet.run_restore_snapshot(repo->list_snapshots().back().id, restore_dir, source_dir / "link.txt");
+    std::ifstream restored(restore_dir / "link.txt");
+    ASSERT_TRUE(restored.is_open());
+    std::string contents((std::istreambuf_iterator<char>(restored)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, "Reached through a link.");
+}
+
+TEST_F(BackupOrchestratorTest, UnreadableFilesKeepTheirPreviousVersion) {
+    dv::OrchestratorOptions options;
+    options.verbosity = 0;
+    dv::BackupOrchestrator quiet(*chunker, *hasher, *repo, options);
+    quiet.run_backup(source_dir);
+
+    const auto path = source_dir / "file1.txt";
+    std::ofstream(path) << "A newer version that cannot be read.";
+    std::filesystem::permissions(path, std::filesystem::perms::none);
+    if (std::ifstream(path).is_open()) {
+        std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+        GTEST_SKIP() << "Permissions do not stop this user from reading files.";
+    }
+    quiet.run_backup(source_dir);
+    std::filesystem::permissions(path, std::filesystem::perms::owner_all);
+    EXPECT_EQ(quiet.metrics().get(dv::Counter::FilesFailed), 1u);
+
+    const auto snapshot = repo->list_snapshots().back();
+    EXPECT_EQ(snapshot.file_count, 1u);
+    const auto restore_dir = test_world_path / "restored";
+    quiet.run_restore_snapshot(snapshot.id, restore_dir);
+    std::ifstream restored(restore_dir / "file1.txt");
+    std::string contents((std::istreambuf_iterator<char>(restored)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, "This is a test file for our backup system.");
+}
+
+TEST_F(BackupOrchestratorTest, OnlyTreesOnAChangedPathAreStored) {
+    std::filesystem::create_directories(source_dir / "a" / "b");
+    std::filesystem::create_directories(source_dir / "c");
+    std::ofstream(source_dir / "a" / "one.txt") << "One.";
+    std::ofstream(source_dir / "a" / "b" / "two.txt") << "Two.";
+    std::ofstream(source_dir / "c" / "three.txt") << "Three.";
+    // Past the racy window, so the stats can vouch for what they cover.
+    auto wait_out_racy_window = [] {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(dv::RACY_WINDOW_NS) + std::chrono::milliseconds(100));
+    };
+    wait_out_racy_window();
+
+    dv::OrchestratorOptions options;
+    options.verbosity = 0;
+    dv::BackupOrchestrator quiet(*chunker, *hasher, *repo, options);
+    const auto& metrics = quiet.metrics();
+    quiet.run_backup(source_dir);
+    EXPECT_EQ(metrics.get(dv::Counter::TreesStored), 4u); // The root, a, a/b and c.
+    const auto first = repo->list_snapshots().back();
+
+    // Nothing changed, so the previous root is taken over whole.
+    quiet.run_backup(source_dir);
+    EXPECT_EQ(metrics.get(dv::Counter::TreesStored), 4u);
+    const auto second = repo->list_snapshots().back();
+    EXPECT_EQ(second.root, first.root);
+    EXPECT_EQ(second.file_count, 4u);
+
+    // A backup of c alone must not leave the whole source's record of the
+    // old c standing: only the root's tree is rebuilt around the new c.
+    std::ofstream(source_dir / "c" / "three.txt") << "Three, edited.";
+    wait_out_racy_window();
+    quiet.run_backup(source_dir / "c");
+    EXPECT_EQ(metrics.get(dv::Counter::TreesStored), 5u);
+    quiet.run_backup(source_dir);
+    EXPECT_EQ(metrics.get(dv::Counter::TreesStored), 6u);
+    const auto restore_dir = test_world_path / "restored";
+    quiet.run_restore_snapshot(repo->list_snapshots().back().id, restore_dir);
+    std::ifstream restored(restore_dir / "c" / "three.txt");
+    std::string contents((std::istreambuf_iterator<char>(restored)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, "Three, edited.");
+
+    // An edit in place leaves its directory's mtime alone; the trees on
+    // its path are rebuilt all the same, and c's is not.
+    std::ofstream(source_dir / "a" / "b" / "two.txt") << "Two, edited.";
+    quiet.run_backup(source_dir);
+    EXPECT_EQ(metrics.get(dv::Counter::TreesStored), 9u);
+
+    // A removal changes its directory's mtime.
+    std::filesystem::remove(source_dir / "c" / "three.txt");
+    quiet.run_backup(source_dir);
+    const auto last = repo->list_snapshots().back();
+    std::vector<std::string> paths;
+    dv::walk_trees(last.root, [&](const dv::Digest& ref) { return repo->load_tree(ref); },
+                   [&](const std::string& path, const dv::Digest&) { paths.push_back(path); });
+    EXPECT_EQ(paths, (std::vector<std::string>{"a/b/two.txt", "a/one.txt", "file1.txt"}));
+    EXPECT_EQ(last.file_count, 3u);
+}
+
+namespace {
+
+std::vector<char> pseudo_random_bytes(size_t size, uint32_t seed) {
+    std::vector<char> bytes(size);
+    for (auto& byte : bytes) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<char>(seed >> 24);
+    }
+    return bytes;
+}
+
+} // namespace
+
+TEST_F(BackupOrchestratorTest, AppendAwareBackupMatchesAFullRechunk) {
+    const auto path = std::filesystem::weakly_canonical(source_dir / "growing.log");
+    const auto head = pseudo_random_bytes(300000, 1);
+    std::ofstream(path, std::ios::binary).write(head.data(), head.size());
+
+    dv::OrchestratorOptions options;
+    options.append_aware = true;
+    dv::BackupOrchestrator appending(*chunker, *hasher, *repo, options);
+    appending.run_backup(source_dir);
+
+    auto expected_hashes = [&]() {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<dv::Digest> hashes;
+        chunker->chunk(in, [&](dv::ByteSpan chunk) { hashes.push_back(hasher->compute(chunk.data, chunk.size)); });
+        return hashes;
+    };
+
+    // Grow the file twice; each time only the tail needs chunking.
+    for (uint32_t round = 2; round <= 3; ++round) {
+        const auto tail = pseudo_random_bytes(100000, round);
+        std::ofstream(path, std::ios::binary | std::ios::app).write(tail.data(), tail.size());
+        appending.run_backup(source_dir);
+
+        const auto manifest = repo->retrieve_manifest(path);
+        ASSERT_TRUE(manifest.has_value());
+        EXPECT_EQ(manifest->chunk_hashes, expected_hashes()) << "round " << round;
+        EXPECT_EQ(manifest->chunk_offsets().back(), std::filesystem::file_size(path));
+    }
+}
+
+TEST_F(BackupOrchestratorTest, AppendAwareBackupRechunksWhenTheSeamChanged) {
+    const auto path = std::filesystem::weakly_canonical(source_dir / "rewritten.bin");
+    auto bytes = pseudo_random_bytes(200000, 7);
+    std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+
+    dv::OrchestratorOptions options;
+    options.append_aware = true;
+    dv::BackupOrchestrator appending(*chunker, *hasher, *repo, options);
+    appending.run_backup(source_dir);
+    const auto before = repo->retrieve_manifest(path);
+    ASSERT_TRUE(before.has_value());
+    ASSERT_GE(before->chunk_hashes.size(), 3u);
+
+    // Rewrite the chunk just before the old last one, in place.
+    const auto offsets = before->chunk_offsets();
+    const size_t seam = offsets[before->chunk_hashes.size() - 2];
+    for (size_t i = seam; i < seam + 16; ++i) {
+        bytes[i] = static_cast<char>(~bytes[i]);
+    }
+    {
+        std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+        out.write(bytes.data(), bytes.size());
+    }
+    appending.run_backup(source_dir);
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<dv::Digest> expected;
+    chunker->chunk(in, [&](dv::ByteSpan chunk) { expected.push_back(hasher->compute(chunk.data, chunk.size)); });
+    EXPECT_EQ(repo->retrieve_manifest(path)->chunk_hashes, expected);
+}
+
+TEST_F(BackupOrchestratorTest, AppendAwareBackupRechunksWhenTheHeadChanged) {
+    const auto path = std::filesystem::weakly_canonical(source_dir / "rewritten.bin");
+    auto bytes = pseudo_random_bytes(200000, 9);
+    std::ofstream(path, std::ios::binary).write(bytes.data(), bytes.size());
+
+    dv::OrchestratorOptions options;
+    options.append_aware = true;
+    dv::BackupOrchestrator appending(*chunker, *hasher, *repo, options);
+    appending.run_backup(source_dir);
+
+    // Rewrite the start of the first chunk in place, and grow the file.
+    for (size_t i = 0; i < 16; ++i) {
+        bytes[i] = static_cast<char>(~bytes[i]);
+    }
+    const auto tail = pseudo_random_bytes(50000, 10);
+    bytes.insert(bytes.end(), tail.begin(), tail.end());
+    {
+        std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+        out.write(bytes.data(), bytes.size());
+    }
+    appending.run_backup(source_dir);
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<dv::Digest> expected;
+    chunker->chunk(in, [&](dv::ByteSpan chunk) { expected.push_back(hasher->compute(chunk.data, chunk.size)); });
+    EXPECT_EQ(repo->retrieve_manifest(path)->chunk_hashes, expected);
+}
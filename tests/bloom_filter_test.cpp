@@ -0,0 +1,60 @@
+// tests/bloom_filter_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/BloomFilter.h>
+#include <duplivault/Hasher.h>
+#include <string>
+
+namespace {
+
+dv::Digest digest_of(uint32_t i) {
+    dv::Hasher hasher;
+    const std::string text = "chunk " + std::to_string(i);
+    return hasher.compute(reinterpret_cast<const std::byte*>(text.data()), text.size());
+}
+
+} // namespace
+
+TEST(BloomFilterTest, HasNoFalseNegatives) {
+    dv::BloomFilter filter(5000);
+    for (uint32_t i = 0; i < 5000; ++i) {
+        filter.insert(digest_of(i));
+    }
+    EXPECT_EQ(filter.size(), 5000u);
+    for (uint32_t i = 0; i < 5000; ++i) {
+        EXPECT_TRUE(filter.may_contain(digest_of(i))) << i;
+    }
+}
+
+TEST(BloomFilterTest, FalsePositiveRateAtCapacityIsLow) {
+    dv::BloomFilter filter(20000);
+    for (uint32_t i = 0; i < filter.capacity(); ++i) {
+        filter.insert(digest_of(i));
+    }
+    size_t false_positives = 0;
+    const uint32_t probes = 20000;
+    for (uint32_t i = 0; i < probes; ++i) {
+        false_positives += filter.may_contain(digest_of(1000000 + i));
+    }
+    EXPECT_LT(false_positives, probes / 100); // Under 1%.
+}
+
+TEST(BloomFilterTest, SaveAndLoadRoundTrip) {
+    const auto path = std::filesystem::temp_directory_path() / "DupliVaultBloomTest.bin";
+    dv::BloomFilter filter(100);
+    for (uint32_t i = 0; i < 100; ++i) {
+        filter.insert(digest_of(i));
+    }
+    filter.save(path);
+
+    dv::BloomFilter loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.size(), 100u);
+    EXPECT_EQ(loaded.capacity(), filter.capacity());
+    for (uint32_t i = 0; i < 100; ++i) {
+        EXPECT_TRUE(loaded.may_contain(digest_of(i)));
+    }
+    std::filesystem::remove(path);
+
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_EQ(loaded.size(), 100u); // Unchanged by a failed load.
+}
@@ -0,0 +1,71 @@
+// tests/bounded_queue_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/BoundedQueue.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(BoundedQueueTest, PopsInFifoOrder) {
+    dv::BoundedQueue<int> queue(4);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_TRUE(queue.push(3));
+    EXPECT_EQ(queue.pop(), 1);
+    EXPECT_EQ(queue.pop(), 2);
+    EXPECT_EQ(queue.pop(), 3);
+}
+
+TEST(BoundedQueueTest, WrapsAroundItsSlots) {
+    dv::BoundedQueue<std::string> queue(3);
+    for (int round = 0; round < 5; ++round) {
+        EXPECT_TRUE(queue.push("a" + std::to_string(round)));
+        EXPECT_TRUE(queue.push("b" + std::to_string(round)));
+        EXPECT_EQ(queue.pop(), "a" + std::to_string(round));
+        EXPECT_EQ(queue.pop(), "b" + std::to_string(round));
+    }
+}
+
+TEST(BoundedQueueTest, CloseDrainsRemainingItemsThenStops) {
+    dv::BoundedQueue<int> queue(4);
+    queue.push(7);
+    queue.close();
+    EXPECT_FALSE(queue.push(8));
+    EXPECT_EQ(queue.pop(), 7);
+    EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(BoundedQueueTest, ProducerWaitsWhileFull) {
+    dv::BoundedQueue<int> queue(2);
+    const int total = 10000;
+
+    // The producer can never be more than two items ahead of the consumer.
+    std::thread producer([&]() {
+        for (int i = 0; i < total; ++i) {
+            queue.push(i);
+        }
+        queue.close();
+    });
+
+    std::vector<int> received;
+    while (auto item = queue.pop()) {
+        received.push_back(*item);
+    }
+    producer.join();
+
+    ASSERT_EQ(received.size(), static_cast<size_t>(total));
+    for (int i = 0; i < total; ++i) {
+        EXPECT_EQ(received[i], i);
+    }
+}
+
+TEST(BoundedQueueTest, CloseWakesBlockedProducer) {
+    dv::BoundedQueue<int> queue(1);
+    queue.push(1);
+
+    bool pushed = true;
+    std::thread producer([&]() { pushed = queue.push(2); });
+    queue.close();
+    producer.join();
+
+    EXPECT_FALSE(pushed);
+}
@@ -0,0 +1,81 @@
+// tests/buffer_pool_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/BufferPool.h>
+#include <duplivault/Compression.h>
+#include <random>
+#include <thread>
+#include <vector>
+
+TEST(BufferPoolTest, HandsOutEmptyReservedBuffers) {
+    dv::BufferPool pool(1000, 4);
+    const dv::Chunk buffer = pool.acquire();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_GE(buffer.capacity(), 1000u);
+    EXPECT_EQ(pool.free_count(), 0u);
+}
+
+TEST(BufferPoolTest, RecyclesReleasedBuffers) {
+    dv::BufferPool pool(1000, 4);
+    dv::Chunk buffer = pool.acquire();
+    buffer.assign(600, std::byte{7});
+    const std::byte* memory = buffer.data();
+    pool.release(std::move(buffer));
+    EXPECT_EQ(pool.free_count(), 1u);
+
+    const dv::Chunk again = pool.acquire();
+    EXPECT_EQ(again.data(), memory);
+    EXPECT_TRUE(again.empty());
+    EXPECT_EQ(pool.free_count(), 0u);
+}
+
+TEST(BufferPoolTest, KeepsAtMostMaxFree) {
+    dv::BufferPool pool(100, 2);
+    std::vector<dv::Chunk> buffers;
+    for (int i = 0; i < 5; ++i) buffers.push_back(pool.acquire());
+    for (auto& buffer : buffers) pool.release(std::move(buffer));
+    EXPECT_EQ(pool.free_count(), 2u);
+}
+
+TEST(BufferPoolTest, DropsBuffersOfTheWrongSize) {
+    dv::BufferPool pool(1000, 4);
+    pool.release(dv::Chunk(10)); // Too small to be worth keeping.
+    dv::Chunk grown = pool.acquire();
+    grown.resize(5000); // Grew far past the pool's size.
+    pool.release(std::move(grown));
+    EXPECT_EQ(pool.free_count(), 0u);
+}
+
+TEST(BufferPoolTest, CompressedChunkFitsWithoutRegrowing) {
+    // Text-like data that compresses, at the largest chunk size.
+    std::string text;
+    for (int i = 0; text.size() < dv::Chunker::MAX_CHUNK_SIZE; ++i) {
+        text += "line " + std::to_string(i) + ": nothing to report\n";
+    }
+    text.resize(dv::Chunker::MAX_CHUNK_SIZE);
+    const dv::ByteSpan raw(reinterpret_cast<const std::byte*>(text.data()), text.size());
+
+    dv::BufferPool pool(dv::compress_bound(dv::Chunker::MAX_CHUNK_SIZE), 1);
+    dv::Chunk out = pool.acquire();
+    const std::byte* memory = out.data();
+    ASSERT_EQ(dv::compress_chunk(raw, out), dv::ChunkCodec::Lz);
+    EXPECT_EQ(out.data(), memory);
+    EXPECT_EQ(dv::decompress_chunk(dv::ChunkCodec::Lz, out), dv::Chunk(raw.data, raw.data + raw.size));
+}
+
+TEST(BufferPoolTest, SharedByThreads) {
+    dv::BufferPool pool(256, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, t]() {
+            std::mt19937 rng(t);
+            for (int i = 0; i < 2000; ++i) {
+                dv::Chunk buffer = pool.acquire();
+                ASSERT_TRUE(buffer.empty());
+                buffer.assign(rng() % 256, std::byte{1});
+                pool.release(std::move(buffer));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_LE(pool.free_count(), 8u);
+}
@@ -0,0 +1,139 @@
+// tests/catalog_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/Catalog.h>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+dv::CatalogEntry entry(const std::string& path, int64_t mod_time_ns) {
+    dv::CatalogEntry e;
+    e.path = path;
+    e.stat.mod_time_ns = mod_time_ns;
+    e.stat.change_time_ns = mod_time_ns + 1;
+    e.stat.size = path.size();
+    e.stat.inode = 100;
+    e.stat.device = 7;
+    e.manifest.bytes[0] = static_cast<uint8_t>(mod_time_ns);
+    return e;
+}
+
+std::vector<std::string> paths_of(const dv::Catalog& catalog) {
+    std::vector<std::string> paths;
+    catalog.for_each([&](const dv::CatalogEntry& e) { paths.push_back(e.path); });
+    return paths;
+}
+
+} // namespace
+
+class CatalogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "DupliVaultCatalogTest" / std::to_string(std::time(nullptr));
+        std::filesystem::create_directories(dir);
+        file = dir / "catalog.bin";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::filesystem::path dir;
+    std::filesystem::path file;
+};
+
+TEST_F(CatalogTest, FindsPendingAndSavedEntries) {
+    dv::Catalog catalog;
+    catalog.insert(entry("/b", 2));
+    catalog.insert(entry("/a", 1));
+    EXPECT_TRUE(catalog.dirty());
+    EXPECT_EQ(catalog.size(), 2u);
+    EXPECT_EQ(catalog.find("/a")->stat.mod_time_ns, 1);
+
+    catalog.save(file);
+    EXPECT_FALSE(catalog.dirty());
+    EXPECT_EQ(catalog.find("/b")->manifest.bytes[0], 2);
+    EXPECT_FALSE(catalog.find("/c").has_value());
+    EXPECT_FALSE(catalog.find("/").has_value());
+}
+
+TEST_F(CatalogTest, RoundTripsThroughTheFile) {
+    dv::Catalog catalog;
+    for (int i = 0; i < 500; ++i) {
+        catalog.insert(entry("/data/file-" + std::to_string(i), i));
+    }
+    catalog.save(file);
+
+    dv::Catalog loaded;
+    ASSERT_TRUE(loaded.load(file));
+    EXPECT_EQ(loaded.size(), 500u);
+    for (int i = 0; i < 500; ++i) {
+        auto found = loaded.find("/data/file-" + std::to_string(i));
+        ASSERT_TRUE(found.has_value()) << i;
+        EXPECT_EQ(found->stat, entry(found->path, i).stat);
+    }
+    auto paths = paths_of(loaded);
+    EXPECT_TRUE(std::is_sorted(paths.begin(), paths.end()));
+}
+
+TEST_F(CatalogTest, InsertsReplaceAndMergeInPathOrder) {
+    dv::Catalog catalog;
+    catalog.insert(entry("/b", 1));
+    catalog.insert(entry("/d", 1));
+    catalog.save(file);
+
+    catalog.insert(entry("/d", 5)); // Replaces a saved entry.
+    catalog.insert(entry("/a", 5));
+    catalog.insert(entry("/c", 5));
+    catalog.insert(entry("/c", 6)); // Replaces a pending entry.
+    EXPECT_EQ(catalog.size(), 4u);
+    EXPECT_EQ(paths_of(catalog), (std::vector<std::string>{"/a", "/b", "/c", "/d"}));
+    EXPECT_EQ(catalog.find("/d")->stat.mod_time_ns, 5);
+    EXPECT_EQ(catalog.find("/c")->stat.mod_time_ns, 6);
+
+    catalog.save(file);
+    dv::Catalog loaded;
+    ASSERT_TRUE(loaded.load(file));
+    EXPECT_EQ(paths_of(loaded), (std::vector<std::string>{"/a", "/b", "/c", "/d"}));
+    EXPECT_EQ(loaded.find("/b")->stat.mod_time_ns, 1);
+}
+
+TEST_F(CatalogTest, RejectsDamagedFiles) {
+    dv::Catalog catalog;
+    EXPECT_FALSE(catalog.load(file)); // Missing.
+
+    catalog.insert(entry("/a", 1));
+    catalog.save(file);
+    std::filesystem::resize_file(file, std::filesystem::file_size(file) - 1);
+    EXPECT_FALSE(catalog.load(file));
+    EXPECT_EQ(catalog.size(), 0u);
+
+    std::ofstream(file, std::ios::trunc) << "not a catalog, but long enough to have a header";
+    EXPECT_FALSE(catalog.load(file));
+}
+
+TEST_F(CatalogTest, RacyEntriesAreNeverUnchanged) {
+    dv::Catalog catalog;
+    auto racy = entry("/racy", 1);
+    racy.racy = true;
+    catalog.insert(racy);
+    catalog.insert(entry("/settled", 1));
+    catalog.save(file);
+
+    dv::Catalog loaded;
+    ASSERT_TRUE(loaded.load(file));
+    const auto found = loaded.find("/racy");
+    ASSERT_TRUE(found.has_value());
+    EXPECT_TRUE(found->racy);
+    EXPECT_FALSE(found->unchanged(racy.stat));
+
+    const auto settled = loaded.find("/settled");
+    EXPECT_FALSE(settled->racy);
+    EXPECT_TRUE(settled->unchanged(settled->stat));
+    auto touched = settled->stat;
+    touched.change_time_ns++;
+    EXPECT_FALSE(settled->unchanged(touched));
+}
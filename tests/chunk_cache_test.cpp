@@ -0,0 +1,89 @@
+// tests/chunk_cache_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/ChunkCache.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Digests that all land in one shard, so its budget is easy to reason about.
+dv::Digest digest_of(uint8_t i) {
+    dv::Digest digest;
+    digest.bytes[0] = 0;
+    digest.bytes[1] = i;
+    return digest;
+}
+
+dv::ByteSpan span_of(const std::string& s) {
+    return dv::ByteSpan(reinterpret_cast<const std::byte*>(s.data()), s.size());
+}
+
+} // namespace
+
+TEST(ChunkCacheTest, ReturnsWhatWasPut) {
+    dv::ChunkCache cache(dv::ChunkCache::SHARDS * 1000);
+    EXPECT_EQ(cache.get(digest_of(1)), nullptr);
+    cache.put(digest_of(1), span_of("hello"));
+    auto chunk = cache.get(digest_of(1));
+    ASSERT_NE(chunk, nullptr);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(chunk->data()), chunk->size()), "hello");
+
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.bytes, 5u);
+}
+
+TEST(ChunkCacheTest, EvictsLeastRecentlyUsedWithinTheByteBudget) {
+    dv::ChunkCache cache(dv::ChunkCache::SHARDS * 300); // 300 bytes per shard.
+    const std::string block(100, 'x');
+    cache.put(digest_of(1), span_of(block));
+    cache.put(digest_of(2), span_of(block));
+    cache.put(digest_of(3), span_of(block));
+    ASSERT_NE(cache.get(digest_of(1)), nullptr); // Now the most recent.
+
+    cache.put(digest_of(4), span_of(block));
+    EXPECT_EQ(cache.get(digest_of(2)), nullptr);
+    EXPECT_NE(cache.get(digest_of(1)), nullptr);
+    EXPECT_NE(cache.get(digest_of(3)), nullptr);
+    EXPECT_NE(cache.get(digest_of(4)), nullptr);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+    EXPECT_EQ(cache.stats().bytes, 300u);
+
+    // Too large for a shard: not cached, and evicts nothing.
+    cache.put(digest_of(5), span_of(std::string(301, 'y')));
+    EXPECT_EQ(cache.get(digest_of(5)), nullptr);
+    EXPECT_EQ(cache.stats().bytes, 300u);
+}
+
+TEST(ChunkCacheTest, EvictedChunksStayValidForReaders) {
+    dv::ChunkCache cache(dv::ChunkCache::SHARDS * 100);
+    cache.put(digest_of(1), span_of(std::string(100, 'a')));
+    auto held = cache.get(digest_of(1));
+    cache.put(digest_of(2), span_of(std::string(100, 'b')));
+    EXPECT_EQ(cache.get(digest_of(1)), nullptr);
+    ASSERT_NE(held, nullptr);
+    EXPECT_EQ(static_cast<char>((*held)[99]), 'a');
+}
+
+TEST(ChunkCacheTest, IsSafeToShareBetweenThreads) {
+    dv::ChunkCache cache(64 * 1024);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 2000; ++i) {
+                dv::Digest digest;
+                digest.bytes[0] = static_cast<uint8_t>(i * 7 + t);
+                digest.bytes[1] = static_cast<uint8_t>(i % 50);
+                if (!cache.get(digest)) {
+                    cache.put(digest, span_of(std::string(200, static_cast<char>(i))));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 8000u);
+    EXPECT_LE(stats.bytes, cache.capacity());
+}
@@ -0,0 +1,125 @@
+// tests/chunk_index_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/ChunkIndex.h>
+#include <fstream>
+
+class ChunkIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() / "DupliVaultChunkIndexTest" / std::to_string(std::time(nullptr));
+        std::filesystem::remove_all(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir.parent_path());
+    }
+
+    static dv::Digest digest_of(uint32_t i) {
+        // Spread the values like real digests, but deterministically.
+        dv::Digest d;
+        uint64_t x = i * 0x9e3779b97f4a7c15ULL + 1;
+        for (auto& b : d.bytes) {
+            x ^= x >> 29;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            b = static_cast<uint8_t>(x >> 56);
+        }
+        return d;
+    }
+
+    static dv::PackLocation location_of(uint32_t i) {
+        return {1 + i / 1000, 8 + (i % 1000) * 100, 60, 0};
+    }
+
+    void fill(dv::ChunkIndex& index, uint32_t from, uint32_t to) {
+        for (uint32_t i = from; i < to; ++i) {
+            ASSERT_TRUE(index.insert(digest_of(i), location_of(i)));
+        }
+    }
+
+    void expect_contents(const dv::ChunkIndex& index, uint32_t count) {
+        EXPECT_EQ(index.size(), count);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto found = index.find(digest_of(i));
+            ASSERT_TRUE(found.has_value()) << i;
+            EXPECT_EQ(found->pack_id, location_of(i).pack_id);
+            EXPECT_EQ(found->offset, location_of(i).offset);
+        }
+        EXPECT_FALSE(index.find(digest_of(count)).has_value());
+    }
+
+    std::filesystem::path dir;
+};
+
+TEST_F(ChunkIndexTest, InsertFindAndGrow) {
+    dv::ChunkIndex index;
+    fill(index, 0, 20000);
+    expect_contents(index, 20000);
+    EXPECT_FALSE(index.insert(digest_of(5), location_of(7)));
+    EXPECT_EQ(index.find(digest_of(5))->offset, location_of(5).offset);
+    EXPECT_EQ(index.watermark().pack_id, location_of(19999).pack_id);
+}
+
+TEST_F(ChunkIndexTest, SavesTableThenAppendsToLog) {
+    dv::ChunkIndex index;
+    EXPECT_FALSE(index.load(dir));
+    fill(index, 0, 3000);
+    index.save(dir);
+    fill(index, 3000, 3500);
+    index.save(dir);
+
+    // The second save only appended to the log.
+    EXPECT_EQ(std::filesystem::file_size(dir / "chunk-index.log"), 500 * 56u);
+
+    dv::ChunkIndex reloaded;
+    ASSERT_TRUE(reloaded.load(dir));
+    expect_contents(reloaded, 3500);
+    EXPECT_EQ(reloaded.watermark().pack_id, index.watermark().pack_id);
+    EXPECT_EQ(reloaded.watermark().end, index.watermark().end);
+}
+
+TEST_F(ChunkIndexTest, FoldsALongLogIntoTheTable) {
+    dv::ChunkIndex index;
+    fill(index, 0, 10);
+    index.save(dir);
+    fill(index, 10, 70000); // More than the log may hold.
+    index.save(dir);
+    EXPECT_EQ(std::filesystem::file_size(dir / "chunk-index.log"), 0u);
+
+    dv::ChunkIndex reloaded;
+    ASSERT_TRUE(reloaded.load(dir));
+    expect_contents(reloaded, 70000);
+}
+
+TEST_F(ChunkIndexTest, IgnoresATornLogTail) {
+    dv::ChunkIndex index;
+    fill(index, 0, 100);
+    index.save(dir);
+    fill(index, 100, 110);
+    index.save(dir);
+    std::filesystem::resize_file(dir / "chunk-index.log", 9 * 56 + 20);
+
+    dv::ChunkIndex reloaded;
+    ASSERT_TRUE(reloaded.load(dir));
+    expect_contents(reloaded, 109);
+}
+
+TEST_F(ChunkIndexTest, StopsReplayAtAZeroFilledLogTail) {
+    dv::ChunkIndex index;
+    fill(index, 0, 100);
+    index.save(dir);
+    fill(index, 100, 110);
+    index.save(dir);
+    std::filesystem::resize_file(dir / "chunk-index.log", 13 * 56);
+
+    dv::ChunkIndex reloaded;
+    ASSERT_TRUE(reloaded.load(dir));
+    expect_contents(reloaded, 110);
+}
+
+TEST_F(ChunkIndexTest, RejectsAForeignTable) {
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "chunk-index.tbl") << "definitely not an index table, but long enough to have a header......";
+    dv::ChunkIndex index;
+    EXPECT_FALSE(index.load(dir));
+    EXPECT_EQ(index.size(), 0u);
+}
@@ -2,8 +2,12 @@
 #include <gtest/gtest.h>
 #include <duplivault/Chunker.h>
 #include <duplivault/Hasher.h> // We need the hasher to compare chunks
+#include <duplivault/ThreadPool.h>
 #include <sstream>
 #include <random> // For generating better test data
+#include <array>
+#include <cstring>
+#include <tuple>
 
 class ChunkerTest : public ::testing::Test {
 protected:
@@ -79,8 +83,8 @@ TEST_F(ChunkerTest, InsertionDoesNotChangeSubsequentChunks) {
 
     // 5. Get the hash of the LAST chunk from each file.
     //    This chunk should correspond to the 'suffix_data' block.
-    std::string last_chunk_hash_a = hasher.compute(chunks_a.back());
-    std::string last_chunk_hash_b = hasher.compute(chunks_b.back());
+    dv::Digest last_chunk_hash_a = hasher.compute(chunks_a.back());
+    dv::Digest last_chunk_hash_b = hasher.compute(chunks_b.back());
 
     // 6. THE VERIFICATION:
     //    Even though we inserted data in the middle of File B, the chunking
@@ -88,3 +92,327 @@ TEST_F(ChunkerTest, InsertionDoesNotChangeSubsequentChunks) {
     //    Therefore, the last chunks of both files should be identical.
     EXPECT_EQ(last_chunk_hash_a, last_chunk_hash_b);
 }
+
+// --- Boundary API ---
+
+namespace {
+
+// The original byte-at-a-time chunker, kept as a reference. Cut points
+// decide which chunks existing repositories already hold, so they must
+// never change.
+std::vector<size_t> reference_chunk_lengths(const std::vector<char>& data) {
+    std::array<uint32_t, 256> T{};
+    uint64_t state = 1;
+    for (int i = 0; i < 256; ++i) {
+        state = state * 1103515245 + 12345;
+        T[i] = static_cast<uint32_t>(state >> 32);
+    }
+    std::array<unsigned char, 64> window{};
+    size_t window_index = 0;
+    uint32_t hash = 0;
+
+    std::vector<size_t> lengths;
+    size_t current = 0;
+    for (char c : data) {
+        const auto byte_in = static_cast<unsigned char>(c);
+        const auto byte_out = window[window_index];
+        window[window_index] = byte_in;
+        window_index = (window_index + 1) % 64;
+        hash = ((hash << 1) | (hash >> 31)) ^ T[byte_out] ^ T[byte_in];
+
+        ++current;
+        if (current >= dv::Chunker::MAX_CHUNK_SIZE ||
+            (current >= dv::Chunker::MIN_CHUNK_SIZE && (hash & dv::Chunker::CHUNK_PATTERN) == 0)) {
+            lengths.push_back(current);
+            current = 0;
+        }
+    }
+    if (current > 0) {
+        lengths.push_back(current);
+    }
+    return lengths;
+}
+
+} // anonymous namespace
+
+TEST_F(ChunkerTest, MatchesReferenceImplementation) {
+    // Random data, plus a long run of zeros that forces maximum-size cuts.
+    auto data = generate_data(512 * 1024);
+    data.insert(data.begin() + 100000, 100000, '\0');
+
+    const auto expected = reference_chunk_lengths(data);
+    const auto boundaries = chunker.find_boundaries(reinterpret_cast<const std::byte*>(data.data()), data.size());
+
+    ASSERT_EQ(boundaries.size(), expected.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(boundaries[i].offset, offset);
+        EXPECT_EQ(boundaries[i].length, expected[i]) << "chunk " << i;
+        offset += expected[i];
+    }
+}
+
+TEST_F(ChunkerTest, StreamingMatchesBoundariesAcrossBufferRefills) {
+    // Several times the streaming buffer, so chunks straddle refills.
+    auto data = generate_data(3 * dv::Chunker::STREAM_BUFFER_SIZE + 12345);
+    const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+    const auto boundaries = chunker.find_boundaries(bytes, data.size());
+
+    std::stringstream stream(std::string(data.begin(), data.end()));
+    std::vector<dv::Digest> streamed;
+    chunker.chunk(stream, [&](dv::ByteSpan chunk) {
+        streamed.push_back(hasher.compute(chunk.data, chunk.size));
+    });
+
+    ASSERT_EQ(streamed.size(), boundaries.size());
+    for (size_t i = 0; i < boundaries.size(); ++i) {
+        EXPECT_EQ(streamed[i], hasher.compute(bytes + boundaries[i].offset, boundaries[i].length)) << "chunk " << i;
+    }
+}
+
+TEST_F(ChunkerTest, ReusedStreamBufferGivesTheSameChunks) {
+    const auto first = generate_data(2 * dv::Chunker::STREAM_BUFFER_SIZE + 999);
+    const auto second = generate_data(100000);
+    auto digests = [&](const std::vector<char>& data, std::vector<std::byte>* buffer) {
+        std::stringstream stream(std::string(data.begin(), data.end()));
+        std::vector<dv::Digest> out;
+        auto on_chunk = [&](dv::ByteSpan chunk) { out.push_back(hasher.compute(chunk.data, chunk.size)); };
+        if (buffer) {
+            chunker.chunk(stream, on_chunk, *buffer);
+        } else {
+            chunker.chunk(stream, on_chunk);
+        }
+        return out;
+    };
+
+    // The buffer still holds the first file's bytes when the second starts.
+    std::vector<std::byte> buffer;
+    EXPECT_EQ(digests(first, &buffer), digests(first, nullptr));
+    EXPECT_EQ(digests(second, &buffer), digests(second, nullptr));
+}
+
+TEST_F(ChunkerTest, NextBoundaryAsksForMoreInput) {
+    auto data = generate_data(dv::Chunker::MIN_CHUNK_SIZE - 1);
+    const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+    EXPECT_EQ(chunker.next_boundary(bytes, data.size(), false), 0u);
+    EXPECT_EQ(chunker.next_boundary(bytes, data.size(), true), data.size());
+}
+
+// --- FastCDC engine ---
+
+TEST_F(ChunkerTest, FastCdcRespectsSizeLimits) {
+    dv::Chunker fastcdc(dv::ChunkingEngine::FastCdc);
+    auto data = generate_data(1024 * 1024);
+    const auto boundaries = fastcdc.find_boundaries(reinterpret_cast<const std::byte*>(data.data()), data.size());
+
+    ASSERT_GT(boundaries.size(), 1u);
+    size_t offset = 0;
+    for (size_t i = 0; i < boundaries.size(); ++i) {
+        EXPECT_EQ(boundaries[i].offset, offset);
+        EXPECT_LE(boundaries[i].length, dv::Chunker::MAX_CHUNK_SIZE);
+        if (i + 1 < boundaries.size()) {
+            EXPECT_GE(boundaries[i].length, dv::Chunker::MIN_CHUNK_SIZE);
+        }
+        offset += boundaries[i].length;
+    }
+    EXPECT_EQ(offset, data.size());
+}
+
+TEST_F(ChunkerTest, FastCdcNormalizesChunkSizes) {
+    // Normalized chunking should keep sizes closer to the average than
+    // the single-pattern Buzhash engine does.
+    auto data = generate_data(4 * 1024 * 1024);
+    const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+
+    auto spread = [](const std::vector<dv::ChunkBoundary>& boundaries) {
+        double mean = 0;
+        for (const auto& b : boundaries) mean += static_cast<double>(b.length);
+        mean /= static_cast<double>(boundaries.size());
+        double variance = 0;
+        for (const auto& b : boundaries) variance += (b.length - mean) * (b.length - mean);
+        return variance / static_cast<double>(boundaries.size());
+    };
+
+    const auto buz = dv::Chunker(dv::ChunkingEngine::Buzhash).find_boundaries(bytes, data.size());
+    const auto fast = dv::Chunker(dv::ChunkingEngine::FastCdc).find_boundaries(bytes, data.size());
+    EXPECT_LT(spread(fast), spread(buz));
+
+    const double fast_mean = static_cast<double>(data.size()) / static_cast<double>(fast.size());
+    EXPECT_GT(fast_mean, dv::Chunker::AVG_CHUNK_SIZE / 2.0);
+    EXPECT_LT(fast_mean, dv::Chunker::AVG_CHUNK_SIZE * 2.0);
+}
+
+TEST_F(ChunkerTest, FastCdcInsertionDoesNotChangeSubsequentChunks) {
+    dv::Chunker fastcdc(dv::ChunkingEngine::FastCdc);
+    auto prefix_data = generate_data(64 * 1024);
+    auto suffix_data = generate_data(64 * 1024);
+
+    std::string file_a(prefix_data.begin(), prefix_data.end());
+    file_a.append(suffix_data.begin(), suffix_data.end());
+    std::string file_b(prefix_data.begin(), prefix_data.end());
+    file_b.append("...SOME NEW DATA INSERTED HERE...");
+    file_b.append(suffix_data.begin(), suffix_data.end());
+
+    std::stringstream stream_a(file_a), stream_b(file_b);
+    auto chunks_a = fastcdc.chunk(stream_a);
+    auto chunks_b = fastcdc.chunk(stream_b);
+    ASSERT_GT(chunks_a.size(), 1u);
+    ASSERT_GT(chunks_b.size(), 1u);
+    EXPECT_EQ(hasher.compute(chunks_a.back()), hasher.compute(chunks_b.back()));
+}
+
+TEST(ChunkingEngineTest, NamesRoundTrip) {
+    for (auto engine : {dv::ChunkingEngine::Buzhash, dv::ChunkingEngine::FastCdc}) {
+        EXPECT_EQ(dv::parse_chunking_engine(dv::to_string(engine)), engine);
+    }
+    EXPECT_FALSE(dv::parse_chunking_engine("rabin").has_value());
+}
+
+// --- Scan backends must cut in exactly the same places ---
+
+class ChunkerScanTest : public ::testing::TestWithParam<std::tuple<dv::ChunkingEngine, dv::ScanBackend>> {
+protected:
+    void SetUp() override {
+        if (!dv::Chunker::is_supported(std::get<1>(GetParam()))) {
+            GTEST_SKIP() << "Scan backend not supported on this CPU";
+        }
+    }
+
+    void expect_same_cuts(const std::string& data) {
+        dv::Chunker scalar(std::get<0>(GetParam()), dv::ScanBackend::Scalar);
+        dv::Chunker other(std::get<0>(GetParam()), std::get<1>(GetParam()));
+        const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+        EXPECT_EQ(other.find_boundaries(bytes, data.size()), scalar.find_boundaries(bytes, data.size()));
+    }
+
+    std::string random_data(size_t size, unsigned seed) {
+        std::string data(size, '\0');
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (auto& c : data) c = static_cast<char>(dist(rng));
+        return data;
+    }
+};
+
+TEST_P(ChunkerScanTest, RandomData) {
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        expect_same_cuts(random_data(2 * 1024 * 1024 + seed * 7, seed));
+    }
+}
+
+TEST_P(ChunkerScanTest, ZerosAndRepeats) {
+    // Never matches the pattern, so every cut is forced at MAX_CHUNK_SIZE.
+    expect_same_cuts(std::string(300 * 1024 + 3, '\0'));
+    expect_same_cuts(std::string(300 * 1024 + 5, 'a'));
+}
+
+TEST_P(ChunkerScanTest, SmallInputsAndOddTails) {
+    for (size_t size : {size_t(0), size_t(1), dv::Chunker::MIN_CHUNK_SIZE - 1, dv::Chunker::MIN_CHUNK_SIZE,
+                        dv::Chunker::MIN_CHUNK_SIZE + 3, dv::Chunker::AVG_CHUNK_SIZE + 1,
+                        dv::Chunker::MAX_CHUNK_SIZE + 7}) {
+        expect_same_cuts(random_data(size, 99));
+    }
+}
+
+TEST_P(ChunkerScanTest, InsertionFixture) {
+    std::string data = random_data(16 * 1024, 12345);
+    std::string with_insert = data + "...SOME NEW DATA INSERTED HERE..." + random_data(16 * 1024, 12345);
+    expect_same_cuts(data + data);
+    expect_same_cuts(with_insert);
+}
+
+INSTANTIATE_TEST_SUITE_P(AllScanners, ChunkerScanTest,
+                         ::testing::Combine(::testing::Values(dv::ChunkingEngine::Buzhash, dv::ChunkingEngine::FastCdc),
+                                            ::testing::Values(dv::ScanBackend::Auto, dv::ScanBackend::Avx2)));
+
+// --- Parallel scanning must cut in exactly the same places ---
+
+class ChunkerParallelTest : public ::testing::TestWithParam<dv::ChunkingEngine> {
+protected:
+    dv::ThreadPool pool{3};
+
+    void expect_same_cuts(const std::string& data) {
+        dv::Chunker chunker(GetParam());
+        const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+        EXPECT_EQ(chunker.find_boundaries(bytes, data.size(), pool), chunker.find_boundaries(bytes, data.size()));
+    }
+
+    std::string random_data(size_t size, unsigned seed) {
+        std::string data(size, '\0');
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (auto& c : data) c = static_cast<char>(dist(rng));
+        return data;
+    }
+};
+
+TEST_P(ChunkerParallelTest, RandomDataAcrossSegments) {
+    expect_same_cuts(random_data(5 * dv::Chunker::PARALLEL_SEGMENT_SIZE + 4321, 7));
+}
+
+TEST_P(ChunkerParallelTest, ForcedCutsStraddleSeams) {
+    // Runs of zeros force MAX_CHUNK_SIZE cuts that land across segment seams.
+    std::string data = random_data(dv::Chunker::PARALLEL_SEGMENT_SIZE - 5000, 8);
+    data += std::string(dv::Chunker::PARALLEL_SEGMENT_SIZE + 70000, '\0');
+    data += random_data(dv::Chunker::PARALLEL_SEGMENT_SIZE, 9);
+    expect_same_cuts(data);
+}
+
+TEST_P(ChunkerParallelTest, SmallInputs) {
+    for (size_t size : {size_t(0), size_t(1), size_t(63), size_t(64), dv::Chunker::MIN_CHUNK_SIZE,
+                        dv::Chunker::MAX_CHUNK_SIZE + 7}) {
+        expect_same_cuts(random_data(size, 10));
+    }
+}
+
+TEST_P(ChunkerParallelTest, StreamingMatchesSequentialAcrossWindows) {
+    dv::Chunker chunker(GetParam());
+    const std::string data = random_data(dv::Chunker::PARALLEL_WINDOW_SIZE + 3 * dv::Chunker::MAX_CHUNK_SIZE, 11);
+    const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+    const auto expected = chunker.find_boundaries(bytes, data.size());
+
+    std::stringstream stream(data);
+    std::vector<dv::ChunkBoundary> streamed;
+    size_t offset = 0;
+    int batches = 0;
+    chunker.chunk(stream, pool, [&](const std::byte* base, const std::vector<dv::ChunkBoundary>& chunks) {
+        ++batches;
+        for (const auto& chunk : chunks) {
+            // Each batch is relative to its own window; check the bytes too.
+            EXPECT_EQ(std::memcmp(base + chunk.offset, bytes + offset + chunk.offset, chunk.length), 0);
+            streamed.push_back({offset + chunk.offset, chunk.length});
+        }
+        if (!chunks.empty()) offset += chunks.back().offset + chunks.back().length;
+    });
+
+    EXPECT_EQ(batches, 2);
+    EXPECT_EQ(streamed, expected);
+}
+
+TEST_P(ChunkerParallelTest, BufferMatchesStream) {
+    dv::Chunker chunker(GetParam());
+    const std::string data = random_data(2 * dv::Chunker::PARALLEL_WINDOW_SIZE + 12345, 12);
+    const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+
+    auto collect = [](std::vector<dv::ChunkBoundary>& out, size_t& offset) {
+        return [&out, &offset](const std::byte*, const std::vector<dv::ChunkBoundary>& chunks) {
+            for (const auto& chunk : chunks) out.push_back({offset + chunk.offset, chunk.length});
+            if (!chunks.empty()) offset += chunks.back().offset + chunks.back().length;
+        };
+    };
+    std::vector<dv::ChunkBoundary> streamed, buffered;
+    size_t stream_offset = 0, buffer_offset = 0;
+    std::stringstream stream(data);
+    chunker.chunk(stream, pool, collect(streamed, stream_offset));
+    chunker.chunk(bytes, data.size(), pool, [&](const std::byte* base, const std::vector<dv::ChunkBoundary>& chunks) {
+        // Batches point into the caller's buffer rather than a copy.
+        EXPECT_EQ(base, bytes + buffer_offset);
+        collect(buffered, buffer_offset)(base, chunks);
+    });
+
+    EXPECT_EQ(buffered, streamed);
+    EXPECT_EQ(buffered, chunker.find_boundaries(bytes, data.size()));
+}
+
+INSTANTIATE_TEST_SUITE_P(BothEngines, ChunkerParallelTest,
+                         ::testing::Values(dv::ChunkingEngine::Buzhash, dv::ChunkingEngine::FastCdc));
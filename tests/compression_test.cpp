@@ -0,0 +1,84 @@
+// tests/compression_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/Compression.h>
+#include <random>
+#include <string>
+
+namespace {
+
+dv::ByteSpan span_of(const std::string& s) {
+    return dv::ByteSpan(reinterpret_cast<const std::byte*>(s.data()), s.size());
+}
+
+std::string random_bytes(size_t size, unsigned seed) {
+    std::string data(size, '\0');
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (auto& c : data) c = static_cast<char>(dist(rng));
+    return data;
+}
+
+// Compresses and decompresses 'data', expecting it to shrink.
+void expect_round_trip(const std::string& data) {
+    dv::Chunk stored;
+    ASSERT_EQ(dv::compress_chunk(span_of(data), stored), dv::ChunkCodec::Lz);
+    EXPECT_LT(stored.size(), data.size());
+    EXPECT_EQ(dv::raw_size_of(dv::ChunkCodec::Lz, stored), data.size());
+
+    const dv::Chunk raw = dv::decompress_chunk(dv::ChunkCodec::Lz, stored);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(raw.data()), raw.size()), data);
+}
+
+} // anonymous namespace
+
+TEST(CompressionTest, RoundTripsText) {
+    std::string text;
+    for (int i = 0; i < 400; ++i) {
+        text += "2026-10-16 12:00:" + std::to_string(i % 60) + " INFO request " + std::to_string(i * 7919) +
+                " served in " + std::to_string(i % 13) + " ms\n";
+    }
+    expect_round_trip(text);
+}
+
+TEST(CompressionTest, RoundTripsLongRunsAndOverlappingMatches) {
+    expect_round_trip(std::string(32 * 1024, '\0'));
+    expect_round_trip(std::string(100, 'a') + "b" + std::string(5000, 'a'));
+    // A match at offset 3 copies bytes it has only just written.
+    std::string pattern;
+    for (int i = 0; i < 3000; ++i) pattern += "xyz";
+    expect_round_trip(random_bytes(20, 1) + pattern + random_bytes(300, 2));
+}
+
+TEST(CompressionTest, StoresIncompressibleDataRaw) {
+    dv::Chunk stored;
+    EXPECT_EQ(dv::compress_chunk(span_of(random_bytes(32 * 1024, 3)), stored), dv::ChunkCodec::Raw);
+    // Small savings are not worth a decode on every read either.
+    EXPECT_EQ(dv::compress_chunk(span_of(random_bytes(2000, 4) + std::string(40, 'q')), stored), dv::ChunkCodec::Raw);
+    EXPECT_EQ(dv::compress_chunk(span_of("tiny"), stored), dv::ChunkCodec::Raw);
+}
+
+TEST(CompressionTest, RejectsCorruptData) {
+    const std::string data = std::string(1000, 'a') + "end";
+    dv::Chunk stored;
+    ASSERT_EQ(dv::compress_chunk(span_of(data), stored), dv::ChunkCodec::Lz);
+
+    std::vector<std::byte> out(data.size());
+    EXPECT_TRUE(dv::decompress_chunk(dv::ChunkCodec::Lz, stored, out.data(), out.size()));
+    EXPECT_FALSE(dv::decompress_chunk(dv::ChunkCodec::Lz, stored, out.data(), out.size() - 1));
+
+    // Every truncation is caught, as is a match reaching before the start.
+    for (size_t size = 0; size < stored.size(); ++size) {
+        EXPECT_FALSE(dv::decompress_chunk(dv::ChunkCodec::Lz, dv::ByteSpan(stored.data(), size), out.data(), out.size()))
+            << size;
+    }
+    dv::Chunk bad_offset = stored;
+    bad_offset[4] = std::byte{0x04}; // No literals, so the first match has nothing to copy.
+    EXPECT_FALSE(dv::decompress_chunk(dv::ChunkCodec::Lz, bad_offset, out.data(), out.size()));
+    EXPECT_THROW(dv::decompress_chunk(static_cast<dv::ChunkCodec>(7), stored), std::runtime_error);
+}
+
+TEST(CompressionTest, CodecNames) {
+    EXPECT_EQ(dv::parse_chunk_codec(dv::to_string(dv::ChunkCodec::Lz)), dv::ChunkCodec::Lz);
+    EXPECT_EQ(dv::parse_chunk_codec(dv::to_string(dv::ChunkCodec::Raw)), dv::ChunkCodec::Raw);
+    EXPECT_FALSE(dv::parse_chunk_codec("zstd"));
+}
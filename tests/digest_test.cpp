@@ -0,0 +1,47 @@
+// tests/digest_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/Digest.h>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+const std::string HELLO_HEX = "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9";
+}
+
+TEST(DigestTest, HexRoundTrip) {
+    dv::Digest digest = dv::Digest::from_hex(HELLO_HEX);
+    EXPECT_EQ(digest.bytes[0], 0xb9);
+    EXPECT_EQ(digest.bytes[31], 0xe9);
+    EXPECT_EQ(digest.to_hex(), HELLO_HEX);
+}
+
+TEST(DigestTest, ParsesUppercaseHex) {
+    std::string upper = HELLO_HEX;
+    for (auto& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    EXPECT_EQ(dv::Digest::from_hex(upper), dv::Digest::from_hex(HELLO_HEX));
+}
+
+TEST(DigestTest, RejectsMalformedHex) {
+    EXPECT_THROW(dv::Digest::from_hex("abcd"), std::invalid_argument);
+    std::string bad = HELLO_HEX;
+    bad[10] = 'z';
+    EXPECT_THROW(dv::Digest::from_hex(bad), std::invalid_argument);
+}
+
+TEST(DigestTest, StreamsAsHex) {
+    std::ostringstream out;
+    out << dv::Digest::from_hex(HELLO_HEX);
+    EXPECT_EQ(out.str(), HELLO_HEX);
+}
+
+TEST(DigestTest, WorksAsHashSetKey) {
+    dv::Digest a = dv::Digest::from_hex(HELLO_HEX);
+    dv::Digest b = a;
+    b.bytes[31] ^= 1;
+
+    std::unordered_set<dv::Digest> set{a, b, a};
+    EXPECT_EQ(set.size(), 2u);
+    EXPECT_TRUE(a < b || b < a);
+    EXPECT_NE(a, b);
+}
@@ -0,0 +1,143 @@
+// tests/file_scan_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/FileScan.h>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <string>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+class FileScanTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "DupliVaultFileScanTest" / std::to_string(std::time(nullptr));
+        std::filesystem::create_directories(root / "a" / "b");
+        std::ofstream(root / "top.txt") << "top";
+        std::ofstream(root / "a" / "middle.txt") << "middle!";
+        std::ofstream(root / "a" / "b" / "bottom.txt") << "bottom";
+        root = std::filesystem::weakly_canonical(root);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    std::map<std::string, dv::ScannedFile> scan() {
+        std::map<std::string, dv::ScannedFile> files;
+        dv::scan_files(root, [&](dv::ScannedFile&& file) {
+            files[file.relative_path] = std::move(file);
+            return true;
+        });
+        return files;
+    }
+
+    std::filesystem::path root;
+};
+
+TEST_F(FileScanTest, FindsNestedFilesWithTheirStat) {
+    const auto files = scan();
+    ASSERT_EQ(files.size(), 3u);
+    for (const auto& [relative, file] : files) {
+        EXPECT_EQ(file.path, root / std::filesystem::path(relative));
+        EXPECT_EQ(file.stat.size, std::filesystem::file_size(file.path)) << relative;
+    }
+    EXPECT_TRUE(files.count("a/b/bottom.txt"));
+    EXPECT_EQ(files.at("a/middle.txt").stat.size, 7u);
+    EXPECT_NE(files.at("top.txt").stat.inode, files.at("a/middle.txt").stat.inode);
+}
+
+TEST_F(FileScanTest, FreshFilesAreRacy) {
+    for (const auto& [relative, file] : scan()) {
+        EXPECT_TRUE(file.racy) << relative;
+    }
+}
+
+TEST_F(FileScanTest, ReportsDirectoriesAfterTheirEntries) {
+    std::vector<std::string> order;
+    std::map<std::string, dv::ScannedDirectory> dirs;
+    dv::scan_files(
+        root,
+        [&](dv::ScannedFile&& file) {
+            order.push_back(file.relative_path);
+            return true;
+        },
+        [&](dv::ScannedDirectory&& dir) {
+            order.push_back(dir.relative_path + "/");
+            dirs[dir.relative_path] = std::move(dir);
+            return true;
+        });
+#ifdef _WIN32
+    EXPECT_TRUE(dirs.empty());
+#else
+    ASSERT_EQ(order.size(), 6u);
+    EXPECT_EQ(order.back(), "/"); // The root.
+    auto at = [&](const std::string& entry) { return std::find(order.begin(), order.end(), entry) - order.begin(); };
+    EXPECT_LT(at("a/b/bottom.txt"), at("a/b/"));
+    EXPECT_LT(at("a/b/"), at("a/"));
+    EXPECT_LT(at("a/middle.txt"), at("a/"));
+    EXPECT_EQ(dirs.at("a/b").path, root / "a" / "b");
+    EXPECT_NE(dirs.at("a").stat.inode, dirs.at("").stat.inode);
+    EXPECT_TRUE(dirs.at("a").racy); // Created just now.
+#endif
+}
+
+TEST_F(FileScanTest, StopsWhenAsked) {
+    int calls = 0;
+    dv::scan_files(root, [&](dv::ScannedFile&&) { return ++calls < 2; });
+    EXPECT_EQ(calls, 2);
+}
+
+TEST_F(FileScanTest, FollowsSymlinksToFilesButNotToDirectories) {
+    std::error_code error;
+    std::filesystem::create_symlink(root / "top.txt", root / "link.txt", error);
+    if (error) {
+        GTEST_SKIP() << "Symlinks are not available: " << error.message();
+    }
+    std::filesystem::create_directory_symlink(root / "a", root / "link-dir");
+
+    const auto files = scan();
+    ASSERT_TRUE(files.count("link.txt"));
+    EXPECT_EQ(files.at("link.txt").stat.size, 3u);
+    EXPECT_FALSE(files.count("link-dir/middle.txt"));
+    EXPECT_EQ(files.size(), 4u);
+}
+
+#ifndef _WIN32
+TEST_F(FileScanTest, TreatsSymlinksTheSameWithoutATypeFromReaddir) {
+    std::error_code error;
+    std::filesystem::create_symlink(root / "top.txt", root / "link.txt", error);
+    if (error) {
+        GTEST_SKIP() << "Symlinks are not available: " << error.message();
+    }
+    std::filesystem::create_directory_symlink(root / "a", root / "link-dir");
+
+    const int dir = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    ASSERT_GE(dir, 0);
+    // As filesystems that never fill in d_type report every entry.
+    auto kind = [&](const char* name, unsigned char d_type = DT_UNKNOWN) {
+        dv::FileStat stat;
+        return dv::classify_entry(dir, name, d_type, stat);
+    };
+    EXPECT_EQ(kind("top.txt"), dv::EntryKind::File);
+    EXPECT_EQ(kind("a"), dv::EntryKind::Directory);
+    EXPECT_EQ(kind("link.txt"), kind("link.txt", DT_LNK));
+    EXPECT_EQ(kind("link.txt"), dv::EntryKind::File);
+    EXPECT_EQ(kind("link-dir"), kind("link-dir", DT_LNK));
+    EXPECT_EQ(kind("link-dir"), dv::EntryKind::Skip);
+
+    dv::FileStat stat;
+    ASSERT_EQ(dv::classify_entry(dir, "link.txt", DT_UNKNOWN, stat), dv::EntryKind::File);
+    EXPECT_EQ(stat.size, 3u);
+    close(dir);
+}
+#endif
+
+TEST_F(FileScanTest, ThrowsOnAMissingRoot) {
+    EXPECT_THROW(dv::scan_files(root / "missing", [](dv::ScannedFile&&) { return true; }), std::runtime_error);
+}
@@ -0,0 +1,67 @@
+// tests/file_sync_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/FileSync.h>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+class FileSyncTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "DupliVaultFileSyncTest" / std::to_string(std::time(nullptr));
+        std::filesystem::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root.parent_path());
+    }
+
+    static std::string read(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    std::filesystem::path root;
+};
+
+TEST_F(FileSyncTest, WritesAndReplacesFiles) {
+    const auto path = root / "config";
+    dv::write_file_atomically(path, "config", [](std::ostream& out) { out << "first"; });
+    EXPECT_EQ(read(path), "first");
+
+    dv::write_file_atomically(path, "config", [](std::ostream& out) { out << "second"; });
+    EXPECT_EQ(read(path), "second");
+    EXPECT_FALSE(std::filesystem::exists(root / "config.tmp"));
+}
+
+TEST_F(FileSyncTest, FailedWriteLeavesTheOldFile) {
+    const auto path = root / "catalog.bin";
+    dv::write_file_atomically(path, "catalog", [](std::ostream& out) { out << "old"; });
+
+    EXPECT_THROW(dv::write_file_atomically(path, "catalog",
+                                           [](std::ostream& out) {
+                                               out << "half";
+                                               throw std::runtime_error("disk full");
+                                           }),
+                 std::runtime_error);
+    EXPECT_EQ(read(path), "old");
+
+    // A stream that fails is reported too.
+    EXPECT_THROW(dv::write_file_atomically(path, "catalog",
+                                           [](std::ostream& out) { out.setstate(std::ios::badbit); }),
+                 std::runtime_error);
+    EXPECT_EQ(read(path), "old");
+}
+
+TEST_F(FileSyncTest, MissingDirectoryThrows) {
+    EXPECT_THROW(dv::write_file_atomically(root / "missing" / "file", "file", [](std::ostream& out) { out << "x"; }),
+                 std::runtime_error);
+#ifndef _WIN32
+    EXPECT_THROW(dv::sync_file(root / "missing"), std::runtime_error);
+    EXPECT_NO_THROW(dv::sync_directory(root));
+#endif
+}
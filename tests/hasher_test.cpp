@@ -21,7 +21,7 @@ TEST_F(HasherTest, ComputesCorrectHashForEmptyInput) {
     // We expect our Hasher class to produce this exact value.
     std::string expected_hash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
     
-    std::string actual_hash = hasher.compute(empty_data);
+    std::string actual_hash = hasher.compute(empty_data).to_hex();
     
     EXPECT_EQ(actual_hash, expected_hash);
 }
@@ -39,7 +39,82 @@ TEST_F(HasherTest, ComputesCorrectHashForKnownString) {
     // The known SHA-256 hash for "hello world"
     std::string expected_hash = "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9";
 
-    std::string actual_hash = hasher.compute(data);
+    std::string actual_hash = hasher.compute(data).to_hex();
 
     EXPECT_EQ(actual_hash, expected_hash);
-}
\ No newline at end of file
+}
+
+// Test case 3: An incremental stream must agree with the one-shot hash.
+TEST_F(HasherTest, StreamMatchesCompute) {
+    std::vector<std::byte> data(10000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = std::byte(static_cast<unsigned char>(i * 13));
+    }
+
+    auto stream = hasher.begin();
+    stream.update(data.data(), 100);          // partial block
+    stream.update(data.data() + 100, 4000);   // crosses many blocks
+    stream.update(data.data() + 4100, data.size() - 4100);
+
+    EXPECT_EQ(stream.finish(), hasher.compute(data));
+}
+
+
+// --- Every backend must produce the same hashes ---
+class HasherBackendTest : public ::testing::TestWithParam<dv::HashBackend> {
+protected:
+    void SetUp() override {
+        if (!dv::Hasher::is_supported(GetParam())) {
+            GTEST_SKIP() << "Backend not supported on this CPU";
+        }
+    }
+};
+
+TEST_P(HasherBackendTest, MatchesKnownVectors) {
+    dv::Hasher hasher(GetParam());
+    EXPECT_EQ(hasher.compute(std::vector<std::byte>{}).to_hex(),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+    const std::string test_string = "hello world";
+    std::vector<std::byte> data(test_string.size());
+    std::transform(test_string.begin(), test_string.end(), data.begin(), [](char c) {
+        return std::byte(c);
+    });
+    EXPECT_EQ(hasher.compute(data).to_hex(), "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9");
+}
+
+TEST_P(HasherBackendTest, ComputeManyMatchesScalar) {
+    dv::Hasher hasher(GetParam());
+    dv::Hasher reference(dv::HashBackend::Scalar);
+
+    // 19 inputs: two full groups of 8 plus a partial group.
+    std::vector<std::vector<std::byte>> buffers;
+    std::vector<dv::ByteSpan> spans;
+    for (size_t i = 0; i < 19; ++i) {
+        std::vector<std::byte> buffer(i * 997 % 9000);
+        for (size_t j = 0; j < buffer.size(); ++j) {
+            buffer[j] = std::byte(static_cast<unsigned char>(i + j * 7));
+        }
+        buffers.push_back(std::move(buffer));
+    }
+    for (const auto& buffer : buffers) {
+        spans.emplace_back(buffer);
+    }
+
+    auto hashes = hasher.compute_many(spans);
+    ASSERT_EQ(hashes.size(), buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        EXPECT_EQ(hashes[i], reference.compute(buffers[i])) << "input " << i;
+    }
+
+    // Into caller-owned storage, starting partway through the inputs.
+    std::vector<dv::Digest> into(spans.size() - 3);
+    hasher.compute_many(spans.data() + 3, into.size(), into.data());
+    for (size_t i = 0; i < into.size(); ++i) {
+        EXPECT_EQ(into[i], hashes[i + 3]) << "input " << i + 3;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllBackends, HasherBackendTest,
+                         ::testing::Values(dv::HashBackend::Auto, dv::HashBackend::Scalar,
+                                           dv::HashBackend::ShaNi, dv::HashBackend::Avx2));
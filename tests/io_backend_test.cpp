@@ -0,0 +1,89 @@
+// tests/io_backend_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/IoBackend.h>
+#include <ctime>
+#include <string>
+#include <vector>
+
+class IoBackendTest : public ::testing::TestWithParam<dv::IoBackendKind> {
+protected:
+    void SetUp() override {
+        if (GetParam() == dv::IoBackendKind::IoUring && !dv::io_uring_available()) {
+            GTEST_SKIP() << "io_uring is not available here";
+        }
+        dir = std::filesystem::temp_directory_path() / "DupliVaultIoBackendTest" / std::to_string(std::time(nullptr));
+        std::filesystem::create_directories(dir);
+        backend = dv::make_io_backend(GetParam(), 4);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::filesystem::path dir;
+    std::unique_ptr<dv::IoBackend> backend;
+};
+
+TEST_P(IoBackendTest, RunsMoreRequestsThanTheQueueHolds) {
+    constexpr size_t BLOCK = 4096;
+    constexpr size_t BLOCKS = 600;
+    std::vector<std::byte> data(BLOCK * BLOCKS);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<std::byte>((i * 2654435761u) >> 11);
+    }
+
+    // Write the blocks in reverse order, then read them back in order.
+    dv::IoFile out;
+    ASSERT_TRUE(out.create(dir / "file", data.size()));
+    std::vector<dv::IoRequest> writes;
+    for (size_t b = BLOCKS; b-- > 0;) {
+        writes.push_back({dv::IoRequest::Op::Write, &out, b * BLOCK, data.data() + b * BLOCK, BLOCK});
+    }
+    backend->run(writes);
+    for (const auto& write : writes) EXPECT_TRUE(write.ok);
+    ASSERT_TRUE(out.close());
+
+    dv::IoFile in;
+    ASSERT_TRUE(in.open_for_reading(dir / "file"));
+    std::vector<std::byte> read_back(data.size());
+    std::vector<dv::IoRequest> reads;
+    for (size_t b = 0; b < BLOCKS; ++b) {
+        reads.push_back({dv::IoRequest::Op::Read, &in, b * BLOCK, read_back.data() + b * BLOCK, BLOCK});
+    }
+    backend->run(reads);
+    for (const auto& read : reads) EXPECT_TRUE(read.ok);
+    EXPECT_EQ(read_back, data);
+}
+
+TEST_P(IoBackendTest, ReadsPastTheEndFail) {
+    dv::IoFile out;
+    ASSERT_TRUE(out.create(dir / "short", 100));
+    ASSERT_TRUE(out.close());
+
+    dv::IoFile in;
+    ASSERT_TRUE(in.open_for_reading(dir / "short"));
+    std::vector<std::byte> buffer(200);
+    std::vector<dv::IoRequest> reads = {
+        {dv::IoRequest::Op::Read, &in, 0, buffer.data(), 100},
+        {dv::IoRequest::Op::Read, &in, 50, buffer.data(), 100},
+        {dv::IoRequest::Op::Read, &in, 0, buffer.data(), 0},
+    };
+    backend->run(reads);
+    EXPECT_TRUE(reads[0].ok);
+    EXPECT_FALSE(reads[1].ok);
+    EXPECT_TRUE(reads[2].ok);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, IoBackendTest,
+                         ::testing::Values(dv::IoBackendKind::Threads, dv::IoBackendKind::IoUring),
+                         [](const ::testing::TestParamInfo<dv::IoBackendKind>& info) {
+                             return std::string(info.param == dv::IoBackendKind::Threads ? "Threads" : "IoUring");
+                         });
+
+TEST(IoBackendKindTest, ParsesItsNames) {
+    for (auto kind : {dv::IoBackendKind::Auto, dv::IoBackendKind::Threads, dv::IoBackendKind::IoUring}) {
+        EXPECT_EQ(dv::parse_io_backend_kind(dv::to_string(kind)), kind);
+    }
+    EXPECT_FALSE(dv::parse_io_backend_kind("aio").has_value());
+    EXPECT_STREQ(dv::make_io_backend(dv::IoBackendKind::Threads)->name(), "threads");
+}
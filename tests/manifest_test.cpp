@@ -0,0 +1,102 @@
+// tests/manifest_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/Manifest.h>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+dv::Manifest make_manifest(size_t chunks) {
+    dv::Manifest manifest;
+    manifest.original_path = "/home/user/documents/quarterly-report-final.docx";
+    manifest.mod_time_ns = 1717171717123456789;
+    for (size_t i = 0; i < chunks; ++i) {
+        dv::Digest hash;
+        for (size_t b = 0; b < dv::Digest::SIZE; ++b) {
+            hash.bytes[b] = static_cast<uint8_t>(i * 31 + b * 7);
+        }
+        manifest.chunk_hashes.push_back(hash);
+        manifest.chunk_lengths.push_back(static_cast<uint32_t>(2048 + i * 997 % 60000));
+    }
+    return manifest;
+}
+
+} // namespace
+
+TEST(ManifestTest, BinaryRoundTrip) {
+    const auto manifest = make_manifest(100);
+    const auto bytes = manifest.serialize();
+
+    ASSERT_TRUE(dv::ManifestView::is_manifest(bytes));
+    dv::ManifestView view(bytes);
+    EXPECT_EQ(view.original_path(), manifest.original_path);
+    EXPECT_EQ(view.mod_time_ns(), manifest.mod_time_ns);
+    ASSERT_EQ(view.chunk_count(), 100u);
+    EXPECT_EQ(view.chunk_hash(57), manifest.chunk_hashes[57]);
+    EXPECT_TRUE(view.has_lengths());
+
+    const auto copy = view.to_manifest();
+    EXPECT_EQ(copy.chunk_hashes, manifest.chunk_hashes);
+    EXPECT_EQ(copy.chunk_lengths, manifest.chunk_lengths);
+}
+
+TEST(ManifestTest, LengthsAreOptional) {
+    auto manifest = make_manifest(3);
+    manifest.chunk_lengths.clear();
+    const auto bytes = manifest.serialize();
+    dv::ManifestView view(bytes);
+    EXPECT_FALSE(view.has_lengths());
+    EXPECT_TRUE(view.chunk_lengths().empty());
+    EXPECT_EQ(view.to_manifest().chunk_hashes, manifest.chunk_hashes);
+}
+
+TEST(ManifestTest, IsMuchSmallerThanJson) {
+    const auto manifest = make_manifest(1000);
+    const size_t binary = manifest.serialize().size();
+    const size_t json = manifest.to_json().dump(4).size();
+    EXPECT_LT(binary * 5, json * 2) << binary << " bytes vs " << json << " bytes of JSON";
+}
+
+TEST(ManifestTest, JsonRoundTrip) {
+    const auto manifest = make_manifest(10);
+    const auto copy = dv::Manifest::from_json(manifest.to_json());
+    EXPECT_EQ(copy.original_path, manifest.original_path);
+    EXPECT_EQ(copy.mod_time_ns, manifest.mod_time_ns);
+    EXPECT_EQ(copy.chunk_hashes, manifest.chunk_hashes);
+    EXPECT_EQ(copy.chunk_lengths, manifest.chunk_lengths);
+
+    auto json = manifest.to_json();
+    json["chunk_lengths"].erase(0);
+    EXPECT_THROW(dv::Manifest::from_json(json), std::invalid_argument);
+}
+
+TEST(ManifestTest, RejectsDamagedManifests) {
+    const auto bytes = make_manifest(4).serialize();
+
+    auto truncated = bytes;
+    truncated.pop_back();
+    EXPECT_THROW(dv::ManifestView{truncated}, std::runtime_error);
+
+    auto trailing = bytes;
+    trailing.push_back(std::byte{0});
+    EXPECT_THROW(dv::ManifestView{trailing}, std::runtime_error);
+
+    auto future = bytes;
+    future[4] = std::byte{dv::ManifestView::VERSION + 1};
+    EXPECT_THROW(dv::ManifestView{future}, std::runtime_error);
+
+    const std::string json = "{\"chunk_hashes\": []}";
+    std::vector<std::byte> json_bytes(json.size());
+    std::memcpy(json_bytes.data(), json.data(), json.size());
+    EXPECT_FALSE(dv::ManifestView::is_manifest(json_bytes));
+}
+
+TEST(ManifestTest, OffsetsAreRunningSumsOfLengths) {
+    dv::Manifest manifest;
+    manifest.chunk_hashes.resize(3);
+    manifest.chunk_lengths = {100, 50, 7};
+    EXPECT_EQ(manifest.chunk_offsets(), (std::vector<uint64_t>{0, 100, 150, 157}));
+
+    manifest.chunk_lengths.clear();
+    EXPECT_TRUE(manifest.chunk_offsets().empty());
+}
@@ -0,0 +1,55 @@
+// tests/mapped_file_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/MappedFile.h>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = std::filesystem::temp_directory_path() / "DupliVaultMappedFileTest" / std::to_string(std::time(nullptr));
+        std::filesystem::create_directories(root);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(root);
+    }
+
+    std::filesystem::path root;
+};
+
+#ifndef _WIN32
+
+TEST_F(MappedFileTest, MapsTheWholeFile) {
+    const std::string contents(100000, 'x');
+    std::ofstream(root / "file.bin", std::ios::binary) << contents << "end";
+
+    dv::MappedFile mapped;
+    ASSERT_TRUE(mapped.map(root / "file.bin"));
+    ASSERT_EQ(mapped.size(), contents.size() + 3);
+    EXPECT_EQ(std::memcmp(mapped.data(), contents.data(), contents.size()), 0);
+    EXPECT_EQ(std::memcmp(mapped.data() + contents.size(), "end", 3), 0);
+
+    mapped.unmap();
+    EXPECT_EQ(mapped.data(), nullptr);
+    EXPECT_EQ(mapped.size(), 0u);
+}
+
+TEST_F(MappedFileTest, AnEmptyFileMapsToNothing) {
+    std::ofstream(root / "empty.bin");
+
+    dv::MappedFile mapped;
+    EXPECT_TRUE(mapped.map(root / "empty.bin"));
+    EXPECT_EQ(mapped.size(), 0u);
+}
+
+#endif
+
+TEST_F(MappedFileTest, RefusesWhatItCannotMap) {
+    dv::MappedFile mapped;
+    EXPECT_FALSE(mapped.map(root / "missing.bin"));
+    EXPECT_FALSE(mapped.map(root));
+    EXPECT_EQ(mapped.data(), nullptr);
+}
@@ -2,6 +2,9 @@
 #include <gtest/gtest.h>
 #include <duplivault/StorageRepository.h>
 #include "json.hpp" // Our new JSON library
+#include <duplivault/Hasher.h>
+#include <cstring>
+#include <fstream>
 
 class MetadataStorageTest : public ::testing::Test {
 protected:
@@ -28,8 +31,10 @@ TEST_F(MetadataStorageTest, RetrieveNonExistentMetadata) {
 TEST_F(MetadataStorageTest, StoreAndRetrieveMetadata) {
     const std::filesystem::path original_file = "/documents/report.txt";
     nlohmann::json original_metadata;
-    original_metadata["path"] = original_file.string();
-    original_metadata["chunk_hashes"] = {"hash1", "hash2", "hash3"};
+    original_metadata["original_path"] = original_file.string();
+    original_metadata["mod_time_ns"] = 1234567890123456789;
+    original_metadata["chunk_hashes"] = {std::string(64, 'a'), std::string(64, 'b'), std::string(64, 'c')};
+    original_metadata["chunk_lengths"] = {4096, 8192, 100};
 
     // Store the metadata
     repo->store_metadata(original_file, original_metadata);
@@ -39,5 +44,68 @@ TEST_F(MetadataStorageTest, StoreAndRetrieveMetadata) {
     ASSERT_TRUE(retrieved_metadata_opt.has_value());
     
     nlohmann::json retrieved_metadata = retrieved_metadata_opt.value();
-    EXPECT_EQ(original_metadata.dump(), retrieved_metadata.dump());
-}
\ No newline at end of file
+    EXPECT_EQ(original_metadata, retrieved_metadata);
+}
+
+TEST_F(MetadataStorageTest, ManifestsAreFoundThroughTheCatalog) {
+    dv::Manifest manifest;
+    manifest.original_path = "/documents/report.txt";
+    manifest.mod_time_ns = 42;
+    manifest.chunk_hashes = {dv::Digest::from_hex(std::string(64, 'd'))};
+    manifest.chunk_lengths = {5000};
+    const dv::FileStat stat{42, 43, 5000, 1234, 7};
+    repo->store_manifest(manifest.original_path, manifest, stat);
+
+    auto entry = repo->find_file(manifest.original_path);
+    ASSERT_TRUE(entry.has_value());
+    EXPECT_EQ(entry->stat, stat);
+
+    // The catalog and the manifest blob survive reopening.
+    repo.reset();
+    repo = std::make_unique<dv::StorageRepository>(test_repo_path);
+    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "catalog.bin"));
+
+    auto retrieved = repo->retrieve_manifest(manifest.original_path);
+    ASSERT_TRUE(retrieved.has_value());
+    EXPECT_EQ(retrieved->chunk_hashes, manifest.chunk_hashes);
+    EXPECT_EQ(retrieved->chunk_lengths, manifest.chunk_lengths);
+
+    auto all = repo->list_all_manifests();
+    ASSERT_EQ(all.size(), 1u);
+    EXPECT_EQ(all[0].original_path, manifest.original_path);
+}
+
+TEST_F(MetadataStorageTest, ReadsAndReplacesLegacyMetadataFiles) {
+    // Lay out a metadata file the way older versions wrote it: JSON, named
+    // after the hash of the canonical path.
+    const std::filesystem::path original_file = "/documents/old.txt";
+    const std::string canonical = std::filesystem::weakly_canonical(original_file).string();
+    std::vector<std::byte> path_bytes(canonical.size());
+    std::memcpy(path_bytes.data(), canonical.data(), canonical.size());
+    const auto metadata_file = test_repo_path / "metadata" / dv::Hasher().compute(path_bytes).to_hex();
+
+    nlohmann::json legacy;
+    legacy["original_path"] = original_file.string();
+    legacy["mod_time_ns"] = 7;
+    legacy["chunk_hashes"] = {std::string(64, 'e')};
+    std::filesystem::create_directories(metadata_file.parent_path());
+    std::ofstream(metadata_file) << legacy.dump(4);
+    repo = std::make_unique<dv::StorageRepository>(test_repo_path);
+
+    auto manifest = repo->retrieve_manifest(original_file);
+    ASSERT_TRUE(manifest.has_value());
+    EXPECT_EQ(manifest->mod_time_ns, 7);
+    ASSERT_EQ(manifest->chunk_hashes.size(), 1u);
+    EXPECT_EQ(manifest->chunk_hashes[0].to_hex(), std::string(64, 'e'));
+    EXPECT_TRUE(manifest->chunk_lengths.empty());
+    EXPECT_FALSE(repo->find_file(original_file).has_value());
+    EXPECT_EQ(repo->list_all_manifests().size(), 1u);
+
+    // Backing the file up again moves it into the catalog.
+    manifest->mod_time_ns = 8;
+    repo->store_manifest(original_file, *manifest, dv::FileStat{8, 0, 0});
+    repo->flush();
+    EXPECT_FALSE(std::filesystem::exists(metadata_file));
+    ASSERT_EQ(repo->list_all_manifests().size(), 1u);
+    EXPECT_EQ(repo->retrieve_manifest(original_file)->mod_time_ns, 8);
+}
@@ -0,0 +1,75 @@
+// tests/metrics_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/Metrics.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+TEST(HistogramTest, BucketsByPowersOfTwo) {
+    dv::Histogram histogram;
+    EXPECT_EQ(histogram.quantile(0.5), 0u);
+
+    for (uint64_t value : {0, 1, 5, 6, 7, 100}) {
+        histogram.record(value);
+    }
+    histogram.record(4096, 4);
+    EXPECT_EQ(histogram.count(), 10u);
+    EXPECT_EQ(histogram.sum(), 119u + 4 * 4096);
+    EXPECT_EQ(histogram.max(), 4096u);
+
+    // 5, 6 and 7 share the bucket [4, 8); quantiles report its top.
+    EXPECT_EQ(histogram.quantile(0.0), 0u);
+    EXPECT_EQ(histogram.quantile(0.5), 7u);
+    EXPECT_EQ(histogram.quantile(0.6), 127u);
+    EXPECT_EQ(histogram.quantile(1.0), 4096u); // Capped at the largest value seen.
+
+    const auto json = histogram.to_json();
+    EXPECT_EQ(json["count"], 10u);
+    EXPECT_EQ(json["buckets"].size(), 5u);
+    EXPECT_EQ(json["buckets"][2]["le"], 7u);
+    EXPECT_EQ(json["buckets"][2]["count"], 3u);
+}
+
+TEST(HistogramTest, IsSafeToShareBetweenThreads) {
+    dv::Histogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&histogram, t] {
+            for (uint64_t i = 0; i < 10000; ++i) histogram.record(i + t);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(histogram.count(), 40000u);
+    EXPECT_EQ(histogram.max(), 10002u);
+}
+
+TEST(MetricsTest, ReportsCountersRatiosAndTimedStages) {
+    dv::Metrics metrics;
+    metrics.add(dv::Counter::BytesIn, 3000);
+    metrics.add(dv::Counter::NewBytes, 1000);
+    metrics.add(dv::Counter::StoredBytes, 500);
+    metrics.chunk_sizes().record(1000);
+    {
+        dv::StageTimer timer(&metrics, dv::Stage::Hash);
+    }
+    dv::StageTimer batch(&metrics, dv::Stage::Chunk);
+    batch.stop(8);
+    batch.stop(); // Already stopped: nothing more is recorded.
+    dv::StageTimer(&metrics, dv::Stage::Write).cancel();
+    dv::StageTimer(nullptr, dv::Stage::Write);
+
+    const auto report = metrics.to_json();
+    EXPECT_EQ(report["counters"]["bytes_in"], 3000u);
+    EXPECT_EQ(report["counters"]["files_restored"], 0u);
+    EXPECT_DOUBLE_EQ(report["dedup_ratio"].get<double>(), 3.0);
+    EXPECT_DOUBLE_EQ(report["compression_ratio"].get<double>(), 2.0);
+    EXPECT_EQ(report["stages_ns"]["hash"]["count"], 1u);
+    EXPECT_EQ(report["stages_ns"]["chunk"]["count"], 8u);
+    EXPECT_FALSE(report["stages_ns"].contains("write"));
+    EXPECT_EQ(report["chunk_size_bytes"]["max"], 1000u);
+
+    std::ostringstream text;
+    metrics.print(text);
+    EXPECT_NE(text.str().find("dedup_ratio         3.00"), std::string::npos);
+    EXPECT_NE(text.str().find("hash"), std::string::npos);
+}
@@ -0,0 +1,177 @@
+// tests/pack_store_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/PackStore.h>
+#include <fstream>
+
+class PackStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        packs_dir = std::filesystem::temp_directory_path() / "DupliVaultPackTest" / std::to_string(std::time(nullptr));
+        std::filesystem::remove_all(packs_dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(packs_dir.parent_path());
+    }
+
+    static dv::Digest digest_of(int i) {
+        dv::Digest d;
+        d.bytes[0] = static_cast<uint8_t>(i);
+        d.bytes[1] = static_cast<uint8_t>(i >> 8);
+        d.bytes[31] = 0x5a;
+        return d;
+    }
+
+    static dv::Chunk data_of(int i) {
+        return dv::Chunk(1000 + i, static_cast<std::byte>(i));
+    }
+
+    std::filesystem::path packs_dir;
+};
+
+TEST_F(PackStoreTest, RollsOverToNewPacks) {
+    {
+        dv::PackStore store(packs_dir, 10000);
+        for (int i = 0; i < 30; ++i) {
+            store.append(digest_of(i), data_of(i));
+        }
+        EXPECT_EQ(store.size(), 30u);
+        for (int i = 0; i < 30; ++i) {
+            EXPECT_EQ(store.read(*store.find(digest_of(i))), data_of(i));
+        }
+    }
+    EXPECT_TRUE(std::filesystem::exists(dv::PackStore::pack_path(packs_dir, 3)));
+    EXPECT_TRUE(std::filesystem::exists(dv::PackStore::index_path(packs_dir, 3)));
+
+    dv::PackStore reopened(packs_dir, 10000);
+    EXPECT_EQ(reopened.size(), 30u);
+    for (int i = 0; i < 30; ++i) {
+        auto location = reopened.find(digest_of(i));
+        ASSERT_TRUE(location.has_value());
+        EXPECT_EQ(reopened.read(*location), data_of(i));
+    }
+    EXPECT_FALSE(reopened.find(digest_of(99)).has_value());
+}
+
+TEST_F(PackStoreTest, KeepsFillingTheNewestPack) {
+    {
+        dv::PackStore store(packs_dir);
+        store.append(digest_of(1), data_of(1));
+    }
+    {
+        dv::PackStore store(packs_dir);
+        store.append(digest_of(2), data_of(2));
+    }
+    EXPECT_FALSE(std::filesystem::exists(dv::PackStore::pack_path(packs_dir, 2)));
+    dv::PackStore reopened(packs_dir);
+    EXPECT_EQ(reopened.size(), 2u);
+    EXPECT_EQ(reopened.read(*reopened.find(digest_of(2))), data_of(2));
+}
+
+TEST_F(PackStoreTest, RecoversRecordsMissingFromTheIndex) {
+    {
+        dv::PackStore store(packs_dir);
+        store.append(digest_of(1), data_of(1));
+        store.flush();
+        store.append(digest_of(2), data_of(2));
+        store.append(digest_of(3), data_of(3));
+        store.flush();
+    }
+    // Simulate a crash: the index is gone and the last record is torn.
+    std::filesystem::remove(dv::PackStore::index_path(packs_dir, 1));
+    const auto pack = dv::PackStore::pack_path(packs_dir, 1);
+    std::filesystem::resize_file(pack, std::filesystem::file_size(pack) - 10);
+
+    {
+        dv::PackStore store(packs_dir);
+        EXPECT_EQ(store.size(), 2u);
+        EXPECT_FALSE(store.find(digest_of(3)).has_value());
+        // New records go after the last intact one.
+        store.append(digest_of(4), data_of(4));
+    }
+    dv::PackStore reopened(packs_dir);
+    EXPECT_EQ(reopened.size(), 3u);
+    EXPECT_EQ(reopened.read(*reopened.find(digest_of(4))), data_of(4));
+    EXPECT_EQ(reopened.read(*reopened.find(digest_of(2))), data_of(2));
+}
+
+TEST_F(PackStoreTest, ChecksRecordsThatNoIndexCovers) {
+    {
+        dv::PackStore store(packs_dir);
+        for (int i = 1; i <= 4; ++i) {
+            store.append(digest_of(i), data_of(i));
+        }
+    }
+    // Simulate a power loss before any index reached the disk, with the
+    // third record's data lost (the file kept its length).
+    std::filesystem::remove(dv::PackStore::index_path(packs_dir, 1));
+    std::filesystem::remove(packs_dir / "chunk-index.tbl");
+    std::filesystem::remove(packs_dir / "chunk-index.log");
+    const auto pack = dv::PackStore::pack_path(packs_dir, 1);
+    {
+        dv::PackStore store(packs_dir);
+        const auto third = *store.find(digest_of(3));
+        std::fstream file(pack, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(third.offset));
+        const std::string zeros(third.length, '\0');
+        file.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+    std::filesystem::remove(dv::PackStore::index_path(packs_dir, 1));
+    std::filesystem::remove(packs_dir / "chunk-index.tbl");
+    std::filesystem::remove(packs_dir / "chunk-index.log");
+
+    int checked = 0;
+    auto check = [&](const dv::Digest& hash, dv::ByteSpan data, uint32_t) {
+        ++checked;
+        return dv::Chunk(data.data, data.data + data.size) == data_of(hash.bytes[0]);
+    };
+    {
+        dv::PackStore store(packs_dir, dv::PackStore::DEFAULT_TARGET_PACK_SIZE, check);
+        EXPECT_EQ(checked, 3); // The scan stops at the bad record.
+        EXPECT_EQ(store.size(), 2u);
+        EXPECT_FALSE(store.find(digest_of(3)).has_value());
+        EXPECT_FALSE(store.find(digest_of(4)).has_value());
+        store.append(digest_of(5), data_of(5));
+    }
+
+    // Once indexed, records are trusted without being read again.
+    checked = 0;
+    dv::PackStore reopened(packs_dir, dv::PackStore::DEFAULT_TARGET_PACK_SIZE, check);
+    EXPECT_EQ(checked, 0);
+    EXPECT_EQ(reopened.size(), 3u);
+    EXPECT_EQ(reopened.read(*reopened.find(digest_of(5))), data_of(5));
+}
+
+TEST_F(PackStoreTest, RejectsForeignFiles) {
+    std::filesystem::create_directories(packs_dir);
+    std::ofstream(dv::PackStore::pack_path(packs_dir, 1)) << "not a pack";
+    EXPECT_THROW(dv::PackStore store(packs_dir), std::runtime_error);
+}
+
+TEST_F(PackStoreTest, RebuildsAMissingOrStaleChunkIndex) {
+    {
+        dv::PackStore store(packs_dir, 10000);
+        for (int i = 0; i < 20; ++i) {
+            store.append(digest_of(i), data_of(i));
+        }
+    }
+    ASSERT_TRUE(std::filesystem::exists(packs_dir / "chunk-index.tbl"));
+
+    // Missing: rebuilt from the packs.
+    std::filesystem::remove(packs_dir / "chunk-index.tbl");
+    std::filesystem::remove(packs_dir / "chunk-index.log");
+    {
+        dv::PackStore store(packs_dir, 10000);
+        EXPECT_EQ(store.size(), 20u);
+    }
+    EXPECT_TRUE(std::filesystem::exists(packs_dir / "chunk-index.tbl"));
+
+    // Ahead of the data (the newest pack lost its tail): rebuilt as well.
+    const auto newest = dv::PackStore::pack_path(packs_dir, 2);
+    std::filesystem::resize_file(newest, std::filesystem::file_size(newest) - 1);
+    std::filesystem::remove(dv::PackStore::index_path(packs_dir, 2));
+    dv::PackStore store(packs_dir, 10000);
+    EXPECT_EQ(store.size(), 19u);
+    EXPECT_FALSE(store.find(digest_of(19)).has_value());
+    EXPECT_EQ(store.read(*store.find(digest_of(18))), data_of(18));
+}
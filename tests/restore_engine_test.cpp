@@ -0,0 +1,139 @@
+// tests/restore_engine_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/ChunkCache.h>
+#include <duplivault/Hasher.h>
+#include <duplivault/RestoreEngine.h>
+#include <duplivault/StorageRepository.h>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+class RestoreEngineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        world = std::filesystem::temp_directory_path() / "DupliVaultRestoreEngineTest" / std::to_string(std::time(nullptr));
+        std::filesystem::create_directories(world / "out");
+        repo = std::make_unique<dv::StorageRepository>(world / "repo");
+        repo->init();
+    }
+
+    void TearDown() override {
+        repo.reset();
+        std::filesystem::remove_all(world);
+    }
+
+    // Stores 'pieces' as chunks and returns a manifest of them, in order.
+    dv::Manifest store(const std::vector<std::string>& pieces) {
+        dv::Manifest manifest;
+        for (const auto& piece : pieces) {
+            const dv::ByteSpan bytes(reinterpret_cast<const std::byte*>(piece.data()), piece.size());
+            const dv::Digest hash = hasher.compute(bytes.data, bytes.size);
+            if (!repo->chunk_exists(hash)) {
+                repo->store_chunk(hash, bytes);
+            }
+            manifest.chunk_hashes.push_back(hash);
+            manifest.chunk_lengths.push_back(static_cast<uint32_t>(piece.size()));
+        }
+        return manifest;
+    }
+
+    static std::string read(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    dv::Hasher hasher;
+    std::filesystem::path world;
+    std::unique_ptr<dv::StorageRepository> repo;
+};
+
+TEST_F(RestoreEngineTest, RestoresManyFilesSharingChunks) {
+    // More files than one batch holds, reusing chunks across and within
+    // files, with a few empty ones.
+    std::vector<dv::RestoreItem> items;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 300; ++i) {
+        std::vector<std::string> pieces;
+        for (int p = 0; p < i % 5; ++p) {
+            pieces.push_back(std::string(1000 + p * 10, static_cast<char>('a' + p)) + std::to_string(i % 7));
+        }
+        if (i % 5 == 4) pieces.push_back(pieces.front()); // Repeated within the file.
+        std::string content;
+        for (const auto& piece : pieces) content += piece;
+        expected.push_back(content);
+        items.push_back({store(pieces), world / "out" / ("file" + std::to_string(i))});
+    }
+    repo->flush();
+
+    dv::RestoreEngine engine(*repo);
+    EXPECT_EQ(engine.restore(items), items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        ASSERT_EQ(read(items[i].destination), expected[i]) << i;
+    }
+}
+
+TEST_F(RestoreEngineTest, ReadsChunksStillInThePackWriteBuffer) {
+    dv::RestoreItem item{store({"unflushed"}), world / "out" / "file"};
+    EXPECT_EQ(dv::RestoreEngine(*repo).restore({item}), 1u);
+    EXPECT_EQ(read(item.destination), "unflushed");
+}
+
+TEST_F(RestoreEngineTest, DropsOnlyFilesWithMissingChunks) {
+    dv::RestoreItem good{store({"good", "data"}), world / "out" / "good"};
+    dv::RestoreItem bad{store({"bad"}), world / "out" / "bad"};
+    bad.manifest.chunk_hashes.push_back(dv::Digest::from_hex(std::string(64, 'e')));
+    bad.manifest.chunk_lengths.push_back(10);
+
+    EXPECT_EQ(dv::RestoreEngine(*repo).restore({bad, good}), 1u);
+    EXPECT_EQ(read(good.destination), "gooddata");
+    EXPECT_FALSE(std::filesystem::exists(bad.destination));
+}
+
+TEST_F(RestoreEngineTest, DecodesCompressedChunks) {
+    std::string noise(3000, '\0');
+    std::mt19937 rng(5);
+    for (auto& c : noise) c = static_cast<char>(rng());
+    const std::string text(5000, 't');
+    dv::RestoreItem item{store({text, noise, text + "!"}), world / "out" / "mixed"};
+    ASSERT_EQ(repo->locate_chunk(item.manifest.chunk_hashes[0])->codec, dv::ChunkCodec::Lz);
+    ASSERT_EQ(repo->locate_chunk(item.manifest.chunk_hashes[1])->codec, dv::ChunkCodec::Raw);
+
+    // Sizes of compressed chunks come from the manifest.
+    dv::RestoreItem no_lengths{item.manifest, world / "out" / "no_lengths"};
+    no_lengths.manifest.chunk_lengths.clear();
+
+    EXPECT_EQ(dv::RestoreEngine(*repo).restore({no_lengths}), 0u);
+    EXPECT_EQ(dv::RestoreEngine(*repo).restore({item}), 1u);
+    EXPECT_EQ(read(item.destination), text + noise + text + "!");
+    EXPECT_FALSE(std::filesystem::exists(no_lengths.destination));
+}
+
+TEST_F(RestoreEngineTest, LaterItemsWinASharedDestination) {
+    const auto destination = world / "out" / "same";
+    EXPECT_EQ(dv::RestoreEngine(*repo).restore({{store({"first"}), destination}, {store({"second"}), destination}}),
+              1u);
+    EXPECT_EQ(read(destination), "second");
+}
+
+TEST_F(RestoreEngineTest, ServesChunksRepeatedAcrossBatchesFromTheCache) {
+    // Two batches' worth of files sharing one chunk, plus one of their own.
+    std::vector<dv::RestoreItem> items;
+    const std::string shared(4096, '\0');
+    for (size_t i = 0; i < 2 * dv::RestoreEngine::MAX_OPEN_FILES; ++i) {
+        items.push_back({store({shared, "file " + std::to_string(i)}), world / "out" / ("file" + std::to_string(i))});
+    }
+    repo->flush();
+
+    dv::ChunkCache cache(1024 * 1024);
+    EXPECT_EQ(dv::RestoreEngine(*repo, &cache).restore(items), items.size());
+    EXPECT_EQ(read(items.back().destination), shared + "file " + std::to_string(items.size() - 1));
+
+    // The shared chunk is read once; only the second batch finds it cached.
+    // Unique chunks are never looked up, so they are not counted as misses.
+    const auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.bytes, shared.size()); // Unique chunks are not cached.
+}
@@ -45,7 +45,7 @@ protected:
         orchestrator = std::make_unique<dv::BackupOrchestrator>(*chunker, *hasher, *repo);
 
         // 5. CRUCIAL: Run a backup first to populate the repository
-        orchestrator->run_backup(source_dir);
+        first_snapshot = orchestrator->run_backup(source_dir);
     }
 
     void TearDown() override {
@@ -64,6 +64,7 @@ protected:
     std::filesystem::path test_world_path, source_dir, repo_dir, restore_dir;
     std::filesystem::path original_file_path1, original_file_path2;
     std::string original_content1, original_content2;
+    std::string first_snapshot;
 
     std::unique_ptr<dv::StorageRepository> repo;
     std::unique_ptr<dv::Hasher> hasher;
@@ -107,3 +108,35 @@ TEST_F(RestoreTest, RestoresAllFilesCorrectly) {
     ASSERT_TRUE(std::filesystem::exists(restored_file2_path));
     EXPECT_EQ(read_file_content(restored_file2_path), original_content2);
 }
+
+// Test Case 3: Later backups do not overwrite what earlier snapshots hold.
+TEST_F(RestoreTest, RestoresEarlierSnapshots) {
+    std::ofstream(original_file_path2, std::ios::trunc) << "A quick brown fox jumps over the lazy dog.";
+    std::filesystem::create_directories(source_dir / "drafts");
+    std::ofstream(source_dir / "drafts" / "chapter3.txt") << "This is chapter 3.";
+    const std::string second_snapshot = orchestrator->run_backup(source_dir);
+    ASSERT_NE(first_snapshot, second_snapshot);
+
+    auto snapshots = repo->list_snapshots();
+    ASSERT_EQ(snapshots.size(), 2u);
+    EXPECT_EQ(snapshots[0].id, first_snapshot);
+    EXPECT_EQ(snapshots[0].file_count, 2u);
+    EXPECT_EQ(snapshots[1].file_count, 3u);
+
+    // The first snapshot still has the old notes and no drafts.
+    orchestrator->run_restore_snapshot(first_snapshot.substr(0, 8), restore_dir / "first");
+    EXPECT_EQ(read_file_content(restore_dir / "first" / "notes.txt"), original_content2);
+    EXPECT_EQ(read_file_content(restore_dir / "first" / "my_novel.txt"), original_content1);
+    EXPECT_FALSE(std::filesystem::exists(restore_dir / "first" / "drafts"));
+
+    orchestrator->run_restore_snapshot(second_snapshot, restore_dir / "second");
+    EXPECT_EQ(read_file_content(restore_dir / "second" / "notes.txt"), "A quick brown fox jumps over the lazy dog.");
+    EXPECT_EQ(read_file_content(restore_dir / "second" / "drafts" / "chapter3.txt"), "This is chapter 3.");
+
+    // A single file from the older snapshot.
+    orchestrator->run_restore_snapshot(first_snapshot, restore_dir / "one", original_file_path2);
+    EXPECT_EQ(read_file_content(restore_dir / "one" / "notes.txt"), original_content2);
+    EXPECT_FALSE(std::filesystem::exists(restore_dir / "one" / "my_novel.txt"));
+
+    EXPECT_THROW(orchestrator->run_restore_snapshot("not-an-id", restore_dir / "none"), std::runtime_error);
+}
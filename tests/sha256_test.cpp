@@ -1,6 +1,7 @@
 // tests/sha256_test.cpp
 #include <gtest/gtest.h>
 #include "sha256.h" // Our own new header
+#include <cstring>
 
 TEST(SHA256, ComputesCorrectHashForEmptyInput) {
     std::string expected_hash = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
@@ -10,4 +11,112 @@ TEST(SHA256, ComputesCorrectHashForEmptyInput) {
 TEST(SHA256, ComputesCorrectHashForKnownString) {
     std::string expected_hash = "b94d27b9934d3e08a52e52d7da7dabfac484efe37a5380ee9088f7ace2efcde9";
     EXPECT_EQ(sha256("hello world"), expected_hash);
-}
\ No newline at end of file
+}
+
+TEST(SHA256, ComputesCorrectHashForTwoBlockMessage) {
+    // FIPS 180-4 example: 56 bytes, so the padding spills into a second block.
+    std::string expected_hash = "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1";
+    EXPECT_EQ(sha256("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"), expected_hash);
+}
+
+TEST(SHA256, StreamingMatchesOneShotForEverySplit) {
+    std::string input(300, '\0');
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<char>(i * 31 + 7);
+    }
+    const std::string expected = sha256(input);
+
+    // Feed the same message in two pieces at every possible split point,
+    // covering partial, exact and multi-block updates.
+    for (size_t split = 0; split <= input.size(); ++split) {
+        Sha256Context ctx;
+        sha256_init(ctx);
+        sha256_update(ctx, input.data(), split);
+        sha256_update(ctx, input.data() + split, input.size() - split);
+        uint8_t digest[32];
+        sha256_final(ctx, digest);
+
+        Sha256Context reference;
+        sha256_init(reference);
+        sha256_update(reference, input.data(), input.size());
+        uint8_t expected_digest[32];
+        sha256_final(reference, expected_digest);
+
+        ASSERT_EQ(0, std::memcmp(digest, expected_digest, 32)) << "split at " << split;
+    }
+    EXPECT_EQ(expected, sha256(input));
+}
+
+TEST(SHA256, ComputesCorrectHashForMillionAs) {
+    // Streamed 1000 bytes at a time, as the chunker would feed it.
+    const std::string block(1000, 'a');
+    Sha256Context ctx;
+    sha256_init(ctx);
+    for (int i = 0; i < 1000; ++i) {
+        sha256_update(ctx, block.data(), block.size());
+    }
+    uint8_t digest[32];
+    sha256_final(ctx, digest);
+
+    const uint8_t expected[32] = {
+        0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+        0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0
+    };
+    EXPECT_EQ(0, std::memcmp(digest, expected, 32));
+}
+
+// --- Backend cross-checks ---
+// Every block function must agree with the scalar reference on the same
+// vectors, including lengths around the one/two padding-block boundary.
+
+namespace {
+
+std::string hash_with(Sha256CompressFn compress, const std::string& input) {
+    Sha256Context ctx;
+    sha256_init(ctx, compress);
+    sha256_update(ctx, input.data(), input.size());
+    uint8_t digest[32];
+    sha256_final(ctx, digest);
+    return std::string(reinterpret_cast<const char*>(digest), 32);
+}
+
+std::string patterned(size_t size) {
+    std::string s(size, '\0');
+    for (size_t i = 0; i < size; ++i) s[i] = static_cast<char>(i * 131 + (i >> 8));
+    return s;
+}
+
+} // anonymous namespace
+
+TEST(SHA256, ShaNiMatchesScalar) {
+    if (!sha256_cpu_has_shani()) GTEST_SKIP() << "CPU has no SHA extensions";
+    for (size_t size : {0, 1, 55, 56, 63, 64, 65, 119, 120, 1000, 8192, 32768}) {
+        const std::string input = patterned(size);
+        EXPECT_EQ(hash_with(sha256_compress_shani, input), hash_with(sha256_compress_scalar, input)) << size;
+    }
+    EXPECT_EQ(hash_with(sha256_compress_shani, "hello world"), hash_with(sha256_compress_scalar, "hello world"));
+}
+
+TEST(SHA256, Avx2MultiBufferMatchesScalar) {
+    if (!sha256_cpu_has_avx2()) GTEST_SKIP() << "CPU has no AVX2";
+    // Mixed lengths so lanes finish on different steps; count < 8 as well.
+    const size_t sizes[] = {0, 3, 55, 56, 64, 200, 8192, 12345, 1, 32768};
+    for (size_t count : {size_t(1), size_t(5), size_t(8)}) {
+        for (size_t offset = 0; offset + count <= 10; offset += 2) {
+            std::string inputs[8];
+            const uint8_t* data[8];
+            size_t len[8];
+            for (size_t i = 0; i < count; ++i) {
+                inputs[i] = patterned(sizes[offset + i]);
+                data[i] = reinterpret_cast<const uint8_t*>(inputs[i].data());
+                len[i] = inputs[i].size();
+            }
+            uint8_t out[8][32];
+            sha256_x8_avx2(data, len, count, out);
+            for (size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(std::string(reinterpret_cast<const char*>(out[i]), 32),
+                          hash_with(sha256_compress_scalar, inputs[i])) << "lane " << i << " size " << len[i];
+            }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+// tests/snapshot_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/Hasher.h>
+#include <duplivault/Snapshot.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+dv::Digest digest_of(const std::string& text) {
+    return dv::Hasher().compute(reinterpret_cast<const std::byte*>(text.data()), text.size());
+}
+
+// Stores trees in memory, remembering which ones were new.
+struct TreeStore {
+    std::map<dv::Digest, std::vector<std::byte>> blobs;
+    size_t new_trees = 0;
+
+    dv::Digest store(const dv::Tree& tree) {
+        const auto bytes = tree.serialize();
+        const auto ref = dv::Hasher().compute(bytes);
+        if (blobs.emplace(ref, bytes).second) {
+            new_trees++;
+        }
+        return ref;
+    }
+
+    dv::Tree load(const dv::Digest& ref) const {
+        return dv::Tree::parse(blobs.at(ref));
+    }
+};
+
+} // namespace
+
+TEST(SnapshotTest, TreeRoundTrip) {
+    dv::Tree tree;
+    tree.entries.push_back({"docs", dv::TreeEntryType::Directory, digest_of("docs")});
+    tree.entries.push_back({"notes.txt", dv::TreeEntryType::File, digest_of("notes")});
+    const auto parsed = dv::Tree::parse(tree.serialize());
+    ASSERT_EQ(parsed.entries.size(), 2u);
+    EXPECT_EQ(parsed.entries[0].name, "docs");
+    EXPECT_EQ(parsed.entries[0].type, dv::TreeEntryType::Directory);
+    EXPECT_EQ(parsed.entries[1].ref, digest_of("notes"));
+
+    auto truncated = tree.serialize();
+    truncated.pop_back();
+    EXPECT_THROW(dv::Tree::parse(truncated), std::runtime_error);
+}
+
+TEST(SnapshotTest, SnapshotRoundTrip) {
+    dv::Snapshot snapshot;
+    snapshot.time_ns = 1717171717000000000;
+    snapshot.source_path = "/home/user";
+    snapshot.root = digest_of("root");
+    snapshot.file_count = 12345;
+    const auto parsed = dv::Snapshot::parse(snapshot.serialize());
+    EXPECT_EQ(parsed.time_ns, snapshot.time_ns);
+    EXPECT_EQ(parsed.source_path, snapshot.source_path);
+    EXPECT_EQ(parsed.root, snapshot.root);
+    EXPECT_EQ(parsed.file_count, snapshot.file_count);
+
+    EXPECT_THROW(dv::Snapshot::parse(dv::Tree().serialize()), std::runtime_error);
+}
+
+TEST(SnapshotTest, BuildsWalksAndFindsTrees) {
+    TreeStore store;
+    const std::vector<std::pair<std::string, dv::Digest>> files = {
+        {"b/deep/x.txt", digest_of("x")},
+        {"a.txt", digest_of("a")},
+        {"b/y.txt", digest_of("y")},
+        {"c", digest_of("c")},
+    };
+    const auto root = dv::build_trees(files, [&](const dv::Tree& t) { return store.store(t); });
+    EXPECT_EQ(store.new_trees, 3u); // root, b, b/deep
+
+    auto load = [&](const dv::Digest& ref) { return store.load(ref); };
+    std::vector<std::string> walked;
+    dv::walk_trees(root, load, [&](const std::string& path, const dv::Digest&) { walked.push_back(path); });
+    EXPECT_EQ(walked, (std::vector<std::string>{"a.txt", "b/deep/x.txt", "b/y.txt", "c"}));
+
+    EXPECT_EQ(dv::find_in_trees(root, "b/deep/x.txt", load), digest_of("x"));
+    EXPECT_EQ(dv::find_in_trees(root, "c", load), digest_of("c"));
+    EXPECT_FALSE(dv::find_in_trees(root, "b", load).has_value());       // A directory.
+    EXPECT_FALSE(dv::find_in_trees(root, "c/z", load).has_value());     // Under a file.
+    EXPECT_FALSE(dv::find_in_trees(root, "b/nope", load).has_value());
+}
+
+TEST(SnapshotTest, UnchangedSubtreesAreShared) {
+    TreeStore store;
+    auto save = [&](const dv::Tree& t) { return store.store(t); };
+    std::vector<std::pair<std::string, dv::Digest>> files;
+    for (int d = 0; d < 10; ++d) {
+        for (int f = 0; f < 10; ++f) {
+            const std::string path = "dir" + std::to_string(d) + "/sub/file" + std::to_string(f);
+            files.emplace_back(path, digest_of(path));
+        }
+    }
+    const auto first = dv::build_trees(files, save);
+    EXPECT_EQ(store.new_trees, 21u);
+
+    // Change one file: only its directory, its parent and the root are new.
+    files[57].second = digest_of("changed");
+    store.new_trees = 0;
+    const auto second = dv::build_trees(files, save);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(store.new_trees, 3u);
+}
+
+TEST(SnapshotTest, ReusedSubtreesAreNotEncodedAgain) {
+    TreeStore store;
+    std::vector<std::pair<std::string, dv::Digest>> files;
+    for (int d = 0; d < 10; ++d) {
+        for (int f = 0; f < 10; ++f) {
+            const std::string path = "dir" + std::to_string(d) + "/sub/file" + std::to_string(f);
+            files.emplace_back(path, digest_of(path));
+        }
+    }
+    std::map<std::string, std::pair<dv::Digest, uint64_t>> built;
+    auto save = [&](const std::string& path, const dv::Tree& t, uint64_t count) {
+        const auto ref = store.store(t);
+        built[path] = {ref, count};
+        return ref;
+    };
+    const auto first = dv::build_trees(files, {}, save);
+    EXPECT_EQ(built.size(), 21u);
+    EXPECT_EQ(built.at("").second, 100u);
+    EXPECT_EQ(built.at("dir3/sub").second, 10u);
+
+    // Only dir5/sub is given file by file; every other directory is taken
+    // over, so just dir5/sub, dir5 and the root are encoded.
+    std::vector<dv::Subtree> subtrees;
+    for (int d = 0; d < 10; ++d) {
+        if (d == 5) continue;
+        const std::string path = "dir" + std::to_string(d);
+        subtrees.push_back({path, built.at(path).first, built.at(path).second});
+    }
+    std::vector<std::pair<std::string, dv::Digest>> changed(files.begin() + 50, files.begin() + 60);
+    built.clear();
+    EXPECT_EQ(dv::build_trees(changed, subtrees, save), first);
+    EXPECT_EQ(built.size(), 3u);
+    EXPECT_EQ(built.at("").second, 100u);
+}
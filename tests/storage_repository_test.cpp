@@ -1,6 +1,7 @@
 // tests/storage_repository_test.cpp
 #include <gtest/gtest.h>
 #include <duplivault/StorageRepository.h>
+#include <duplivault/Hasher.h>
 #include <fstream>
 
 // This test fixture handles setup and teardown of a temporary repository for each test.
@@ -29,13 +30,118 @@ protected:
 
 TEST_F(StorageRepositoryTest, InitCreatesDirectories) {
     repo->init();
-    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "objects"));
-    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "metadata"));
+    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "packs"));
+}
+
+TEST_F(StorageRepositoryTest, RecordsChunkingEngine) {
+    // A repository without a config file predates engine selection.
+    EXPECT_EQ(repo->chunking_engine(), dv::ChunkingEngine::Buzhash);
+
+    repo->init(dv::ChunkingEngine::FastCdc);
+    EXPECT_EQ(repo->chunking_engine(), dv::ChunkingEngine::FastCdc);
+
+    // Re-initializing with the same engine is fine; switching is not.
+    EXPECT_NO_THROW(repo->init(dv::ChunkingEngine::FastCdc));
+    EXPECT_THROW(repo->init(dv::ChunkingEngine::Buzhash), std::runtime_error);
+}
+
+TEST_F(StorageRepositoryTest, ChunksGoIntoPackFiles) {
+    repo->init();
+    const std::string hex = "0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d";
+    repo->store_chunk(dv::Digest::from_hex(hex), dv::Chunk{std::byte('x')});
+    repo->flush();
+    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "packs" / "pack-000001.pack"));
+    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "packs" / "pack-000001.idx"));
+    EXPECT_FALSE(std::filesystem::exists(test_repo_path / "objects" / "0a" / hex));
+}
+
+TEST_F(StorageRepositoryTest, ChunksSurviveReopening) {
+    repo->init();
+    const auto hash = dv::Digest::from_hex("0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d");
+    const dv::Chunk data = {std::byte('o'), std::byte('k')};
+    repo->store_chunk(hash, data);
+    repo.reset();
+
+    dv::StorageRepository reopened(test_repo_path);
+    EXPECT_TRUE(reopened.chunk_exists(hash));
+    EXPECT_EQ(reopened.retrieve_chunk(hash), data);
+    EXPECT_EQ(reopened.chunk_count(), 1u);
+}
+
+TEST_F(StorageRepositoryTest, DropsChunksTornByACrash) {
+    repo->init();
+    dv::Hasher hasher;
+    const dv::Chunk kept(5000, std::byte{'k'});
+    dv::Chunk torn(5000);
+    for (size_t i = 0; i < torn.size(); ++i) torn[i] = std::byte(static_cast<unsigned char>(i * 131 >> 3));
+    repo->store_chunk(hasher.compute(kept), kept);
+    repo->store_chunk(hasher.compute(torn), torn);
+    const auto location = repo->locate_chunk(hasher.compute(torn));
+    ASSERT_TRUE(location.has_value());
+    repo.reset();
+
+    // A power loss before anything was synced: no index survived, and the
+    // second chunk's bytes never reached the disk.
+    const auto packs = test_repo_path / "packs";
+    std::filesystem::remove(packs / "pack-000001.idx");
+    std::filesystem::remove(packs / "chunk-index.tbl");
+    std::filesystem::remove(packs / "chunk-index.log");
+    {
+        std::fstream file(location->file, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(location->offset));
+        const std::string zeros(location->length, '\0');
+        file.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+
+    dv::StorageRepository reopened(test_repo_path);
+    EXPECT_TRUE(reopened.chunk_exists(hasher.compute(kept)));
+    EXPECT_EQ(reopened.retrieve_chunk(hasher.compute(kept)), kept);
+    // Stored again by the next backup rather than trusted.
+    EXPECT_FALSE(reopened.chunk_exists(hasher.compute(torn)));
+}
+
+TEST_F(StorageRepositoryTest, ReadsAndMigratesLooseObjects) {
+    repo->init();
+
+    // Lay out chunks the way repositories did before pack files.
+    dv::Hasher hasher;
+    std::vector<std::pair<dv::Digest, dv::Chunk>> loose;
+    for (char c : {'a', 'b', 'c'}) {
+        dv::Chunk data(100, std::byte(c));
+        const auto hash = hasher.compute(data);
+        const auto hex = hash.to_hex();
+        std::filesystem::create_directories(test_repo_path / "objects" / hex.substr(0, 2));
+        std::ofstream out(test_repo_path / "objects" / hex.substr(0, 2) / hex, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+        loose.emplace_back(hash, data);
+    }
+    // A loose object whose content has been damaged stays where it is.
+    const std::string bad_hex(64, 'e');
+    std::filesystem::create_directories(test_repo_path / "objects" / "ee");
+    std::ofstream(test_repo_path / "objects" / "ee" / bad_hex) << "damaged";
+
+    // Loose objects are listed when the repository is opened.
+    repo = std::make_unique<dv::StorageRepository>(test_repo_path);
+
+    for (const auto& [hash, data] : loose) {
+        EXPECT_TRUE(repo->chunk_exists(hash));
+        EXPECT_EQ(repo->retrieve_chunk(hash), data);
+    }
+
+    EXPECT_EQ(repo->migrate_loose_objects(), loose.size());
+    EXPECT_TRUE(std::filesystem::exists(test_repo_path / "objects" / "ee" / bad_hex));
+    repo.reset();
+
+    dv::StorageRepository reopened(test_repo_path);
+    for (const auto& [hash, data] : loose) {
+        EXPECT_FALSE(std::filesystem::exists(test_repo_path / "objects" / hash.to_hex().substr(0, 2)));
+        EXPECT_EQ(reopened.retrieve_chunk(hash), data);
+    }
 }
 
 TEST_F(StorageRepositoryTest, StoreAndCheckExists) {
     repo->init();
-    const std::string hash = "0a1b2c3d";
+    const auto hash = dv::Digest::from_hex("0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d");
     const dv::Chunk chunk_data = {std::byte('h'), std::byte('i')};
 
     EXPECT_FALSE(repo->chunk_exists(hash));
@@ -45,7 +151,7 @@ TEST_F(StorageRepositoryTest, StoreAndCheckExists) {
 
 TEST_F(StorageRepositoryTest, StoreAndRetrieve) {
     repo->init();
-    const std::string hash = "0a1b2c3d";
+    const auto hash = dv::Digest::from_hex("0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d0a1b2c3d");
     const dv::Chunk original_data = {std::byte('h'), std::byte('e'), std::byte('l'), std::byte('l'), std::byte('o')};
 
     repo->store_chunk(hash, original_data);
@@ -54,8 +160,77 @@ TEST_F(StorageRepositoryTest, StoreAndRetrieve) {
     EXPECT_EQ(original_data, retrieved_data);
 }
 
+TEST_F(StorageRepositoryTest, CompressibleChunksAreStoredCompressed) {
+    repo->init();
+    const std::string text(8000, 'z');
+    const dv::ByteSpan bytes(reinterpret_cast<const std::byte*>(text.data()), text.size());
+    const dv::Digest hash = dv::Hasher().compute(bytes.data, bytes.size);
+    repo->store_chunk(hash, bytes);
+
+    const auto source = repo->locate_chunk(hash);
+    ASSERT_TRUE(source.has_value());
+    EXPECT_EQ(source->codec, dv::ChunkCodec::Lz);
+    EXPECT_LT(source->length, text.size());
+
+    // Decoded on the way out, also after reopening.
+    const dv::Chunk expected(bytes.data, bytes.data + bytes.size);
+    EXPECT_EQ(repo->retrieve_chunk(hash), expected);
+    repo.reset();
+    repo = std::make_unique<dv::StorageRepository>(test_repo_path);
+    EXPECT_EQ(repo->retrieve_chunk(hash), expected);
+}
+
 TEST_F(StorageRepositoryTest, RetrieveNonExistentThrows) {
     repo->init();
-    const std::string hash = "nonexistenthash";
+    const auto hash = dv::Digest::from_hex("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
     EXPECT_THROW(repo->retrieve_chunk(hash), std::runtime_error);
-}
\ No newline at end of file
+}
+TEST_F(StorageRepositoryTest, FilterAnswersLookupsForNewChunks) {
+    repo->init();
+    dv::Hasher hasher;
+    std::vector<dv::Digest> stored;
+    for (int i = 0; i < 50; ++i) {
+        dv::Chunk data(64, std::byte(i));
+        stored.push_back(hasher.compute(data));
+        repo->store_chunk(stored.back(), data);
+    }
+
+    for (const auto& hash : stored) {
+        EXPECT_TRUE(repo->chunk_exists(hash));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        dv::Chunk data(65, std::byte(i));
+        EXPECT_FALSE(repo->chunk_exists(hasher.compute(data)));
+    }
+
+    const auto stats = repo->filter_stats();
+    EXPECT_EQ(stats.confirmed, stored.size());
+    EXPECT_EQ(stats.definitely_new + stats.false_positives, 1000u);
+    EXPECT_GT(stats.definitely_new, 990u);
+}
+
+TEST_F(StorageRepositoryTest, FilterIsPersistedAndRebuiltWhenStale) {
+    repo->init();
+    dv::Hasher hasher;
+    const dv::Chunk first(100, std::byte('1'));
+    repo->store_chunk(hasher.compute(first), first);
+    repo.reset();
+    ASSERT_TRUE(std::filesystem::exists(test_repo_path / "chunk-filter.bin"));
+    const auto saved_filter = std::filesystem::temp_directory_path() / "DupliVaultStaleFilter.bin";
+    std::filesystem::copy_file(test_repo_path / "chunk-filter.bin", saved_filter,
+                               std::filesystem::copy_options::overwrite_existing);
+
+    // Store a second chunk, then put back the filter from before it.
+    const dv::Chunk second(100, std::byte('2'));
+    {
+        dv::StorageRepository writer(test_repo_path);
+        writer.store_chunk(hasher.compute(second), second);
+    }
+    std::filesystem::copy_file(saved_filter, test_repo_path / "chunk-filter.bin",
+                               std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::remove(saved_filter);
+
+    dv::StorageRepository reopened(test_repo_path);
+    EXPECT_TRUE(reopened.chunk_exists(hasher.compute(first)));
+    EXPECT_TRUE(reopened.chunk_exists(hasher.compute(second)));
+}
@@ -0,0 +1,43 @@
+// tests/thread_pool_test.cpp
+#include <gtest/gtest.h>
+#include <duplivault/ThreadPool.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPoolTest, RunsEveryIndexOnce) {
+    dv::ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(1000);
+    pool.parallel_for(hits.size(), [&](size_t i) { hits[i]++; });
+    for (const auto& h : hits) {
+        EXPECT_EQ(h.load(), 1);
+    }
+}
+
+TEST(ThreadPoolTest, WorksWithoutWorkers) {
+    dv::ThreadPool pool(0);
+    size_t sum = 0;
+    pool.parallel_for(10, [&](size_t i) { sum += i; });
+    EXPECT_EQ(sum, 45u);
+}
+
+TEST(ThreadPoolTest, NestedLoopsDoNotDeadlock) {
+    dv::ThreadPool pool(2);
+    std::atomic<int> total{0};
+    pool.parallel_for(8, [&](size_t) {
+        pool.parallel_for(8, [&](size_t) { total++; });
+    });
+    EXPECT_EQ(total.load(), 64);
+}
+
+TEST(ThreadPoolTest, RethrowsFirstException) {
+    dv::ThreadPool pool(3);
+    EXPECT_THROW(pool.parallel_for(100, [](size_t i) {
+        if (i == 42) throw std::runtime_error("boom");
+    }), std::runtime_error);
+
+    // The pool is still usable afterwards.
+    std::atomic<int> count{0};
+    pool.parallel_for(5, [&](size_t) { count++; });
+    EXPECT_EQ(count.load(), 5);
+}
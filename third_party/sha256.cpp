@@ -1,10 +1,8 @@
 // third_party/sha256.cpp
 #include "sha256.h"
-#include <vector>
 #include <cstdint> // For uint32_t, uint64_t
-#include <sstream> // For stringstream
-#include <iomanip> // For setfill, setw
-#include <algorithm> // For std::copy
+#include <cstring> // For memcpy, memset
+#include <algorithm> // For std::min
 
 // Helper function for 32-bit right rotation (a common bitwise operation)
 constexpr uint32_t rotr(uint32_t x, uint32_t n) {
@@ -37,7 +35,7 @@ constexpr uint32_t sigma1(uint32_t x) {
 }
 
 // K constants - fractional parts of the cube roots of the first 64 primes
-const std::vector<uint32_t> K = {
+const uint32_t sha256_K[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
     0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
     0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
@@ -48,36 +46,18 @@ const std::vector<uint32_t> K = {
     0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-std::string sha256(std::string_view input) {
-    // Initial hash values (H) - fractional parts of the square roots of the first 8 primes
-    std::vector<uint32_t> H = {
-        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
-    };
-
-    // --- Pre-processing (Padding) ---
-    std::vector<uint8_t> msg(input.begin(), input.end());
-    uint64_t original_len_bits = msg.size() * 8;
-    
-    // Append the '1' bit
-    msg.push_back(0x80);
-
-    // Append '0' bits until message length in bits is 448 (mod 512)
-    // which means length in bytes is 56 (mod 64)
-    while (msg.size() % 64 != 56) {
-        msg.push_back(0x00);
-    }
+// Initial hash values (H) - fractional parts of the square roots of the first 8 primes
+const uint32_t sha256_H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
 
-    // Append original length in bits as a 64-bit big-endian integer
-    for (int i = 7; i >= 0; --i) {
-        msg.push_back((original_len_bits >> (i * 8)) & 0xff);
-    }
-    
-    // --- Process the message in successive 64-byte chunks ---
-    for (size_t i = 0; i < msg.size(); i += 64) {
+// Runs the compression function over 'num_blocks' consecutive 64-byte blocks.
+void sha256_compress_scalar(uint32_t H[8], const uint8_t* blocks, size_t num_blocks) {
+    for (size_t i = 0; i < num_blocks; ++i) {
         uint32_t W[64];
-        const uint8_t* chunk = &msg[i];
-        
+        const uint8_t* chunk = blocks + i * 64;
+
         // 1. Create message schedule W
         for (int t = 0; t < 16; ++t) {
             W[t] = (uint32_t)(chunk[t * 4]) << 24 |
@@ -95,7 +75,7 @@ std::string sha256(std::string_view input) {
 
         // 3. Compression function main loop
         for (int t = 0; t < 64; ++t) {
-            uint32_t T1 = h + Sigma1(e) + Ch(e, f, g) + K[t] + W[t];
+            uint32_t T1 = h + Sigma1(e) + Ch(e, f, g) + sha256_K[t] + W[t];
             uint32_t T2 = Sigma0(a) + Maj(a, b, c);
             h = g;
             g = f;
@@ -111,12 +91,90 @@ std::string sha256(std::string_view input) {
         H[0] += a; H[1] += b; H[2] += c; H[3] += d;
         H[4] += e; H[5] += f; H[6] += g; H[7] += h;
     }
+}
+
+Sha256CompressFn sha256_best_compress() {
+    // Resolved once; CPU features cannot change while we run.
+    static const Sha256CompressFn best =
+        sha256_cpu_has_shani() ? sha256_compress_shani : sha256_compress_scalar;
+    return best;
+}
+
+void sha256_init(Sha256Context& ctx, Sha256CompressFn compress) {
+    std::memcpy(ctx.state, sha256_H0, sizeof(sha256_H0));
+    ctx.compress = compress ? compress : sha256_best_compress();
+    ctx.total_len = 0;
+    ctx.buffer_len = 0;
+}
+
+void sha256_update(Sha256Context& ctx, const void* data, size_t len) {
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    ctx.total_len += len;
+
+    // Top up a partial block left over from a previous call first.
+    if (ctx.buffer_len > 0) {
+        size_t take = std::min(len, 64 - ctx.buffer_len);
+        std::memcpy(ctx.buffer + ctx.buffer_len, in, take);
+        ctx.buffer_len += take;
+        in += take;
+        len -= take;
+        if (ctx.buffer_len < 64) {
+            return;
+        }
+        ctx.compress(ctx.state, ctx.buffer, 1);
+        ctx.buffer_len = 0;
+    }
+
+    // Compress every whole block directly from the caller's memory.
+    size_t whole_blocks = len / 64;
+    ctx.compress(ctx.state, in, whole_blocks);
+    in += whole_blocks * 64;
+    len -= whole_blocks * 64;
+
+    // Keep the tail for the next call (or for sha256_final).
+    std::memcpy(ctx.buffer, in, len);
+    ctx.buffer_len = len;
+}
+
+void sha256_final(Sha256Context& ctx, uint8_t out[32]) {
+    // --- Padding ---
+    // Append the '1' bit, then '0' bits until the length in bytes is
+    // 56 (mod 64), then the original length in bits as a 64-bit
+    // big-endian integer. This needs one or two extra blocks.
+    uint64_t original_len_bits = ctx.total_len * 8;
+    ctx.buffer[ctx.buffer_len++] = 0x80;
+    if (ctx.buffer_len > 56) {
+        std::memset(ctx.buffer + ctx.buffer_len, 0, 64 - ctx.buffer_len);
+        ctx.compress(ctx.state, ctx.buffer, 1);
+        ctx.buffer_len = 0;
+    }
+    std::memset(ctx.buffer + ctx.buffer_len, 0, 56 - ctx.buffer_len);
+    for (int i = 0; i < 8; ++i) {
+        ctx.buffer[56 + i] = static_cast<uint8_t>(original_len_bits >> ((7 - i) * 8));
+    }
+    ctx.compress(ctx.state, ctx.buffer, 1);
 
     // --- Produce the final hash value (big-endian) ---
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (uint32_t h_val : H) {
-        ss << std::setw(8) << h_val;
+    for (int i = 0; i < 8; ++i) {
+        out[i * 4]     = static_cast<uint8_t>(ctx.state[i] >> 24);
+        out[i * 4 + 1] = static_cast<uint8_t>(ctx.state[i] >> 16);
+        out[i * 4 + 2] = static_cast<uint8_t>(ctx.state[i] >> 8);
+        out[i * 4 + 3] = static_cast<uint8_t>(ctx.state[i]);
+    }
+}
+
+std::string sha256(std::string_view input) {
+    Sha256Context ctx;
+    sha256_init(ctx);
+    sha256_update(ctx, input.data(), input.size());
+    uint8_t digest[32];
+    sha256_final(ctx, digest);
+
+    static constexpr char hex_digits[] = "0123456789abcdef";
+    std::string hex(64, '0');
+    for (int i = 0; i < 32; ++i) {
+        hex[i * 2] = hex_digits[digest[i] >> 4];
+        hex[i * 2 + 1] = hex_digits[digest[i] & 0x0f];
     }
-    return ss.str();
-}
\ No newline at end of file
+    return hex;
+}
@@ -1,9 +1,60 @@
 // third_party/sha256.h
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
+// Compression function: runs the SHA-256 rounds over 'num_blocks'
+// consecutive 64-byte blocks, updating 'state' in place.
+using Sha256CompressFn = void (*)(uint32_t state[8], const uint8_t* blocks, size_t num_blocks);
+
+// Incremental SHA-256 state. It is a plain struct so it can live on the
+// stack: hashing never copies the input or touches the heap.
+struct Sha256Context {
+    uint32_t state[8];   // The running hash value (H0..H7).
+    uint64_t total_len;  // Number of bytes fed in so far.
+    uint8_t buffer[64];  // A partial block carried over between updates.
+    size_t buffer_len;   // How many bytes of 'buffer' are in use.
+    Sha256CompressFn compress; // The block function (scalar or hardware).
+};
+
+// Resets the context to the FIPS 180-4 initial hash value. If 'compress'
+// is null, the fastest block function this CPU supports is used.
+void sha256_init(Sha256Context& ctx, Sha256CompressFn compress = nullptr);
+
+// Feeds 'len' bytes into the hash. Whole blocks are compressed straight
+// from the caller's buffer; only a trailing partial block is copied.
+void sha256_update(Sha256Context& ctx, const void* data, size_t len);
+
+// Applies the padding and writes the 32-byte big-endian digest to 'out'.
+// The context must be re-initialized before it is used again.
+void sha256_final(Sha256Context& ctx, uint8_t out[32]);
+
 // Declares our globally accessible SHA-256 function.
-// We will define its body in sha256.cpp.
-std::string sha256(std::string_view input);
\ No newline at end of file
+// Returns the hex-encoded digest of 'input'.
+std::string sha256(std::string_view input);
+
+// --- Backends ---
+
+// The FIPS 180-4 round constants and initial hash value, shared by every backend.
+extern const uint32_t sha256_K[64];
+extern const uint32_t sha256_H0[8];
+
+// Portable block function; always available.
+void sha256_compress_scalar(uint32_t state[8], const uint8_t* blocks, size_t num_blocks);
+
+// x86 SHA extensions block function. Only call it if sha256_cpu_has_shani().
+void sha256_compress_shani(uint32_t state[8], const uint8_t* blocks, size_t num_blocks);
+
+// Hashes up to 8 independent messages at once, one per 32-bit AVX2 lane.
+// Messages may differ in length. Only call it if sha256_cpu_has_avx2().
+void sha256_x8_avx2(const uint8_t* const data[], const size_t len[], size_t count, uint8_t out[][32]);
+
+// Runtime CPU feature checks (false on non-x86 builds).
+bool sha256_cpu_has_shani();
+bool sha256_cpu_has_avx2();
+
+// The block function sha256_init() picks when none is given.
+Sha256CompressFn sha256_best_compress();